@@ -0,0 +1,99 @@
+#ifndef BENCH_UTILS_HPP
+#define BENCH_UTILS_HPP
+
+#include "text_format.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace scitool::bench {
+
+    class timer {
+    public:
+        timer() : start(std::chrono::steady_clock::now()) {}
+
+        void restart() {
+            start = std::chrono::steady_clock::now();
+        }
+
+        double seconds() const {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // keeps the compiler from optimizing away a computed value
+    template<typename T>
+    inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const T *volatile sink;
+        sink = &value;
+#endif
+    }
+
+    // median of the running times of repetitions calls of function, in seconds
+    template<typename Function>
+    double median_seconds(size_t repetitions, Function &&function) {
+        std::vector<double> times;
+        for (size_t i = 0; i < std::max<size_t>(repetitions, 1); i++) {
+            timer clock;
+            function();
+            times.push_back(clock.seconds());
+        }
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        return times[times.size() / 2];
+    }
+
+    // One benchmark measurement: string parameters describing the case and numeric metrics.
+    // Records of the same run share the same keys, in the same order, so they can be written as CSV.
+    struct record {
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> parameters;
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    inline std::string format_number(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        return buffer;
+    }
+
+    inline void write_json(std::ostream &out, const std::vector<record> &records) {
+        out << "[\n";
+        for (size_t i = 0; i < records.size(); i++) {
+            out << "  {\"name\": \"" << json_escape(records[i].name) << "\"";
+            for (const auto &parameter : records[i].parameters)
+                out << ", \"" << json_escape(parameter.first) << "\": \"" << json_escape(parameter.second) << "\"";
+            for (const auto &metric : records[i].metrics)
+                out << ", \"" << json_escape(metric.first) << "\": " << format_number(metric.second);
+            out << (i + 1 < records.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    }
+
+    inline void write_csv(std::ostream &out, const std::vector<record> &records) {
+        if (records.empty()) return;
+
+        out << "name";
+        for (const auto &parameter : records.front().parameters) out << "," << parameter.first;
+        for (const auto &metric : records.front().metrics) out << "," << metric.first;
+        out << "\n";
+
+        for (const auto &entry : records) {
+            out << entry.name;
+            for (const auto &parameter : entry.parameters) out << "," << parameter.second;
+            for (const auto &metric : entry.metrics) out << "," << format_number(metric.second);
+            out << "\n";
+        }
+    }
+}
+
+#endif
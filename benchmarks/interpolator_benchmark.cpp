@@ -0,0 +1,215 @@
+#include "interpolator_benchmark.hpp"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace scitool::bench {
+
+    knot_spacing parse_knot_spacing(const std::string &name) {
+        if (name == "uniform") return knot_spacing::uniform;
+        if (name == "chebyshev") return knot_spacing::chebyshev;
+        if (name == "random") return knot_spacing::random;
+        throw std::invalid_argument("Unknown knot spacing: " + name);
+    }
+
+    query_distribution parse_query_distribution(const std::string &name) {
+        if (name == "uniform") return query_distribution::uniform;
+        if (name == "sorted") return query_distribution::sorted;
+        if (name == "clustered") return query_distribution::clustered;
+        throw std::invalid_argument("Unknown query distribution: " + name);
+    }
+
+    std::string to_string(knot_spacing spacing) {
+        switch (spacing) {
+            case knot_spacing::chebyshev: return "chebyshev";
+            case knot_spacing::random: return "random";
+            case knot_spacing::uniform:
+            default: return "uniform";
+        }
+    }
+
+    std::string to_string(query_distribution distribution) {
+        switch (distribution) {
+            case query_distribution::sorted: return "sorted";
+            case query_distribution::clustered: return "clustered";
+            case query_distribution::uniform:
+            default: return "uniform";
+        }
+    }
+
+    namespace {
+        using function_type = double (*)(double);
+
+        const std::vector<std::pair<std::string, function_type>> &functions() {
+            static const std::vector<std::pair<std::string, function_type>> table{
+                    {"sin(x)",  [](double x) { return std::sin(x); }},
+                    {"x^2",     [](double x) { return x * x; }},
+                    {"cos(2x)", [](double x) { return std::cos(2.0 * x); }},
+                    // Runge's function, centered on the interval, where high degree polynomials oscillate
+                    {"runge",   [](double x) { return 1.0 / (1.0 + (x - 25.0) * (x - 25.0) / 25.0); }},
+            };
+            return table;
+        }
+
+        function_type find_function(const std::string &name) {
+            for (const auto &entry : functions())
+                if (entry.first == name) return entry.second;
+            throw std::invalid_argument("Unknown benchmark function: " + name);
+        }
+
+        std::vector<double> make_knots(size_t n, knot_spacing spacing, double start, double end, std::mt19937_64 &rng) {
+            if (n < 2)
+                throw std::invalid_argument("At least two knots are needed for the benchmark");
+
+            std::vector<double> knots(n);
+            double width = end - start;
+            switch (spacing) {
+                case knot_spacing::chebyshev:
+                    // Chebyshev-Lobatto nodes, clustered towards the ends of the interval
+                    for (size_t i = 0; i < n; i++)
+                        knots[i] = start + width * (1.0 - std::cos(M_PI * static_cast<double>(i) / static_cast<double>(n - 1))) / 2.0;
+                    break;
+                case knot_spacing::random: {
+                    std::uniform_real_distribution<double> uniform(start, end);
+                    knots.front() = start;
+                    knots.back() = end;
+                    for (size_t i = 1; i + 1 < n; i++) knots[i] = uniform(rng);
+                    std::sort(knots.begin(), knots.end());
+                    knots.erase(std::unique(knots.begin(), knots.end()), knots.end());
+                    break;
+                }
+                case knot_spacing::uniform:
+                default:
+                    for (size_t i = 0; i < n; i++)
+                        knots[i] = start + width * static_cast<double>(i) / static_cast<double>(n - 1);
+                    knots.back() = end;
+                    break;
+            }
+            return knots;
+        }
+
+        std::vector<double> make_queries(size_t n, query_distribution distribution, double start, double end,
+                                         std::mt19937_64 &rng) {
+            std::vector<double> queries(n);
+            std::uniform_real_distribution<double> uniform(start, end);
+            if (distribution == query_distribution::clustered) {
+                // most queries fall in a narrow window, as when a simulation keeps probing the same region
+                std::normal_distribution<double> normal(start + 0.3 * (end - start), 0.02 * (end - start));
+                for (auto &query : queries) query = std::clamp(normal(rng), start, end);
+            } else {
+                for (auto &query : queries) query = uniform(rng);
+                if (distribution == query_distribution::sorted) std::sort(queries.begin(), queries.end());
+            }
+            return queries;
+        }
+    }
+
+    std::vector<std::string> benchmark_function_names() {
+        std::vector<std::string> names;
+        for (const auto &entry : functions()) names.push_back(entry.first);
+        return names;
+    }
+
+    std::vector<record> run_interpolator_benchmark(const interpolator_benchmark_config &config,
+                                                   const std::vector<interpolator_candidate> &candidates) {
+        std::vector<record> records;
+        std::mt19937_64 rng(config.seed);
+
+        for (const auto &function_name : config.functions) {
+            function_type function = find_function(function_name);
+
+            for (size_t knot_count : config.knot_counts) {
+                for (knot_spacing spacing : config.spacings) {
+                    std::vector<double> x = make_knots(knot_count, spacing, config.start, config.end, rng);
+                    std::vector<double> y(x.size());
+                    std::transform(x.begin(), x.end(), y.begin(), function);
+
+                    for (const auto &candidate : candidates) {
+                        if (x.size() > candidate.max_knots) continue;
+
+                        std::unique_ptr<interpolator> model;
+                        try {
+                            model = candidate.build(x, y);
+                        } catch (const std::invalid_argument &) {
+                            continue;
+                        }
+
+                        double construction = median_seconds(config.repetitions, [&]() {
+                            do_not_optimize(candidate.build(x, y));
+                        });
+
+                        for (query_distribution distribution : config.distributions) {
+                            std::vector<double> queries = make_queries(config.queries, distribution, x.front(), x.back(), rng);
+                            std::vector<double> results(queries.size());
+
+                            double single = median_seconds(config.repetitions, [&]() {
+                                for (size_t i = 0; i < queries.size(); i++) results[i] = (*model)(queries[i]);
+                                do_not_optimize(results.data());
+                            });
+                            double batch = median_seconds(config.repetitions, [&]() {
+                                model->evaluate(queries.data(), results.data(), queries.size());
+                                do_not_optimize(results.data());
+                            });
+
+                            double total_error = 0.0, max_error = 0.0;
+                            for (size_t i = 0; i < queries.size(); i++) {
+                                double error = std::abs(results[i] - function(queries[i]));
+                                total_error += error;
+                                max_error = std::max(max_error, error);
+                            }
+
+                            auto per_query = static_cast<double>(std::max<size_t>(queries.size(), 1));
+                            records.push_back({candidate.name,
+                                               {{"function", function_name},
+                                                {"knots", std::to_string(x.size())},
+                                                {"spacing", to_string(spacing)},
+                                                {"queries", to_string(distribution)}},
+                                               {{"construction_us", construction * 1e6},
+                                                {"query_ns", single * 1e9 / per_query},
+                                                {"batch_ns", batch * 1e9 / per_query},
+                                                {"mae", total_error / per_query},
+                                                {"max_error", max_error}}});
+                        }
+                    }
+                }
+            }
+        }
+
+        return records;
+    }
+
+    std::vector<record> run_model_selection_benchmark(const interpolator_benchmark_config &config, double error_budget,
+                                                      const std::vector<interpolator_candidate> &candidates) {
+        std::vector<record> records;
+        std::mt19937_64 rng(config.seed);
+
+        for (const auto &function_name : config.functions) {
+            function_type function = find_function(function_name);
+
+            for (size_t knot_count : config.knot_counts) {
+                for (knot_spacing spacing : config.spacings) {
+                    std::vector<double> x = make_knots(knot_count, spacing, config.start, config.end, rng);
+                    std::vector<double> y(x.size());
+                    std::transform(x.begin(), x.end(), y.begin(), function);
+
+                    model_selection selection = select_interpolator(x, y, error_budget, candidates);
+                    for (const auto &evaluation : selection.evaluations) {
+                        records.push_back({evaluation.name,
+                                           {{"function", function_name},
+                                            {"knots", std::to_string(x.size())},
+                                            {"spacing", to_string(spacing)},
+                                            {"chosen", evaluation.name == selection.name ? "yes" : "no"}},
+                                           {{"error_budget", error_budget},
+                                            {"meets_budget", selection.meets_budget ? 1.0 : 0.0},
+                                            {"applicable", evaluation.applicable ? 1.0 : 0.0},
+                                            {"mae", evaluation.mean_absolute_error},
+                                            {"max_error", evaluation.max_absolute_error},
+                                            {"query_ns", evaluation.query_nanoseconds}}});
+                    }
+                }
+            }
+        }
+
+        return records;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef INTERPOLATOR_BENCHMARK_HPP
+#define INTERPOLATOR_BENCHMARK_HPP
+
+#include "bench_utils.hpp"
+#include "model_selection.hpp"
+#include <string>
+#include <vector>
+
+namespace scitool::bench {
+
+    // how the knots are placed over the benchmark interval
+    enum class knot_spacing { uniform, chebyshev, random };
+    // how the queries are drawn over the range of the knots
+    enum class query_distribution { uniform, sorted, clustered };
+
+    knot_spacing parse_knot_spacing(const std::string &name);
+    query_distribution parse_query_distribution(const std::string &name);
+    std::string to_string(knot_spacing spacing);
+    std::string to_string(query_distribution distribution);
+
+    // names of the functions sampled by the benchmark ("sin(x)", "x^2", "cos(2x)", "runge")
+    std::vector<std::string> benchmark_function_names();
+
+    struct interpolator_benchmark_config {
+        std::vector<std::string> functions = benchmark_function_names();
+        std::vector<size_t> knot_counts{16, 64, 1024, 65536};
+        std::vector<knot_spacing> spacings{knot_spacing::uniform, knot_spacing::chebyshev, knot_spacing::random};
+        std::vector<query_distribution> distributions{query_distribution::uniform, query_distribution::sorted,
+                                                      query_distribution::clustered};
+        size_t queries = 100000;
+        size_t repetitions = 5;
+        double start = 0.0;
+        double end = 50.0;
+        unsigned seed = 42;
+    };
+
+    // One record per function, interpolator, knot count, spacing and query distribution, with the metrics
+    // construction_us (median construction time), query_ns (median latency of a single call),
+    // batch_ns (median time per value of a batch evaluate call), mae and max_error (against the sampled function).
+    // Candidates that cannot be built on a table (too many knots, non-uniform spacing) are skipped.
+    std::vector<record> run_interpolator_benchmark(const interpolator_benchmark_config &config,
+                                                   const std::vector<interpolator_candidate> &candidates = default_interpolator_candidates());
+
+    // Runs select_interpolator on every function, knot count and spacing of the configuration, recording
+    // the chosen interpolator and, for every candidate, the held-out error and latency it was chosen on
+    std::vector<record> run_model_selection_benchmark(const interpolator_benchmark_config &config, double error_budget,
+                                                      const std::vector<interpolator_candidate> &candidates = default_interpolator_candidates());
+}
+
+#endif
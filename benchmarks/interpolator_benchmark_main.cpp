@@ -0,0 +1,101 @@
+#include "interpolator_benchmark.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    void print_usage() {
+        std::cout << "Usage: interpolator-benchmark [options]\n"
+                     "  --functions sin(x),x^2,cos(2x),runge   sampled functions\n"
+                     "  --knots 16,64,1024,65536                knot counts\n"
+                     "  --spacing uniform,chebyshev,random      knot placements\n"
+                     "  --queries uniform,sorted,clustered      query distributions\n"
+                     "  --query-count N                         queries per measurement (default 100000)\n"
+                     "  --repetitions N                         repetitions per measurement, the median is kept (default 5)\n"
+                     "  --seed N                                seed of the random knots and queries (default 42)\n"
+                     "  --select BUDGET                         pick the fastest interpolator with max error <= BUDGET\n"
+                     "  --format json|csv                       output format (default json)\n"
+                     "  --output FILE                           output file (default standard output)\n";
+    }
+
+    std::vector<std::string> split(const std::string &list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty()) items.push_back(item);
+        return items;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    using namespace scitool::bench;
+
+    interpolator_benchmark_config config;
+    std::string format = "json", output;
+    std::optional<double> error_budget;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                print_usage();
+                return 0;
+            }
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for option " + option);
+
+            std::string value = argv[++i];
+            if (option == "--functions") {
+                config.functions = split(value);
+            } else if (option == "--knots") {
+                config.knot_counts.clear();
+                for (const auto &item : split(value)) config.knot_counts.push_back(std::stoul(item));
+            } else if (option == "--spacing") {
+                config.spacings.clear();
+                for (const auto &item : split(value)) config.spacings.push_back(parse_knot_spacing(item));
+            } else if (option == "--queries") {
+                config.distributions.clear();
+                for (const auto &item : split(value)) config.distributions.push_back(parse_query_distribution(item));
+            } else if (option == "--query-count") {
+                config.queries = std::stoul(value);
+            } else if (option == "--repetitions") {
+                config.repetitions = std::stoul(value);
+            } else if (option == "--seed") {
+                config.seed = static_cast<unsigned>(std::stoul(value));
+            } else if (option == "--select") {
+                error_budget = std::stod(value);
+            } else if (option == "--format") {
+                if (value != "json" && value != "csv")
+                    throw std::invalid_argument("Unknown output format: " + value);
+                format = value;
+            } else if (option == "--output") {
+                output = value;
+            } else {
+                throw std::invalid_argument("Unknown option " + option);
+            }
+        }
+
+        std::vector<record> records = error_budget ? run_model_selection_benchmark(config, *error_budget)
+                                                   : run_interpolator_benchmark(config);
+
+        std::ofstream file;
+        if (!output.empty()) {
+            file.open(output);
+            if (!file.is_open())
+                throw std::runtime_error("Unable to open the output file " + output);
+        }
+        std::ostream &out = output.empty() ? std::cout : file;
+
+        if (format == "csv")
+            write_csv(out, records);
+        else
+            write_json(out, records);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage();
+        return 1;
+    }
+
+    return 0;
+}
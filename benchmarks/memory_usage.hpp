@@ -0,0 +1,70 @@
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Memory measurements of the benchmarks, apart from bench_utils.hpp (which the command line includes too) so that
+// only the benchmarks pull in their system headers
+namespace scitool::bench {
+
+    // Resident memory of the process, in bytes
+    struct memory_usage {
+        size_t current_bytes = 0;
+        // high-water mark since the start of the process, or since reset_peak_memory
+        size_t peak_bytes = 0;
+    };
+
+    inline memory_usage read_memory_usage() {
+        memory_usage usage;
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string key;
+        size_t kilobytes;
+        while (status >> key) {
+            if (key == "VmRSS:" && status >> kilobytes) usage.current_bytes = kilobytes * 1024;
+            else if (key == "VmHWM:" && status >> kilobytes) usage.peak_bytes = kilobytes * 1024;
+        }
+        if (usage.peak_bytes > 0) return usage;
+#endif
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            usage.current_bytes = counters.WorkingSetSize;
+            usage.peak_bytes = counters.PeakWorkingSetSize;
+        }
+#else
+        rusage resources{};
+        getrusage(RUSAGE_SELF, &resources);
+#ifdef __APPLE__
+        usage.peak_bytes = static_cast<size_t>(resources.ru_maxrss);
+#else
+        usage.peak_bytes = static_cast<size_t>(resources.ru_maxrss) * 1024;
+#endif
+#endif
+        return usage;
+    }
+
+    // Lowers the high-water mark to the current resident size (Linux 4.0+), so that the peak of one measurement
+    // can be read. False when it cannot, the peak then being the one of the whole process
+    inline bool reset_peak_memory() {
+#ifdef __linux__
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        return static_cast<bool>(clear_refs << "5") && static_cast<bool>(clear_refs.flush());
+#else
+        return false;
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "statistics_benchmark.hpp"
+#include "dataset.hpp"
+#include "memory_usage.hpp"
+#include <cstdio>
+
+namespace scitool::bench {
+
+    namespace {
+        struct measurement {
+            double seconds = 0.0;
+            double peak_bytes = 0.0;
+            double extra_bytes = 0.0;
+        };
+
+        // median time of the calls of run, prepare being called before each of them outside of the timing
+        template <typename Prepare, typename Run>
+        measurement measure(size_t repetitions, Prepare prepare, Run run) {
+            measurement result;
+            std::vector<double> times;
+            for (size_t i = 0; i < std::max<size_t>(repetitions, 1); i++) {
+                prepare();
+                reset_peak_memory();
+                memory_usage before = read_memory_usage();
+                timer clock;
+                run();
+                times.push_back(clock.seconds());
+                memory_usage after = read_memory_usage();
+                result.peak_bytes = std::max(result.peak_bytes, static_cast<double>(after.peak_bytes));
+                result.extra_bytes = std::max(result.extra_bytes, static_cast<double>(after.peak_bytes) - static_cast<double>(before.current_bytes));
+            }
+            std::nth_element(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(times.size() / 2), times.end());
+            result.seconds = times[times.size() / 2];
+            return result;
+        }
+    }
+
+    std::vector<record> run_statistics_benchmark(const statistics_benchmark_config &config) {
+        std::vector<record> records;
+        auto nothing = []() {};
+
+        for (size_t rows : config.row_counts) {
+            synthetic_data_config data = config.data;
+            data.rows = rows;
+            data.threads = config.threads;
+            std::string path = config.directory + "/statistics-benchmark-" + std::to_string(rows) + ".csv";
+            std::string report_path = config.directory + "/statistics-benchmark-" + std::to_string(rows) + "-report.txt";
+
+            std::vector<std::pair<std::string, std::string>> parameters{
+                    {"rows", std::to_string(rows)},
+                    {"numerical_columns", std::to_string(data.numerical_columns)},
+                    {"categorical_columns", std::to_string(data.categorical_columns)},
+                    {"missing_rate", format_number(data.missing_rate)},
+                    {"cardinality", std::to_string(data.cardinality)}};
+            auto add = [&](const std::string &name, const measurement &result, double processed_bytes) {
+                double seconds = std::max(result.seconds, 1e-12);
+                records.push_back({name, parameters,
+                                   {{"seconds", result.seconds},
+                                    {"rows_per_second", static_cast<double>(rows) / seconds},
+                                    {"mb_per_second", processed_bytes / 1e6 / seconds},
+                                    {"peak_mb", result.peak_bytes / 1e6},
+                                    {"memory_mb", result.extra_bytes / 1e6}}});
+            };
+
+            size_t file_bytes = 0;
+            measurement generated = measure(1, nothing, [&]() { file_bytes = write_synthetic_csv(path, data); });
+            add("generate", generated, static_cast<double>(file_bytes));
+
+            csv_read_options options;
+            options.threads = config.threads;
+            add("from_csv", measure(config.repetitions, nothing, [&]() {
+                do_not_optimize(dataset::from_csv(path, options)->size());
+            }), static_cast<double>(file_bytes));
+
+            auto ds = dataset::from_csv(path, options);
+            std::vector<std::string> numerical = ds->get_numerical_column_names(), categorical;
+            for (const auto &name : ds->get_column_names())
+                if (ds->is_categorical(name)) categorical.push_back(name);
+            auto drop_cache = [&]() { ds->clear_statistics_cache(); };
+            double numerical_bytes = static_cast<double>(rows * numerical.size() * sizeof(double));
+
+            // every getter over every numerical column
+            auto time_getter = [&](const std::string &name, auto getter) {
+                if (numerical.empty()) return;
+                add(name, measure(config.repetitions, drop_cache, [&]() {
+                    for (const auto &column : numerical) do_not_optimize(getter(column));
+                }), numerical_bytes);
+            };
+            time_getter("get_mean", [&](const std::string &column) { return ds->get_mean(column); });
+            time_getter("get_std_dev", [&](const std::string &column) { return ds->get_std_dev(column); });
+            time_getter("get_median", [&](const std::string &column) { return ds->get_median(column); });
+            time_getter("get_variance", [&](const std::string &column) { return ds->get_variance(column); });
+            time_getter("get_quantile", [&](const std::string &column) { return ds->get_quantile(column, 0.9); });
+
+            if (!categorical.empty()) {
+                add("get_frequency_count", measure(config.repetitions, drop_cache, [&]() {
+                    for (const auto &column : categorical) do_not_optimize(ds->get_frequency_count(column).size());
+                }), static_cast<double>(rows * categorical.size() * sizeof(std::uint32_t)));
+            }
+            if (!numerical.empty()) {
+                add("get_correlation_matrix", measure(config.repetitions, drop_cache, [&]() {
+                    do_not_optimize(ds->get_correlation_matrix().sum());
+                }), numerical_bytes);
+
+                // about half of the rows pass, on a fresh copy every time as the rows are removed
+                double median = ds->get_median(numerical.front());
+                std::unique_ptr<dataset> fresh;
+                add("filter_rows", measure(config.repetitions, [&]() { fresh = dataset::from_csv(path, options); }, [&]() {
+                    fresh->filter_rows(numerical.front(), [median](double value) { return value < median; });
+                }), static_cast<double>(rows * sizeof(double)));
+                fresh.reset();
+
+                add("map_column", measure(config.repetitions, nothing, [&]() {
+                    for (const auto &column : numerical) ds->map_column(column, [](double value) { return value + 1.0; });
+                }), numerical_bytes);
+            }
+
+            add("output_statistics", measure(config.repetitions, drop_cache, [&]() { ds->output_statistics(report_path); }),
+                static_cast<double>(rows * ds->get_column_names().size() * sizeof(double)));
+
+            std::remove(report_path.c_str());
+            if (!config.keep_files) std::remove(path.c_str());
+        }
+
+        return records;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef STATISTICS_BENCHMARK_HPP
+#define STATISTICS_BENCHMARK_HPP
+
+#include "bench_utils.hpp"
+#include "synthetic_data.hpp"
+#include <string>
+#include <vector>
+
+namespace scitool::bench {
+
+    struct statistics_benchmark_config {
+        // rows of the generated files, one run per count
+        std::vector<size_t> row_counts{1000, 100000, 1000000};
+        // shape of the generated files, their rows being set from row_counts
+        synthetic_data_config data;
+        size_t repetitions = 5;
+        // where the generated files are written, they are deleted after their run unless keep_files
+        std::string directory = ".";
+        bool keep_files = false;
+        // threads of the generator and of from_csv, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    // One record per row count and operation: generate (writing the synthetic file), from_csv, get_mean,
+    // get_std_dev, get_median, get_variance, get_quantile (q = 0.9), get_frequency_count and map_column (every
+    // column of the kind), get_correlation_matrix, filter_rows (about half the rows) and output_statistics.
+    // The metrics are seconds (median of the repetitions, the cached statistics being dropped before each one),
+    // rows_per_second, mb_per_second (bytes of the file for generate and from_csv, of the values read otherwise),
+    // peak_mb (resident high-water mark of the process during the operation) and memory_mb (that peak minus the
+    // resident size before the operation, the largest over the repetitions)
+    std::vector<record> run_statistics_benchmark(const statistics_benchmark_config &config);
+}
+
+#endif
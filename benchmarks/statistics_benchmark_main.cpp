@@ -0,0 +1,118 @@
+#include "statistics_benchmark.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    void print_usage() {
+        std::cout << "Usage: statistics-benchmark [options]\n"
+                     "  --rows 1000,100000,1000000              rows of the generated files, one run per count\n"
+                     "  --numerical N                           numerical columns (default 9, those of housing.csv first)\n"
+                     "  --categorical N                         categorical columns (default 1, ocean_proximity first)\n"
+                     "  --missing-rate R                        probability of a cell to be empty (default 0.01)\n"
+                     "  --cardinality N                         distinct values of the categorical columns (default 5)\n"
+                     "  --seed N                                seed of the generated data (default 42)\n"
+                     "  --repetitions N                         repetitions per measurement, the median is kept (default 5)\n"
+                     "  --threads N                             threads of the generator and of from_csv (default all)\n"
+                     "  --directory DIR                         where the generated files are written (default .)\n"
+                     "  --keep-files                            keep the generated files\n"
+                     "  --generate FILE                         only write a synthetic file of the first --rows count\n"
+                     "  --format json|csv                       output format (default json)\n"
+                     "  --output FILE                           output file (default standard output)\n";
+    }
+
+    std::vector<std::string> split(const std::string &list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty()) items.push_back(item);
+        return items;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    using namespace scitool::bench;
+
+    statistics_benchmark_config config;
+    std::string format = "json", output, generate;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                print_usage();
+                return 0;
+            }
+            if (option == "--keep-files") {
+                config.keep_files = true;
+                continue;
+            }
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for option " + option);
+
+            std::string value = argv[++i];
+            if (option == "--rows") {
+                config.row_counts.clear();
+                for (const auto &item : split(value)) config.row_counts.push_back(std::stoul(item));
+            } else if (option == "--numerical") {
+                config.data.numerical_columns = std::stoul(value);
+            } else if (option == "--categorical") {
+                config.data.categorical_columns = std::stoul(value);
+            } else if (option == "--missing-rate") {
+                config.data.missing_rate = std::stod(value);
+            } else if (option == "--cardinality") {
+                config.data.cardinality = std::stoul(value);
+            } else if (option == "--seed") {
+                config.data.seed = std::stoull(value);
+            } else if (option == "--repetitions") {
+                config.repetitions = std::stoul(value);
+            } else if (option == "--threads") {
+                config.threads = std::stoul(value);
+            } else if (option == "--directory") {
+                config.directory = value;
+            } else if (option == "--generate") {
+                generate = value;
+            } else if (option == "--format") {
+                if (value != "json" && value != "csv")
+                    throw std::invalid_argument("Unknown output format: " + value);
+                format = value;
+            } else if (option == "--output") {
+                output = value;
+            } else {
+                throw std::invalid_argument("Unknown option " + option);
+            }
+        }
+
+        if (!generate.empty()) {
+            if (config.row_counts.empty())
+                throw std::invalid_argument("The option --rows is needed to generate a file");
+            synthetic_data_config data = config.data;
+            data.rows = config.row_counts.front();
+            data.threads = config.threads;
+            write_synthetic_csv(generate, data);
+            return 0;
+        }
+
+        std::vector<record> records = run_statistics_benchmark(config);
+
+        std::ofstream file;
+        if (!output.empty()) {
+            file.open(output);
+            if (!file.is_open())
+                throw std::runtime_error("Unable to open the output file " + output);
+        }
+        std::ostream &out = output.empty() ? std::cout : file;
+
+        if (format == "csv")
+            write_csv(out, records);
+        else
+            write_json(out, records);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage();
+        return 1;
+    }
+
+    return 0;
+}
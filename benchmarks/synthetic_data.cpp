@@ -0,0 +1,149 @@
+#include "synthetic_data.hpp"
+#include "parallel.hpp"
+#include "random.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+namespace scitool::bench {
+
+    namespace {
+        // rows generated from one seed, by one thread
+        constexpr size_t block_rows = 16384;
+
+        const char *const housing_columns[] = {"longitude", "latitude", "housing_median_age", "total_rooms", "total_bedrooms",
+                                               "population", "households", "median_income", "median_house_value"};
+        // decimals written for each of them, as in housing.csv (41.0, 8.3252...)
+        const int housing_decimals[] = {2, 2, 1, 1, 1, 1, 1, 4, 1};
+        constexpr size_t housing_count = sizeof(housing_columns) / sizeof(housing_columns[0]);
+
+        const char *const ocean_proximity[] = {"<1H OCEAN", "INLAND", "NEAR OCEAN", "NEAR BAY", "ISLAND"};
+        // their frequencies in housing.csv
+        const double ocean_proximity_weights[] = {9136, 6551, 2658, 2290, 5};
+
+        void append_number(std::string &text, double value, int decimals) {
+            char buffer[64];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, decimals);
+            text.append(buffer, result.ptr);
+        }
+
+        // the nine numerical values of a row of housing.csv
+        void housing_row(std::mt19937_64 &rng, double *values) {
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            std::normal_distribution<double> normal(0.0, 1.0);
+            values[0] = -124.35 + 10.04 * unit(rng);
+            values[1] = 32.54 + 9.41 * unit(rng);
+            values[2] = std::min(52.0, std::floor(1.0 + 52.0 * unit(rng)));
+            values[3] = std::clamp(std::round(std::exp(7.6 + 0.75 * normal(rng))), 2.0, 39320.0);
+            // bedrooms, population and households follow the rooms, which makes the correlation matrix realistic
+            values[4] = std::max(1.0, std::round(values[3] * (0.15 + 0.1 * unit(rng))));
+            values[5] = std::max(3.0, std::round(values[3] * (0.35 + 0.4 * unit(rng))));
+            values[6] = std::max(1.0, std::round(values[5] / (2.5 + unit(rng))));
+            values[7] = std::clamp(std::exp(1.25 + 0.45 * normal(rng)), 0.4999, 15.0001);
+            values[8] = std::clamp(std::round(45000.0 * values[7] + 30000.0 + 60000.0 * normal(rng)), 14999.0, 500001.0);
+        }
+
+        // the values of a categorical column and their cumulative weights
+        struct category_values {
+            std::vector<std::string> names;
+            std::vector<double> cumulative;
+
+            const std::string &draw(std::mt19937_64 &rng) const {
+                double u = std::uniform_real_distribution<double>(0.0, cumulative.back())(rng);
+                auto at = std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+                return names[std::min<size_t>(static_cast<size_t>(at), names.size() - 1)];
+            }
+        };
+
+        // ocean_proximity as in housing.csv when it has its five values, Zipf-distributed values otherwise
+        category_values make_categories(size_t column, size_t cardinality) {
+            category_values values;
+            double total = 0.0;
+            for (size_t k = 0; k < cardinality; k++) {
+                bool real = column == 0 && cardinality == 5;
+                values.names.push_back(real ? ocean_proximity[k] : (column == 0 ? "ZONE " : "v") + std::to_string(k + 1));
+                total += real ? ocean_proximity_weights[k] : 1.0 / static_cast<double>(k + 1);
+                values.cumulative.push_back(total);
+            }
+            return values;
+        }
+
+        std::string generate_block(const synthetic_data_config &config, const std::vector<category_values> &categories, size_t block) {
+            // full splitmix64 steps (increment, then finalizer), so that the seeds of the blocks are unrelated
+            std::uint64_t block_key = splitmix64(block + 1 + golden_gamma);
+            std::mt19937_64 rng(splitmix64((config.seed ^ block_key) + golden_gamma));
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            std::normal_distribution<double> normal(100.0, 15.0);
+            size_t first = block * block_rows, count = std::min(block_rows, config.rows - first);
+
+            std::string text;
+            text.reserve(count * (10 * config.numerical_columns + 12 * config.categorical_columns + 1));
+            double housing[housing_count];
+            for (size_t row = 0; row < count; row++) {
+                housing_row(rng, housing);
+                for (size_t col = 0; col < config.numerical_columns; col++) {
+                    if (col > 0) text += ',';
+                    double value = col < housing_count ? housing[col] : normal(rng);
+                    if (unit(rng) >= config.missing_rate) append_number(text, value, col < housing_count ? housing_decimals[col] : 3);
+                }
+                for (size_t col = 0; col < categories.size(); col++) {
+                    if (col > 0 || config.numerical_columns > 0) text += ',';
+                    const std::string &value = categories[col].draw(rng);
+                    if (unit(rng) >= config.missing_rate) text += value;
+                }
+                text += '\n';
+            }
+            return text;
+        }
+    }
+
+    std::vector<std::string> synthetic_column_names(const synthetic_data_config &config) {
+        std::vector<std::string> names;
+        for (size_t col = 0; col < config.numerical_columns; col++) {
+            names.push_back(col < housing_count ? housing_columns[col] : "value_" + std::to_string(col + 1));
+        }
+        for (size_t col = 0; col < config.categorical_columns; col++) {
+            names.push_back(col == 0 ? "ocean_proximity" : "category_" + std::to_string(col + 1));
+        }
+        return names;
+    }
+
+    size_t write_synthetic_csv(const std::string &path, const synthetic_data_config &config) {
+        if (config.numerical_columns + config.categorical_columns == 0)
+            throw std::invalid_argument("The synthetic data needs at least one column");
+        if (config.categorical_columns > 0 && config.cardinality == 0)
+            throw std::invalid_argument("The categorical columns need at least one value");
+        if (config.missing_rate < 0.0 || config.missing_rate > 1.0)
+            throw std::invalid_argument("The missing rate must be between 0 and 1");
+
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(std::fopen(path.c_str(), "wb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("Unable to open the output file " + path);
+
+        std::vector<category_values> categories;
+        for (size_t col = 0; col < config.categorical_columns; col++) categories.push_back(make_categories(col, config.cardinality));
+
+        std::string header;
+        for (const auto &name : synthetic_column_names(config)) header += (header.empty() ? "" : ",") + name;
+        header += '\n';
+        size_t written = std::fwrite(header.data(), 1, header.size(), file.get());
+
+        // a few blocks per thread at a time, written in order, so the memory does not grow with the rows
+        size_t threads = config.threads == 0 ? default_thread_count() : config.threads;
+        size_t blocks = (config.rows + block_rows - 1) / block_rows;
+        std::vector<std::string> texts;
+        for (size_t first = 0; first < blocks; first += 4 * threads) {
+            texts.assign(std::min(4 * threads, blocks - first), std::string());
+            parallel_for(texts.size(), [&](size_t i) { texts[i] = generate_block(config, categories, first + i); }, threads);
+            for (const auto &text : texts) written += std::fwrite(text.data(), 1, text.size(), file.get());
+        }
+
+        if (std::fflush(file.get()) != 0 || std::ferror(file.get()))
+            throw std::runtime_error("Unable to write the output file " + path);
+        return written;
+    }
+}
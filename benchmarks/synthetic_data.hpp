@@ -0,0 +1,36 @@
+#ifndef SYNTHETIC_DATA_HPP
+#define SYNTHETIC_DATA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace scitool::bench {
+
+    // Shape of a synthetic CSV file modelled on housing.csv: its nine numerical columns (longitude, latitude,
+    // housing_median_age, total_rooms, ...) drawn from distributions close to the real ones, total_bedrooms,
+    // population and households following total_rooms as in the real data, then value_10, value_11, ... for
+    // more numerical columns. The categorical columns are ocean_proximity and then category_2, category_3, ...,
+    // their values skewed towards the first ones as in ocean_proximity
+    struct synthetic_data_config {
+        size_t rows = 100000;
+        size_t numerical_columns = 9;
+        size_t categorical_columns = 1;
+        // probability of every cell to be empty
+        double missing_rate = 0.01;
+        // distinct values of every categorical column
+        size_t cardinality = 5;
+        std::uint64_t seed = 42;
+        // threads formatting the rows, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    std::vector<std::string> synthetic_column_names(const synthetic_data_config &config);
+
+    // Writes the file (header and config.rows lines). Blocks of rows are generated in parallel, each from its own
+    // seed, so the file depends on the configuration but not on the number of threads. Returns the bytes written
+    size_t write_synthetic_csv(const std::string &path, const synthetic_data_config &config);
+}
+
+#endif
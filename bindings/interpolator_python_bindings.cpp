@@ -1,9 +1,13 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+#include "profiling_bindings.hpp"
 #include "interpolator.hpp"
 #include "linear_interpolator.hpp"
 #include "polynomial_interpolator.hpp"
 #include "cardinal_cubic_bspline_Interpolator.hpp"
+#include "chebyshev_interpolator.hpp"
+#include "scattered_interpolator.hpp"
 
 namespace py = pybind11;
 
@@ -11,11 +15,57 @@ class py_interpolator : public scitool::interpolator {
 public:
     using interpolator::interpolator; // Inherit constructors
 
+    // Python subclasses implement __call__, which is what the C++ code has to dispatch to
     virtual double operator()(double x_val) const override {
-        PYBIND11_OVERRIDE_PURE(double, interpolator, operator(), x_val);
+        PYBIND11_OVERRIDE_PURE_NAME(double, interpolator, "__call__", operator(), x_val);
+    }
+
+    virtual double derivative(double x_val, int order) const override {
+        PYBIND11_OVERRIDE(double, interpolator, derivative, x_val, order);
+    }
+
+    virtual double integrate(double a, double b) const override {
+        PYBIND11_OVERRIDE(double, interpolator, integrate, a, b);
     }
 };
 
+// float64 arrays in C order; anything else (lists, other dtypes) is converted once by pybind11
+using numpy_array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// the knots are copied straight from the array buffers into the interpolator, without
+// creating a Point object per sample, and the GIL is released while the tables are built
+template<typename Interpolator>
+Interpolator *from_arrays(const numpy_array &x, const numpy_array &y) {
+    if (x.ndim() != 1 || y.ndim() != 1)
+        throw std::invalid_argument("\"x\" and \"y\" must be one-dimensional arrays");
+    if (x.size() != y.size())
+        throw std::invalid_argument("\"x\" and \"y\" must have the same size");
+
+    py::gil_scoped_release release;
+    return new Interpolator(x.data(), y.data(), static_cast<size_t>(x.size()));
+}
+
+template<typename Interpolator>
+py::array_t<double> evaluate_array(const Interpolator &self, const numpy_array &x) {
+    py::array_t<double> result(std::vector<py::ssize_t>(x.shape(), x.shape() + x.ndim()));
+    const double *input = x.data();
+    double *output = result.mutable_data();
+    auto n = static_cast<size_t>(x.size());
+
+    {
+        py::gil_scoped_release release;
+        self.evaluate(input, output, n);
+    }
+    return result;
+}
+
+// read-only array over the knots of an interpolator, which is kept alive by the array
+py::array_t<double> knots_view(const scitool::table_array<double> &knots, py::handle owner) {
+    py::array_t<double> view(static_cast<py::ssize_t>(knots.size()), knots.data(), owner);
+    py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return view;
+}
+
 PYBIND11_MODULE(interpolator_py, m) {
     py::class_<scitool::point>(m, "Point")
     .def(py::init<double, double>())
@@ -26,20 +76,113 @@ PYBIND11_MODULE(interpolator_py, m) {
     // So I created a wrapper class and used PYBIND11_OVERRIDE_PURE
     py::class_<py_interpolator>(m, "Interpolator")
             .def(py::init<const std::vector<scitool::point>&>())
-            .def_property_readonly("points", &scitool::interpolator::get_points);
+            .def("derivative", &scitool::interpolator::derivative, py::arg("x"), py::arg("order") = 1, py::call_guard<py::gil_scoped_release>())
+            .def("integrate", &scitool::interpolator::integrate, py::arg("a"), py::arg("b"), py::call_guard<py::gil_scoped_release>())
+            .def_property_readonly("points", &scitool::interpolator::get_points)
+            .def_property_readonly("x", [](py::object self) {
+                return knots_view(self.cast<const scitool::interpolator &>().get_x(), self);
+            })
+            .def_property_readonly("y", [](py::object self) {
+                return knots_view(self.cast<const scitool::interpolator &>().get_y(), self);
+            });
 
+    // The long-running native calls release the GIL, so that Python threads can use different
+    // interpolators (or the same one, they are immutable once built) in parallel. Calls on
+    // single values keep it, releasing it would cost more than the interpolation itself
     py::class_<scitool::interpolator>(m, "CInterpolator")
-            .def_property_readonly("points", &scitool::interpolator::get_points);
+            .def("derivative", &scitool::interpolator::derivative, py::arg("x"), py::arg("order") = 1, py::call_guard<py::gil_scoped_release>(),
+                 "Derivative of the given order of the interpolant at x.")
+            .def("integrate", &scitool::interpolator::integrate, py::arg("a"), py::arg("b"), py::call_guard<py::gil_scoped_release>(),
+                 "Definite integral of the interpolant between a and b.")
+            .def_property_readonly("points", &scitool::interpolator::get_points)
+            .def_property_readonly("x", [](py::object self) {
+                return knots_view(self.cast<const scitool::interpolator &>().get_x(), self);
+            }, "Sorted x values of the knots, as a read-only array sharing the interpolator memory.")
+            .def_property_readonly("y", [](py::object self) {
+                return knots_view(self.cast<const scitool::interpolator &>().get_y(), self);
+            }, "y values of the knots, as a read-only array sharing the interpolator memory.")
+            .def("save", &scitool::interpolator::save, py::arg("path"), py::call_guard<py::gil_scoped_release>(),
+                 "Writes the knots and precomputed coefficients to a file that load_interpolator maps back.")
+            .def("__len__", &scitool::interpolator::size);
+
+    m.def("load_interpolator", &scitool::load_interpolator, py::arg("path"), py::call_guard<py::gil_scoped_release>(),
+          "Maps an interpolator saved with save() and uses its tables in place, without rebuilding it.");
 
     py::class_<scitool::linear_interpolator, scitool::interpolator>(m, "LinearInterpolator")
-    .def(py::init<const std::vector<scitool::point>&>())
-    .def("__call__", &scitool::linear_interpolator::operator());
+    .def(py::init<const std::vector<scitool::point>&>(), py::call_guard<py::gil_scoped_release>())
+    .def(py::init(&from_arrays<scitool::linear_interpolator>), py::arg("x"), py::arg("y"))
+    .def("__call__", &scitool::linear_interpolator::operator())
+    .def("__call__", &evaluate_array<scitool::linear_interpolator>, "Interpolates every element of an array.");
 
     py::class_<scitool::polynomial_interpolator, scitool::interpolator>(m, "PolynomialInterpolator")
-    .def(py::init<const std::vector<scitool::point>&>())
-    .def("__call__", &scitool::polynomial_interpolator::operator());
+    .def(py::init<const std::vector<scitool::point>&>(), py::call_guard<py::gil_scoped_release>())
+    .def(py::init(&from_arrays<scitool::polynomial_interpolator>), py::arg("x"), py::arg("y"))
+    .def("__call__", &scitool::polynomial_interpolator::operator())
+    .def("__call__", &evaluate_array<scitool::polynomial_interpolator>, "Interpolates every element of an array.");
 
     py::class_<scitool::cardinal_cubic_bspline_interpolator, scitool::interpolator>(m, "CardinalCubicBSplineInterpolator")
-    .def(py::init<const std::vector<scitool::point>&>())
-    .def("__call__", &scitool::cardinal_cubic_bspline_interpolator::operator());
-}
\ No newline at end of file
+    .def(py::init<const std::vector<scitool::point>&>(), py::call_guard<py::gil_scoped_release>())
+    .def(py::init(&from_arrays<scitool::cardinal_cubic_bspline_interpolator>), py::arg("x"), py::arg("y"))
+    .def("__call__", &scitool::cardinal_cubic_bspline_interpolator::operator())
+    .def("__call__", &evaluate_array<scitool::cardinal_cubic_bspline_interpolator>, "Interpolates every element of an array.");
+
+    // the function is sampled by several threads, each taking the GIL for its calls to Python
+    py::class_<scitool::chebyshev_interpolator, scitool::interpolator>(m, "ChebyshevInterpolator")
+    .def(py::init([](const py::function &function, double a, double b, double max_error, size_t degree,
+                     size_t initial_segments, size_t max_segments, size_t threads) {
+        scitool::approximation_options options;
+        options.max_error = max_error;
+        options.degree = degree;
+        options.initial_segments = initial_segments;
+        options.max_segments = max_segments;
+        options.threads = threads;
+        std::function<double(double)> call = [function](double x) {
+            py::gil_scoped_acquire acquire;
+            return function(x).cast<double>();
+        };
+
+        py::gil_scoped_release release;
+        return new scitool::chebyshev_interpolator(call, a, b, options);
+    }), py::arg("function"), py::arg("a"), py::arg("b"), py::arg("max_error") = 1e-8, py::arg("degree") = 8,
+         py::arg("initial_segments") = 16, py::arg("max_segments") = 1 << 20, py::arg("threads") = 0)
+    .def("__call__", &scitool::chebyshev_interpolator::operator())
+    .def("__call__", &evaluate_array<scitool::chebyshev_interpolator>, "Interpolates every element of an array.")
+    .def_property_readonly("segment_count", &scitool::chebyshev_interpolator::segment_count)
+    .def_property_readonly("degree", &scitool::chebyshev_interpolator::degree)
+    .def_property_readonly("error_estimate", &scitool::chebyshev_interpolator::error_estimate)
+    .def_property_readonly("function_evaluations", &scitool::chebyshev_interpolator::function_evaluations);
+
+    py::class_<scitool::scattered_point>(m, "ScatteredPoint")
+    .def(py::init<double, double, double>())
+    .def_readwrite("x", &scitool::scattered_point::x)
+    .def_readwrite("y", &scitool::scattered_point::y)
+    .def_readwrite("value", &scitool::scattered_point::value);
+
+    py::class_<scitool::scattered_interpolator>(m, "ScatteredInterpolator")
+    .def("__call__", &scitool::scattered_interpolator::operator())
+    .def("evaluate", &scitool::scattered_interpolator::evaluate, py::call_guard<py::gil_scoped_release>(), "Interpolates at every (x[i], y[i]) pair.")
+    .def("__len__", &scitool::scattered_interpolator::size);
+
+    // the column constructors accept the output of Dataset.numerical_column, None values are skipped
+    py::class_<scitool::idw_interpolator, scitool::scattered_interpolator>(m, "IDWInterpolator")
+    .def(py::init<const std::vector<scitool::scattered_point>&, size_t, double>(),
+         py::arg("points"), py::arg("neighbors") = 8, py::arg("power") = 2.0, py::call_guard<py::gil_scoped_release>())
+    .def(py::init<const std::vector<std::optional<double>>&, const std::vector<std::optional<double>>&,
+                  const std::vector<std::optional<double>>&, size_t, double>(),
+         py::arg("x"), py::arg("y"), py::arg("values"), py::arg("neighbors") = 8, py::arg("power") = 2.0, py::call_guard<py::gil_scoped_release>());
+
+    py::enum_<scitool::rbf_kernel>(m, "RBFKernel")
+    .value("WENDLAND_C2", scitool::rbf_kernel::wendland_c2)
+    .value("WENDLAND_C4", scitool::rbf_kernel::wendland_c4);
+
+    py::class_<scitool::rbf_interpolator, scitool::scattered_interpolator>(m, "RBFInterpolator")
+    .def(py::init<const std::vector<scitool::scattered_point>&, double, scitool::rbf_kernel, double>(),
+         py::arg("points"), py::arg("support_radius"), py::arg("kernel") = scitool::rbf_kernel::wendland_c2,
+         py::arg("smoothing") = 0.0, py::call_guard<py::gil_scoped_release>())
+    .def(py::init<const std::vector<std::optional<double>>&, const std::vector<std::optional<double>>&,
+                  const std::vector<std::optional<double>>&, double, scitool::rbf_kernel, double>(),
+         py::arg("x"), py::arg("y"), py::arg("values"), py::arg("support_radius"),
+         py::arg("kernel") = scitool::rbf_kernel::wendland_c2, py::arg("smoothing") = 0.0, py::call_guard<py::gil_scoped_release>());
+
+    bind_profiling(m);
+}
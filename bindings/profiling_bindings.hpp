@@ -0,0 +1,48 @@
+#ifndef PROFILING_BINDINGS_HPP
+#define PROFILING_BINDINGS_HPP
+
+#include <pybind11/pybind11.h>
+#include "profiling.hpp"
+
+// Profiling functions shared by both modules; they read the same process-wide registry
+inline void bind_profiling(pybind11::module_& m) {
+    namespace py = pybind11;
+
+    m.def("profiling_enabled", &scitool::profiling::enabled,
+          "True when the toolbox was built with SCITOOL_PROFILING, otherwise the snapshots stay empty.");
+    m.def("profiling_snapshot", []() {
+        scitool::profiling::snapshot snapshot = scitool::profiling::take_snapshot();
+        // None rather than a misleading 0 where allocations are not counted
+        bool counted = scitool::profiling::allocations_counted();
+
+        py::dict operations;
+        for (const auto& op : snapshot.operations) {
+            py::dict stats;
+            stats["calls"] = op.calls;
+            stats["total_seconds"] = op.total_seconds;
+            stats["max_seconds"] = op.max_seconds;
+            stats["allocations"] = counted ? py::object(py::int_(op.allocations)) : py::none();
+            stats["allocated_bytes"] = counted ? py::object(py::int_(op.allocated_bytes)) : py::none();
+            operations[py::str(op.name)] = stats;
+        }
+
+        py::dict counters;
+        for (const auto& [name, value] : snapshot.counters) counters[py::str(name)] = value;
+
+        py::dict result;
+        result["operations"] = operations;
+        result["counters"] = counters;
+        return result;
+    }, "Per-operation timings and allocations and the counters recorded so far; the allocations are None when they "
+       "are not counted (see profiling_allocations_counted).");
+    m.def("profiling_allocations_counted", &scitool::profiling::allocations_counted,
+          "True when heap allocations are counted: profiling builds, except on Windows, where each DLL has its own operator new.");
+    m.def("profiling_reset", &scitool::profiling::reset, "Sets every operation and counter back to zero.");
+    m.def("set_profiling_tracing", &scitool::profiling::set_tracing, py::arg("on"),
+          "Records every profiled call as a trace event.");
+    m.def("write_chrome_trace", py::overload_cast<const std::string&>(&scitool::profiling::write_chrome_trace),
+          py::arg("path"), py::call_guard<py::gil_scoped_release>(),
+          "Writes the recorded trace events in the Chrome trace-event JSON format.");
+}
+
+#endif
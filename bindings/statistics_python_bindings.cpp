@@ -4,27 +4,278 @@
 #include <pybind11/complex.h>
 #include <pybind11/eigen.h>
 #include <pybind11/chrono.h>
+#include <pybind11/numpy.h>
+#include "profiling_bindings.hpp"
 #include "dataset.hpp"
+#include "report.hpp"
 
 namespace py = pybind11;
 
 PYBIND11_MAKE_OPAQUE(std::vector<std::optional<scitool::dataset::data_variant>>)
 
+scitool::report_options make_report_options(const std::string& format, std::optional<std::vector<std::string>> columns,
+                                             std::optional<std::vector<std::string>> statistics, bool frequency_counts,
+                                             bool correlation, size_t threads) {
+    scitool::report_options options;
+    options.format = scitool::parse_report_format(format);
+    if (columns) options.columns = std::move(*columns);
+    if (statistics) {
+        options.statistics.clear();
+        for (const auto& name : *statistics) options.statistics.push_back(scitool::parse_report_statistic(name));
+    }
+    options.frequency_counts = frequency_counts;
+    options.correlation = correlation;
+    options.threads = threads;
+    return options;
+}
+
+scitool::bootstrap_options make_bootstrap_options(size_t replicates, double confidence, std::uint64_t seed, size_t threads) {
+    scitool::bootstrap_options options;
+    options.replicates = replicates;
+    options.confidence = confidence;
+    options.seed = seed;
+    options.threads = threads;
+    return options;
+}
+
+scitool::csv_read_options make_csv_read_options(size_t block_size, size_t blocks_in_flight, size_t threads) {
+    scitool::csv_read_options options;
+    options.block_size = block_size;
+    options.blocks_in_flight = blocks_in_flight;
+    options.threads = threads;
+    return options;
+}
+
+// the columns are written by C++ straight into the buffer of a new NumPy array, with the GIL
+// released, so no Python object is created per value
+py::array_t<double> numpy_columns(scitool::dataset& self, const std::vector<std::string>& column_names) {
+    size_t rows = self.size(), cols = column_names.size();
+    py::array_t<double> result({rows, cols});
+    double* data = result.mutable_data();
+    {
+        py::gil_scoped_release release;
+        for (size_t col = 0; col < cols; ++col) {
+            self.copy_numerical_column(column_names[col], data + col, cols);
+        }
+    }
+    return result;
+}
+
+// edges of the bins of a column, bins being a number of bins (over the range of the values) or a sequence of edges,
+// as in numpy.histogram
+std::vector<double> bin_edges(scitool::dataset& self, const std::string& column_name, const py::object& bins) {
+    if (!py::isinstance<py::int_>(bins)) return bins.cast<std::vector<double>>();
+    auto count = bins.cast<size_t>();
+    py::gil_scoped_release release;
+    return self.histogram(column_name, count).edges;
+}
+
+// A Python callable for the steps of a lazy query, which may run on the threads of the scan: the GIL is taken
+// for every call, and for the release of the callable, which can happen when the last query using it is dropped
+template <typename Result>
+std::function<Result(double)> python_callback(py::function func) {
+    std::shared_ptr<py::function> shared(new py::function(std::move(func)), [](py::function* callable) {
+        py::gil_scoped_acquire acquire;
+        delete callable;
+    });
+    return [shared](double value) {
+        py::gil_scoped_acquire acquire;
+        return (*shared)(value).template cast<Result>();
+    };
+}
+
+template <typename T>
+py::array_t<T> numpy_vector(const std::vector<T>& values) {
+    return py::array_t<T>(static_cast<py::ssize_t>(values.size()), values.data());
+}
+
 PYBIND11_MODULE(statistics_py, m) {
     py::class_<scitool::dataset>(m, "Dataset")
         .def(py::init<const std::vector<std::string>&,scitool::dataset::matrix,const std::set<int>&,const std::set<int>&>())
-        .def_static("from_csv", &scitool::dataset::from_csv, py::return_value_policy::take_ownership)
+        .def_static("from_csv", [](const std::string& input_file, size_t block_size, size_t blocks_in_flight, size_t threads) {
+            return scitool::dataset::from_csv(input_file, make_csv_read_options(block_size, blocks_in_flight, threads));
+        }, py::arg("input_file"), py::arg("block_size") = size_t(4) << 20, py::arg("blocks_in_flight") = 0, py::arg("threads") = 0,
+        py::return_value_policy::take_ownership, py::call_guard<py::gil_scoped_release>())
+        .def_static("from_csv_with_stats", [](const std::string& input_file, size_t block_size, size_t blocks_in_flight, size_t threads) {
+            scitool::csv_read_stats stats;
+            std::unique_ptr<scitool::dataset> result;
+            {
+                py::gil_scoped_release release;
+                result = scitool::dataset::from_csv(input_file, make_csv_read_options(block_size, blocks_in_flight, threads), &stats);
+            }
+            return py::make_tuple(py::cast(std::move(result)), stats);
+        }, py::arg("input_file"), py::arg("block_size") = size_t(4) << 20, py::arg("blocks_in_flight") = 0, py::arg("threads") = 0,
+        "Method to load a CSV file along with the time spent by every stage of the reading pipeline, as (dataset, stats).")
         .def("is_categorical", &scitool::dataset::is_categorical, "Method to check if a column is categorical.")
-        .def("mean", &scitool::dataset::get_mean, "Method to get the mean value of a numerical column.")
-        .def("std_dev", &scitool::dataset::get_std_dev, "Method to get the standard deviation of a numerical column.")
-        .def("median", &scitool::dataset::get_median, "Method to get the median of a numerical column.")
-        .def("variance", &scitool::dataset::get_variance, "Method to get the variance of a numerical column.")
-        .def("frequency_count", &scitool::dataset::get_frequency_count, "Method to get the frequency count of the values of a categorical column.")
+        .def("mean", &scitool::dataset::get_mean, py::call_guard<py::gil_scoped_release>(), "Method to get the mean value of a numerical column.")
+        .def("std_dev", &scitool::dataset::get_std_dev, py::call_guard<py::gil_scoped_release>(), "Method to get the standard deviation of a numerical column.")
+        .def("median", &scitool::dataset::get_median, py::call_guard<py::gil_scoped_release>(), "Method to get the median of a numerical column.")
+        .def("variance", &scitool::dataset::get_variance, py::call_guard<py::gil_scoped_release>(), "Method to get the variance of a numerical column.")
+        .def("quantile", &scitool::dataset::get_quantile, py::call_guard<py::gil_scoped_release>(), "Method to get the q-quantile (0 <= q <= 1) of a numerical column.")
+        .def("quantiles", &scitool::dataset::get_quantiles, py::call_guard<py::gil_scoped_release>(), "Method to get several quantiles of a numerical column.")
+        .def("sort_by", [](scitool::dataset& self, const std::vector<std::string>& column_names, const py::object& ascending) {
+            std::vector<bool> directions = py::isinstance<py::bool_>(ascending)
+                ? std::vector<bool>(column_names.size(), ascending.cast<bool>())
+                : ascending.cast<std::vector<bool>>();
+            std::vector<size_t> rows;
+            {
+                py::gil_scoped_release release;
+                rows = self.sort_by(column_names, directions);
+            }
+            return py::array_t<size_t>(static_cast<py::ssize_t>(rows.size()), rows.data());
+        }, py::arg("columns"), py::arg("ascending") = true,
+        "Method to get the row indices ordered by the given columns, as a NumPy array; ascending is a bool or one bool per column.")
+        .def("join", [](const scitool::dataset& self, const scitool::dataset& other, const std::vector<std::string>& on, const std::string& how) {
+            auto kind = scitool::parse_join_kind(how);
+            py::gil_scoped_release release;
+            return self.join(other, on, kind);
+        }, py::arg("other"), py::arg("on"), py::arg("how") = "inner",
+        "Method to join with another dataset on equal values of the given columns, how is \"inner\" or \"left\".")
+        .def("histogram", [](scitool::dataset& self, const std::string& column_name, const py::object& bins,
+                             std::optional<std::pair<double, double>> range, size_t threads) {
+            scitool::histogram_result histogram;
+            if (py::isinstance<py::int_>(bins) && !range) {
+                py::gil_scoped_release release;
+                histogram = self.histogram(column_name, bins.cast<size_t>(), threads);
+            } else if (py::isinstance<py::int_>(bins)) {
+                py::gil_scoped_release release;
+                histogram = self.histogram(column_name, bins.cast<size_t>(), range->first, range->second, threads);
+            } else {
+                auto edges = bins.cast<std::vector<double>>();
+                py::gil_scoped_release release;
+                histogram = self.histogram(column_name, edges, threads);
+            }
+            return py::make_tuple(numpy_vector(histogram.counts), numpy_vector(histogram.edges));
+        }, py::arg("column_name"), py::arg("bins") = 10, py::arg("range") = py::none(), py::arg("threads") = 0,
+        "Method to get the histogram of a numerical column as (counts, edges) NumPy arrays, like numpy.histogram. "
+        "bins is a number of bins (over range, or the range of the values) or a sequence of edges.")
+        .def("histogram_2d", [](scitool::dataset& self, const std::string& x_column, const std::string& y_column,
+                                const py::object& bins, size_t threads) {
+            // one bins argument for both axes, or a pair of them
+            bool per_axis = py::isinstance<py::tuple>(bins) && py::len(bins) == 2;
+            py::object x_bins = per_axis ? py::object(bins[py::int_(0)]) : bins;
+            py::object y_bins = per_axis ? py::object(bins[py::int_(1)]) : bins;
+
+            scitool::histogram_2d_result histogram;
+            if (py::isinstance<py::int_>(x_bins) && py::isinstance<py::int_>(y_bins)) {
+                // bins of equal width, each value found with one multiplication
+                auto x_count = x_bins.cast<size_t>(), y_count = y_bins.cast<size_t>();
+                py::gil_scoped_release release;
+                histogram = self.histogram_2d(x_column, y_column, x_count, y_count, threads);
+            } else {
+                auto x_edges = bin_edges(self, x_column, x_bins);
+                auto y_edges = bin_edges(self, y_column, y_bins);
+                py::gil_scoped_release release;
+                histogram = self.histogram_2d(x_column, y_column, x_edges, y_edges, threads);
+            }
+            py::array_t<size_t> counts({histogram.x_edges.size() - 1, histogram.y_edges.size() - 1});
+            std::copy(histogram.counts.begin(), histogram.counts.end(), counts.mutable_data());
+            return py::make_tuple(counts, numpy_vector(histogram.x_edges), numpy_vector(histogram.y_edges));
+        }, py::arg("x_column"), py::arg("y_column"), py::arg("bins") = 10, py::arg("threads") = 0,
+        "Method to get the joint histogram of two numerical columns as (counts, x_edges, y_edges), like numpy.histogram2d.")
+        .def("bootstrap", [](scitool::dataset& self, const std::string& column_name, const std::string& statistic, size_t replicates,
+                             double confidence, std::uint64_t seed, size_t threads) {
+            auto parsed = scitool::parse_aggregate(statistic);
+            py::gil_scoped_release release;
+            return self.bootstrap(column_name, parsed, make_bootstrap_options(replicates, confidence, seed, threads));
+        }, py::arg("column_name"), py::arg("statistic"), py::arg("replicates") = 1000, py::arg("confidence") = 0.95,
+        py::arg("seed") = 0, py::arg("threads") = 0,
+        "Method to get a bootstrap confidence interval of the sum, mean, variance, std_dev or median of a numerical column.")
+        .def("bootstrap_quantile", [](scitool::dataset& self, const std::string& column_name, double q, size_t replicates,
+                                      double confidence, std::uint64_t seed, size_t threads) {
+            return self.bootstrap_quantile(column_name, q, make_bootstrap_options(replicates, confidence, seed, threads));
+        }, py::arg("column_name"), py::arg("q"), py::arg("replicates") = 1000, py::arg("confidence") = 0.95,
+        py::arg("seed") = 0, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("bootstrap_correlation", [](const scitool::dataset& self, const std::string& x_column, const std::string& y_column,
+                                         size_t replicates, double confidence, std::uint64_t seed, size_t threads) {
+            return self.bootstrap_correlation(x_column, y_column, make_bootstrap_options(replicates, confidence, seed, threads));
+        }, py::arg("x_column"), py::arg("y_column"), py::arg("replicates") = 1000, py::arg("confidence") = 0.95,
+        py::arg("seed") = 0, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>(),
+        "Method to get a bootstrap confidence interval of the correlation of two numerical columns.")
+        .def("fill_missing", [](scitool::dataset& self, const std::vector<std::string>& columns, const std::string& method, size_t threads) {
+            auto parsed = scitool::parse_imputation_method(method);
+            py::gil_scoped_release release;
+            return self.fill_missing(columns, parsed, threads);
+        }, py::arg("columns"), py::arg("method"), py::arg("threads") = 0,
+        "Method to fill the missing values of numerical columns with \"ffill\", \"bfill\", \"mean\" or \"median\", returning the cells filled per column.")
+        .def("interpolate_missing", [](scitool::dataset& self, const std::vector<std::string>& columns, const std::string& by_column,
+                                       const std::string& method, size_t threads) {
+            auto parsed = scitool::parse_interpolation_method(method);
+            py::gil_scoped_release release;
+            return self.interpolate_missing(columns, by_column, parsed, threads);
+        }, py::arg("columns"), py::arg("by_column"), py::arg("method") = "linear", py::arg("threads") = 0,
+        "Method to interpolate the missing values of numerical columns as a function of by_column (\"linear\" or \"polynomial\").")
+        .def("covariance_matrix", &scitool::dataset::covariance_matrix, py::arg("columns") = std::vector<std::string>{},
+             py::call_guard<py::gil_scoped_release>(), "Method to get the (population) covariance matrix of numerical columns, all of them by default.")
+        .def("regress", &scitool::dataset::regress, py::arg("target"), py::arg("predictors"), py::call_guard<py::gil_scoped_release>(),
+             "Method to fit target on the predictors (with an intercept) by ordinary least squares, over the rows where all have a value.")
+        .def_static("regress_csv", &scitool::dataset::regress_csv, py::arg("input_file"), py::arg("target"), py::arg("predictors"),
+                    py::arg("chunk_rows") = 65536, py::call_guard<py::gil_scoped_release>(),
+                    "Method to fit the same regression on a CSV file read chunk_rows lines at a time, without loading it whole.")
+        .def("top_n", &scitool::dataset::top_n, py::arg("column_name"), py::arg("n"), py::arg("largest") = true,
+             py::call_guard<py::gil_scoped_release>(), "Method to get the rows of the n largest (or smallest) values of a numerical column.")
+        .def("frequency_count", &scitool::dataset::get_frequency_count, py::call_guard<py::gil_scoped_release>(), "Method to get the frequency count of the values of a categorical column.")
+        .def("numerical_column", &scitool::dataset::get_numerical_column, py::call_guard<py::gil_scoped_release>(), "Method to get the values of a numerical column, None for missing values.")
+        .def("column", [](scitool::dataset& self, const std::string& column_name, bool masked) -> py::object {
+            // a read-only view of the contiguous storage of the column, which keeps the dataset alive
+            const double* data = self.get_numerical_data(column_name);
+            py::array_t<double> result(static_cast<py::ssize_t>(self.size()), data, py::cast(&self));
+            result.attr("setflags")(py::arg("write") = false);
+            py::object column = std::move(result);
+            if (masked) column = py::module_::import("numpy.ma").attr("masked_invalid")(column);
+            return column;
+        }, py::arg("column_name"), py::arg("masked") = false,
+        "Method to get a numerical column as a NumPy array, with NaN (or masked entries if masked=True) for missing values. "
+        "Without a mask the array is a read-only view of the column, not a copy: it sees the changes made in place by "
+        "fill_missing, interpolate_missing or map_column, and after filter_rows only its first len(dataset) values are rows; "
+        "use .copy() to keep the values of the moment.")
+        .def("to_numpy", [](scitool::dataset& self, std::optional<std::vector<std::string>> column_names) {
+            return numpy_columns(self, column_names ? *column_names : self.get_numerical_column_names());
+        }, py::arg("columns") = py::none(),
+        "Method to get numerical columns (all of them by default) as a 2-D NumPy array, one column per requested column.")
+        .def_property_readonly("numerical_columns", &scitool::dataset::get_numerical_column_names)
+        .def("filter_categories", &scitool::dataset::filter_categories, py::call_guard<py::gil_scoped_release>(),
+             "Filters the dataset in place, keeping the rows whose value in a categorical column is one of the given values.")
+        .def("set_run_length_encoding", &scitool::dataset::set_run_length_encoding,
+             "Method to turn the run-length encoding of a categorical column on or off.")
+        .def("is_run_length_encoded", &scitool::dataset::is_run_length_encoded)
+        .def_property_readonly("memory_usage", &scitool::dataset::memory_usage)
+        .def_static("from_numpy", [](py::array_t<double, py::array::c_style | py::array::forcecast> values, std::vector<std::string> column_names) {
+            if (values.ndim() != 2 || static_cast<size_t>(values.shape(1)) != column_names.size()) {
+                throw std::invalid_argument("Expected a 2-D array with one column per column name");
+            }
+            const double* data = values.data();
+            auto rows = static_cast<size_t>(values.shape(0));
+            py::gil_scoped_release release;
+            return scitool::dataset::from_numerical_data(std::move(column_names), data, rows);
+        }, py::arg("values"), py::arg("columns"),
+        "Method to build a dataset of numerical columns from a 2-D array, NaN values are stored as missing.")
             .def_property_readonly("correlation_matrix", [](scitool::dataset& v) {
-                Eigen::MatrixXd matrix = v.get_correlation_matrix(); // assuming this returns an Eigen matrix
+                Eigen::MatrixXd matrix;
+                {
+                    py::gil_scoped_release release;
+                    matrix = v.get_correlation_matrix();
+                }
                 return matrix; // pybind11 automatically converts Eigen matrices to NumPy arrays
             })
-        .def("output_statistics", &scitool::dataset::output_statistics, "Outputs statistics to a text file.")
+        .def("output_statistics", &scitool::dataset::output_statistics, py::call_guard<py::gil_scoped_release>(), "Outputs statistics to a text file.")
+        .def("report", [](scitool::dataset& self, const std::string& format, std::optional<std::vector<std::string>> columns,
+                          std::optional<std::vector<std::string>> statistics, bool frequency_counts, bool correlation, size_t threads) {
+            auto options = make_report_options(format, std::move(columns), std::move(statistics), frequency_counts, correlation, threads);
+            py::gil_scoped_release release;
+            return scitool::format_report(self, options);
+        }, py::arg("format") = "text", py::arg("columns") = py::none(), py::arg("statistics") = py::none(),
+        py::arg("frequency_counts") = true, py::arg("correlation") = true, py::arg("threads") = 0,
+        "Method to get the statistics report as a string, in the text, csv, json or markdown format.")
+        .def("write_report", [](scitool::dataset& self, const std::string& output_file, const std::string& format,
+                                std::optional<std::vector<std::string>> columns, std::optional<std::vector<std::string>> statistics,
+                                bool frequency_counts, bool correlation, size_t threads) {
+            auto options = make_report_options(format, std::move(columns), std::move(statistics), frequency_counts, correlation, threads);
+            py::gil_scoped_release release;
+            scitool::write_report(self, output_file, options);
+        }, py::arg("output_file"), py::arg("format") = "text", py::arg("columns") = py::none(), py::arg("statistics") = py::none(),
+        py::arg("frequency_counts") = true, py::arg("correlation") = true, py::arg("threads") = 0,
+        "Method to write the statistics report to a file, or to the standard output if output_file is '-'.")
         .def_property_readonly("file_name", &scitool::dataset::get_file_name)
         .def("__len__", [](const scitool::dataset &v) {
             return v.size();
@@ -63,7 +314,140 @@ PYBIND11_MODULE(statistics_py, m) {
             self.filter_rows(column_name, [&func](double value) -> bool {
                 return func(value).cast<bool>();
             });
-        }, "Filters the dataset in place given a filter function and a column to filter on.");
+        }, "Filters the dataset in place given a filter function and a column to filter on.")
+        .def("map_column_batched", [](scitool::dataset& self, const std::string& column_name, py::function func, size_t chunk_size) {
+            self.map_column_chunks(column_name, chunk_size, [&func](double* values, size_t n) {
+                py::array_t<double> chunk(static_cast<py::ssize_t>(n));
+                std::copy(values, values + n, chunk.mutable_data());
+                auto mapped = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(func(chunk));
+                if (!mapped || static_cast<size_t>(mapped.size()) != n) {
+                    throw std::invalid_argument("The mapping function must return an array with the size of its input");
+                }
+                std::copy(mapped.data(), mapped.data() + n, values);
+            });
+        }, py::arg("column_name"), py::arg("func"), py::arg("chunk_size") = 65536,
+        "Applies a function to the values of the specified column, chunk_size values at a time: func receives a NumPy array and returns the mapped array. Missing values are skipped.")
+        .def("filter_rows_batched", [](scitool::dataset& self, const std::string& column_name, py::function func, size_t chunk_size) {
+            self.filter_rows_chunks(column_name, chunk_size, [&func](const double* values, size_t n, bool* keep) {
+                py::array_t<double> chunk(static_cast<py::ssize_t>(n));
+                std::copy(values, values + n, chunk.mutable_data());
+                auto mask = py::array_t<bool, py::array::c_style | py::array::forcecast>::ensure(func(chunk));
+                if (!mask || static_cast<size_t>(mask.size()) != n) {
+                    throw std::invalid_argument("The filter function must return a boolean array with the size of its input");
+                }
+                std::copy(mask.data(), mask.data() + n, keep);
+            });
+        }, py::arg("column_name"), py::arg("func"), py::arg("chunk_size") = 65536,
+        "Filters the dataset in place, chunk_size rows at a time: func receives a NumPy array of the column values and returns a boolean mask of the rows to keep.")
+        .def("rolling", &scitool::dataset::rolling, py::arg("columns"), py::arg("window"), py::arg("min_periods") = 0, py::keep_alive<0, 1>(),
+             "Method to get rolling statistics of numerical columns over the last window rows, e.g. rolling([\"price\"], 20).mean().")
+        .def("cumulative", &scitool::dataset::cumulative, py::arg("columns"), py::arg("min_periods") = 1, py::keep_alive<0, 1>(),
+             "Method to get cumulative statistics of numerical columns, e.g. cumulative([\"price\"]).sum().")
+        .def("lazy", &scitool::dataset::lazy, py::keep_alive<0, 1>(),
+             "Method to start a lazy query on the dataset, whose map and filter steps run fused with its aggregations in one parallel scan.");
+
+    py::class_<scitool::lazy_query>(m, "LazyQuery")
+        .def("map", [](const scitool::lazy_query& self, const std::string& column_name, const py::object& func) {
+            if (py::isinstance<py::str>(func)) return self.map(column_name, scitool::named_transform(func.cast<std::string>()));
+            return self.map(column_name, python_callback<double>(func.cast<py::function>()));
+        }, py::arg("column_name"), py::arg("func"), py::keep_alive<0, 1>(),
+        "Adds a map step: func is a Python function or the name of a built-in transform (log, log10, log1p, exp, sqrt, abs, square), "
+        "which runs in parallel without the GIL.")
+        .def("filter", [](const scitool::lazy_query& self, const std::string& column_name, const py::object& predicate,
+                          std::optional<double> value) {
+            if (py::isinstance<py::str>(predicate)) {
+                if (!value) throw std::invalid_argument("A comparison filter needs a value");
+                return self.filter(column_name, scitool::comparison(predicate.cast<std::string>(), *value));
+            }
+            return self.filter(column_name, python_callback<bool>(predicate.cast<py::function>()));
+        }, py::arg("column_name"), py::arg("predicate"), py::arg("value") = py::none(), py::keep_alive<0, 1>(),
+        "Adds a filter step: predicate is a Python function, or a comparison (\"<\", \"<=\", \">\", \">=\", \"==\", \"!=\") with value.")
+        .def("agg", [](const scitool::lazy_query& self, const std::vector<std::pair<std::string, std::string>>& aggregations,
+                       std::optional<std::vector<std::string>> correlation, size_t threads) {
+            std::vector<scitool::aggregation> requested;
+            for (const auto& [column, statistic] : aggregations) requested.push_back({column, scitool::parse_aggregate(statistic)});
+            py::gil_scoped_release release;
+            return self.agg(requested, correlation ? *correlation : std::vector<std::string>{}, threads);
+        }, py::arg("aggregations"), py::arg("correlation") = py::none(), py::arg("threads") = 0,
+        "Runs the query and computes the (column, statistic) aggregations, and the correlation matrix of the correlation columns, in one scan.")
+        .def("correlation_matrix", &scitool::lazy_query::correlation_matrix, py::arg("columns") = std::vector<std::string>{},
+             py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("covariance_matrix", &scitool::lazy_query::covariance_matrix, py::arg("columns") = std::vector<std::string>{},
+             py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("regress", &scitool::lazy_query::regress, py::arg("target"), py::arg("predictors"), py::arg("threads") = 0,
+             py::call_guard<py::gil_scoped_release>(), "Runs the query and fits target on the predictors over the kept rows.")
+        .def("count", &scitool::lazy_query::count, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("collect", &scitool::lazy_query::collect, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>(),
+             "Applies the map and filter steps to the dataset in place.");
+
+    py::class_<scitool::rolling_window>(m, "RollingWindow")
+        .def("count", &scitool::rolling_window::count, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("sum", &scitool::rolling_window::sum, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("mean", &scitool::rolling_window::mean, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("variance", &scitool::rolling_window::variance, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("std_dev", &scitool::rolling_window::std_dev, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("min", &scitool::rolling_window::min, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("max", &scitool::rolling_window::max, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("median", &scitool::rolling_window::median, py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("apply", [](const scitool::rolling_window& self, const std::string& statistic, size_t threads) {
+            auto parsed = scitool::parse_aggregate(statistic);
+            py::gil_scoped_release release;
+            return self.apply(parsed, threads);
+        }, py::arg("statistic"), py::arg("threads") = 0,
+        "Computes the statistic by name (count, sum, mean, variance, std_dev, min, max or median) as a new dataset.");
+
+    py::class_<scitool::query_result>(m, "QueryResult")
+        .def_readonly("rows", &scitool::query_result::rows)
+        .def_readonly("correlation_columns", &scitool::query_result::correlation_columns)
+        .def_readonly("correlation", &scitool::query_result::correlation)
+        .def_readonly("covariance", &scitool::query_result::covariance)
+        .def("get", [](const scitool::query_result& self, const std::string& column, const std::string& statistic) {
+            return self.get(column, scitool::parse_aggregate(statistic));
+        })
+        .def("to_dict", [](const scitool::query_result& self) {
+            py::dict result;
+            for (size_t i = 0; i < self.aggregations.size(); ++i) {
+                py::str column(self.aggregations[i].column);
+                if (!result.contains(column)) result[column] = py::dict();
+                result[column].cast<py::dict>()[py::str(scitool::aggregate_name(self.aggregations[i].statistic))] = self.values[i];
+            }
+            return result;
+        }, "Method to get the aggregations as a {column: {statistic: value}} dictionary.");
+
+    py::class_<scitool::regression_result>(m, "RegressionResult")
+        .def_readonly("terms", &scitool::regression_result::terms)
+        .def_readonly("coefficients", &scitool::regression_result::coefficients)
+        .def_readonly("standard_errors", &scitool::regression_result::standard_errors)
+        .def_readonly("r_squared", &scitool::regression_result::r_squared)
+        .def_readonly("adjusted_r_squared", &scitool::regression_result::adjusted_r_squared)
+        .def_readonly("residual_std_error", &scitool::regression_result::residual_std_error)
+        .def_readonly("observations", &scitool::regression_result::observations);
+
+    py::class_<scitool::bootstrap_result>(m, "BootstrapResult")
+        .def_readonly("estimate", &scitool::bootstrap_result::estimate)
+        .def_readonly("lower", &scitool::bootstrap_result::lower)
+        .def_readonly("upper", &scitool::bootstrap_result::upper)
+        .def_readonly("standard_error", &scitool::bootstrap_result::standard_error)
+        .def_readonly("confidence", &scitool::bootstrap_result::confidence)
+        .def_property_readonly("replicates", [](const scitool::bootstrap_result& self) {
+            return numpy_vector(self.replicates);
+        });
+
+    py::class_<scitool::csv_read_stats>(m, "CsvReadStats")
+        .def_readonly("bytes", &scitool::csv_read_stats::bytes)
+        .def_readonly("text_bytes", &scitool::csv_read_stats::text_bytes)
+        .def_readonly("compression", &scitool::csv_read_stats::compression)
+        .def_readonly("blocks", &scitool::csv_read_stats::blocks)
+        .def_readonly("rows", &scitool::csv_read_stats::rows)
+        .def_readonly("parse_threads", &scitool::csv_read_stats::parse_threads)
+        .def_readonly("wall_seconds", &scitool::csv_read_stats::wall_seconds)
+        .def_readonly("read_seconds", &scitool::csv_read_stats::read_seconds)
+        .def_readonly("read_wait_seconds", &scitool::csv_read_stats::read_wait_seconds)
+        .def_readonly("parse_seconds", &scitool::csv_read_stats::parse_seconds)
+        .def_readonly("parse_wait_seconds", &scitool::csv_read_stats::parse_wait_seconds)
+        .def_readonly("append_seconds", &scitool::csv_read_stats::append_seconds)
+        .def_readonly("append_wait_seconds", &scitool::csv_read_stats::append_wait_seconds)
+        .def_property_readonly("bound", &scitool::csv_read_stats::bound);
 
     py::class_<scitool::dataset::column_stat>(m, "ColumnStat")
         .def_readwrite("col_index", &scitool::dataset::column_stat::col_index)
@@ -75,4 +459,6 @@ PYBIND11_MODULE(statistics_py, m) {
 
 
     m.attr("Eigen") = py::module_::import("numpy");
+
+    bind_profiling(m);
 }
@@ -0,0 +1,511 @@
+#include "command_line.hpp"
+#include "bench_utils.hpp"
+#include "cardinal_cubic_bspline_Interpolator.hpp"
+#include "dataset.hpp"
+#include "linear_interpolator.hpp"
+#include "model_selection.hpp"
+#include "parallel.hpp"
+#include "polynomial_interpolator.hpp"
+#include "report.hpp"
+#include "text_format.hpp"
+#include <charconv>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+namespace scitool::cli {
+
+    namespace {
+        const std::map<std::string, std::set<std::string>> command_options = {
+                {"stats", {"columns", "statistics", "format", "output", "threads"}},
+                {"corr", {"columns", "format", "output", "threads"}},
+                {"groupby", {"by", "columns", "statistics", "format", "output", "threads"}},
+                {"interpolate", {"x", "y", "at", "method", "budget", "format", "output", "threads"}},
+                {"bench", {"repetitions", "format", "output", "threads"}},
+                {"batch", {"threads"}},
+        };
+
+        std::vector<std::string> split_list(const std::string& list) {
+            std::vector<std::string> items;
+            std::stringstream stream(list);
+            std::string item;
+            while (std::getline(stream, item, ','))
+                if (!item.empty()) items.push_back(item);
+            return items;
+        }
+
+        // the numerical values of the options, whose errors name the option rather than std::stoul or std::stod
+        size_t count_value(const std::string& option, const std::string& text) {
+            size_t value = 0;
+            auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+                throw std::invalid_argument("Invalid value for --" + option + ": '" + text + "' (expected a non-negative integer)");
+            return value;
+        }
+
+        double number_value(const std::string& option, const std::string& text) {
+            double value = 0.0;
+            auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+                throw std::invalid_argument("Invalid value for --" + option + ": '" + text + "' (expected a number)");
+            return value;
+        }
+
+        size_t thread_count(const command& cmd) {
+            return cmd.has("threads") ? count_value("threads", cmd.get("threads")) : 0;
+        }
+
+        // Datasets loaded by the commands of one invocation: each file is read once and shared by every
+        // command, which only reads it (the cached statistics are shared too)
+        class dataset_cache {
+        public:
+            // loads the files that are not loaded yet, one per thread
+            void load(const std::vector<std::string>& paths, size_t threads) {
+                std::vector<std::string> missing;
+                for (const auto& path : paths) {
+                    if (!datasets.count(path) && std::find(missing.begin(), missing.end(), path) == missing.end())
+                        missing.push_back(path);
+                }
+
+                std::vector<std::unique_ptr<dataset>> loaded(missing.size());
+                parallel_for(missing.size(), [&](size_t i) { loaded[i] = dataset::from_csv(missing[i]); }, threads);
+                for (size_t i = 0; i < missing.size(); ++i) datasets.emplace(missing[i], std::move(loaded[i]));
+            }
+
+            // the file must have been loaded, lookups are safe from several threads
+            dataset& get(const std::string& path) const {
+                return *datasets.at(path);
+            }
+
+        private:
+            std::map<std::string, std::unique_ptr<dataset>> datasets;
+        };
+
+        void write_text(const std::string& path, const std::string& text) {
+            if (path == "-") {
+                size_t written = std::fwrite(text.data(), 1, text.size(), stdout);
+                if (std::fflush(stdout) != 0 || written != text.size())
+                    throw std::runtime_error("Unable to write to the standard output");
+                return;
+            }
+
+            std::ofstream out(path, std::ios::binary);
+            if (!out.is_open())
+                throw std::runtime_error("Unable to open file: " + path);
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            // a full disk must not leave a truncated output behind a successful exit
+            out.close();
+            if (out.fail())
+                throw std::runtime_error("Unable to write file: " + path);
+        }
+
+        // Joins the outputs of several inputs (files, groups) into one document of the format, labelling
+        // each of them with its key: a JSON array, CSV with a leading key column, sections for text and Markdown
+        std::string combine(const std::string& format, const std::string& label, const std::vector<std::string>& keys,
+                            const std::vector<std::string>& texts) {
+            std::string out;
+            if (format == "json") {
+                out = "[\n";
+                for (size_t i = 0; i < texts.size(); ++i) {
+                    std::string text = texts[i];
+                    while (!text.empty() && text.back() == '\n') text.pop_back();
+                    out += "{\"" + json_escape(label) + "\": \"" + json_escape(keys[i]) + "\", \"report\": " + text + "}";
+                    out += i + 1 < texts.size() ? ",\n" : "\n";
+                }
+                return out + "]\n";
+            }
+
+            if (format == "csv") {
+                for (size_t i = 0; i < texts.size(); ++i) {
+                    std::istringstream lines(texts[i]);
+                    std::string line;
+                    // the header of the first output only
+                    if (std::getline(lines, line) && i == 0) out += csv_field(label) + "," + line + "\n";
+                    while (std::getline(lines, line)) out += csv_field(keys[i]) + "," + line + "\n";
+                }
+                return out;
+            }
+
+            for (size_t i = 0; i < texts.size(); ++i) {
+                out += (format == "markdown" || format == "md" ? "# " : "") + label + ": " + keys[i] + "\n\n" + texts[i];
+                if (i + 1 < texts.size()) out += "\n";
+            }
+            return out;
+        }
+
+        // one output per input, written to --output ("{name}" is replaced by the name of the input file)
+        // or joined into one document
+        void write_outputs(const command& cmd, const std::string& format, const std::vector<std::string>& names,
+                           const std::vector<std::string>& texts) {
+            std::string path = cmd.get("output", "-");
+            size_t placeholder = path.find("{name}");
+            if (placeholder != std::string::npos) {
+                for (size_t i = 0; i < texts.size(); ++i) {
+                    write_text(std::string(path).replace(placeholder, 6, names[i]), texts[i]);
+                }
+                return;
+            }
+
+            write_text(path, texts.size() == 1 ? texts.front() : combine(format, "file", cmd.inputs, texts));
+        }
+
+        report_options make_report_options(const command& cmd) {
+            report_options options;
+            options.format = parse_report_format(cmd.get("format", "text"));
+            options.columns = split_list(cmd.get("columns"));
+            if (cmd.has("statistics")) {
+                options.statistics.clear();
+                for (const auto& name : split_list(cmd.get("statistics"))) options.statistics.push_back(parse_report_statistic(name));
+            }
+            options.threads = thread_count(cmd);
+            return options;
+        }
+
+        // runs produce(input) for every input file, concurrently when there are several of them
+        // (the statistics of each file are then computed on one thread)
+        template <typename Produce>
+        void for_each_input(const command& cmd, dataset_cache& cache, Produce produce) {
+            if (cmd.inputs.empty())
+                throw std::invalid_argument("The command " + cmd.name + " needs at least one input file");
+
+            cache.load(cmd.inputs, thread_count(cmd));
+            std::vector<std::string> names(cmd.inputs.size()), texts(cmd.inputs.size());
+            size_t inner_threads = cmd.inputs.size() > 1 ? 1 : thread_count(cmd);
+            parallel_for(cmd.inputs.size(), [&](size_t i) {
+                dataset& ds = cache.get(cmd.inputs[i]);
+                names[i] = ds.get_file_name();
+                texts[i] = produce(ds, inner_threads);
+            }, thread_count(cmd));
+
+            write_outputs(cmd, cmd.get("format", "text"), names, texts);
+        }
+
+        void run_stats(const command& cmd, dataset_cache& cache) {
+            report_options options = make_report_options(cmd);
+            options.correlation = false;
+            for_each_input(cmd, cache, [&](dataset& ds, size_t threads) {
+                report_options file_options = options;
+                file_options.threads = threads;
+                return format_report(ds, file_options);
+            });
+        }
+
+        void run_corr(const command& cmd, dataset_cache& cache) {
+            report_options options = make_report_options(cmd);
+            options.statistics.clear();
+            options.frequency_counts = false;
+            for_each_input(cmd, cache, [&](dataset& ds, size_t threads) {
+                report_options file_options = options;
+                file_options.threads = threads;
+                return format_report(ds, file_options);
+            });
+        }
+
+        void run_groupby(const command& cmd, dataset_cache& cache) {
+            std::string by = cmd.get("by");
+            if (by.empty())
+                throw std::invalid_argument("The command groupby needs a categorical column --by");
+
+            report_options options = make_report_options(cmd);
+            options.correlation = false;
+            std::string format = cmd.get("format", "text");
+            for_each_input(cmd, cache, [&](dataset& ds, size_t threads) {
+                report_options group_options = options;
+                group_options.threads = threads;
+                if (group_options.columns.empty()) {
+                    for (const auto& name : ds.get_column_names())
+                        if (name != by) group_options.columns.push_back(name);
+                }
+
+                std::vector<std::string> keys, texts;
+                for (auto& [key, group] : ds.group_by(by)) {
+                    keys.push_back(key);
+                    texts.push_back(format_report(*group, group_options));
+                }
+                return combine(format, by, keys, texts);
+            });
+        }
+
+        std::unique_ptr<interpolator> build_interpolator(const std::string& method, const std::vector<double>& x,
+                                                         const std::vector<double>& y) {
+            if (method == "linear") return std::make_unique<linear_interpolator>(x.data(), y.data(), x.size());
+            if (method == "polynomial") return std::make_unique<polynomial_interpolator>(x.data(), y.data(), x.size());
+            if (method == "spline") return std::make_unique<cardinal_cubic_bspline_interpolator>(x.data(), y.data(), x.size());
+            throw std::invalid_argument("Unknown interpolation method: " + method);
+        }
+
+        void run_interpolate(const command& cmd, dataset_cache& cache) {
+            if (!cmd.has("x") || !cmd.has("y") || !cmd.has("at"))
+                throw std::invalid_argument("The command interpolate needs the --x, --y and --at options");
+
+            std::vector<double> points;
+            for (const auto& item : split_list(cmd.get("at"))) points.push_back(number_value("at", item));
+            std::string method = cmd.get("method", "linear");
+            std::string format = cmd.get("format", "text");
+            if (format != "text" && format != "csv" && format != "json")
+                throw std::invalid_argument("Unknown output format for interpolate: " + format);
+            double budget = number_value("budget", cmd.get("budget", "1e-3"));
+
+            for_each_input(cmd, cache, [&](dataset& ds, size_t) {
+                // the knots skip the rows with a missing coordinate and average the y values of equal x (real
+                // columns repeat values), in the cached sorted order of the x column
+                knot_table knots = averaged_knots(ds.get_numerical_data(cmd.get("x")), ds.get_numerical_data(cmd.get("y")),
+                                                  ds.sort_by({cmd.get("x")}));
+                std::unique_ptr<interpolator> model;
+                std::string name = method;
+                if (method == "auto") {
+                    auto selection = select_interpolator(knots.x, knots.y, budget);
+                    model = std::move(selection.model);
+                    name = selection.name;
+                } else {
+                    model = build_interpolator(method, knots.x, knots.y);
+                }
+
+                std::vector<double> values(points.size());
+                model->evaluate(points.data(), values.data(), points.size());
+
+                std::string out;
+                if (format == "csv") {
+                    out = "x,y\n";
+                    for (size_t i = 0; i < points.size(); ++i) out += format_number(points[i]) + "," + format_number(values[i]) + "\n";
+                } else if (format == "json") {
+                    out = "{\"method\": \"" + name + "\", \"knots\": " + std::to_string(model->size()) + ", \"values\": [";
+                    for (size_t i = 0; i < points.size(); ++i) {
+                        out += (i == 0 ? "" : ", ") + std::string("{\"x\": ") + format_number(points[i]) + ", \"y\": " + format_number(values[i]) + "}";
+                    }
+                    out += "]}\n";
+                } else {
+                    out = "Interpolator: " + name + " (" + std::to_string(model->size()) + " knots)\n";
+                    for (size_t i = 0; i < points.size(); ++i) out += "  f(" + format_number(points[i]) + ") = " + format_number(values[i]) + "\n";
+                }
+                return out;
+            });
+        }
+
+        // Times every stage on each file: loading, the statistics of the columns, the correlation matrix and
+        // the formatting of the text report. The files are read from disk, not from the datasets of the invocation
+        void run_bench(const command& cmd) {
+            if (cmd.inputs.empty())
+                throw std::invalid_argument("The command bench needs at least one input file");
+
+            size_t repetitions = count_value("repetitions", cmd.get("repetitions", "5"));
+            std::string format = cmd.get("format", "json");
+            if (format != "json" && format != "csv")
+                throw std::invalid_argument("Unknown output format for bench: " + format);
+
+            report_options statistics_only;
+            statistics_only.correlation = false;
+            statistics_only.threads = thread_count(cmd);
+            report_options correlation_only;
+            correlation_only.statistics.clear();
+            correlation_only.frequency_counts = false;
+            correlation_only.threads = thread_count(cmd);
+
+            std::vector<bench::record> records;
+            for (const auto& path : cmd.inputs) {
+                auto add = [&](const std::string& stage, double seconds) {
+                    records.push_back({stage, {{"file", path}}, {{"seconds", seconds}}});
+                };
+
+                add("load", bench::median_seconds(repetitions, [&]() { bench::do_not_optimize(dataset::from_csv(path)->size()); }));
+
+                // the statistics are cached by the dataset, so each repetition computes them on a fresh copy
+                auto time_report = [&](const report_options& options) {
+                    std::vector<double> times;
+                    for (size_t i = 0; i < std::max<size_t>(repetitions, 1); ++i) {
+                        auto fresh = dataset::from_csv(path);
+                        bench::timer clock;
+                        bench::do_not_optimize(format_report(*fresh, options).size());
+                        times.push_back(clock.seconds());
+                    }
+                    std::nth_element(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(times.size() / 2), times.end());
+                    return times[times.size() / 2];
+                };
+                add("statistics", time_report(statistics_only));
+                add("correlation", time_report(correlation_only));
+
+                // formatting alone, once every statistic is cached
+                auto ds = dataset::from_csv(path);
+                format_report(*ds);
+                add("report", bench::median_seconds(repetitions, [&]() { bench::do_not_optimize(format_report(*ds).size()); }));
+            }
+
+            std::ostringstream out;
+            if (format == "csv") bench::write_csv(out, records);
+            else bench::write_json(out, records);
+            write_text(cmd.get("output", "-"), out.str());
+        }
+
+        void run_command(const command& cmd, dataset_cache& cache) {
+            if (cmd.name == "stats") run_stats(cmd, cache);
+            else if (cmd.name == "corr") run_corr(cmd, cache);
+            else if (cmd.name == "groupby") run_groupby(cmd, cache);
+            else if (cmd.name == "interpolate") run_interpolate(cmd, cache);
+            else if (cmd.name == "bench") run_bench(cmd);
+            else throw std::invalid_argument("The command " + cmd.name + " cannot be used here");
+        }
+
+        // Runs the jobs of a job file in order, after loading every input file of the jobs concurrently.
+        // A failed job is reported and the next ones still run
+        int run_batch(const command& cmd) {
+            if (cmd.inputs.size() != 1)
+                throw std::invalid_argument("The command batch needs exactly one job file ('-' for the standard input)");
+
+            std::ifstream file;
+            if (cmd.inputs.front() != "-") {
+                file.open(cmd.inputs.front());
+                if (!file.is_open())
+                    throw std::invalid_argument("Unable to open file: " + cmd.inputs.front());
+            }
+            std::istream& in = cmd.inputs.front() == "-" ? std::cin : file;
+
+            std::vector<std::pair<size_t, command>> jobs;
+            std::string line;
+            for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+                auto args = split_arguments(line);
+                if (args.empty() || (!args.front().empty() && args.front().front() == '#')) continue;
+                jobs.emplace_back(line_number, parse_command(args));
+                if (jobs.back().second.name == "batch")
+                    throw std::invalid_argument("Line " + std::to_string(line_number) + ": batch jobs cannot be nested");
+            }
+
+            dataset_cache cache;
+            std::vector<std::string> inputs;
+            for (const auto& [line_number, job] : jobs) {
+                if (job.name != "bench") inputs.insert(inputs.end(), job.inputs.begin(), job.inputs.end());
+            }
+
+            int status = 0;
+            try {
+                cache.load(inputs, thread_count(cmd));
+            } catch (const std::exception& e) {
+                // the jobs using the file that failed report it again, the other ones run
+                std::cerr << "Error: " << e.what() << std::endl;
+                status = 1;
+            }
+
+            for (const auto& [line_number, job] : jobs) {
+                try {
+                    run_command(job, cache);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error in job at line " << line_number << ": " << e.what() << std::endl;
+                    status = 1;
+                }
+            }
+            return status;
+        }
+    }
+
+    bool command::has(const std::string& option) const {
+        return options.count(option) > 0;
+    }
+
+    std::string command::get(const std::string& option, const std::string& fallback) const {
+        auto it = options.find(option);
+        return it == options.end() ? fallback : it->second;
+    }
+
+    command parse_command(const std::vector<std::string>& args) {
+        if (args.empty())
+            throw std::invalid_argument("Missing command");
+
+        command cmd;
+        cmd.name = args.front();
+        auto allowed = command_options.find(cmd.name);
+        if (allowed == command_options.end())
+            throw std::invalid_argument("Unknown command " + cmd.name);
+
+        for (size_t i = 1; i < args.size(); ++i) {
+            const std::string& arg = args[i];
+            if (arg.size() <= 2 || arg.compare(0, 2, "--") != 0) {
+                cmd.inputs.push_back(arg);
+                continue;
+            }
+
+            std::string name = arg.substr(2), value;
+            size_t equals = name.find('=');
+            if (equals != std::string::npos) {
+                value = name.substr(equals + 1);
+                name.resize(equals);
+            } else if (i + 1 < args.size()) {
+                value = args[++i];
+            } else {
+                throw std::invalid_argument("Missing value for option --" + name);
+            }
+
+            if (!allowed->second.count(name))
+                throw std::invalid_argument("Unknown option --" + name + " for the command " + cmd.name);
+            cmd.options[name] = value;
+        }
+        return cmd;
+    }
+
+    std::vector<std::string> split_arguments(const std::string& line) {
+        std::vector<std::string> args;
+        std::string current;
+        bool quoted = false, in_argument = false;
+        for (char c : line) {
+            if (c == '"') {
+                quoted = !quoted;
+                in_argument = true;
+            } else if (!quoted && std::isspace(static_cast<unsigned char>(c))) {
+                if (in_argument) args.push_back(std::move(current));
+                current.clear();
+                in_argument = false;
+            } else {
+                current += c;
+                in_argument = true;
+            }
+        }
+        if (quoted)
+            throw std::invalid_argument("Unterminated quote in: " + line);
+        if (in_argument) args.push_back(std::move(current));
+        return args;
+    }
+
+    void print_usage() {
+        std::cout << "Usage: scientific-computing-toolbox [command [files...] [options]]\n"
+                     "Without arguments the interactive menu is started. CSV files may be compressed with gzip or zstd.\n\n"
+                     "Commands:\n"
+                     "  stats FILE...         statistics of the columns of CSV files\n"
+                     "  corr FILE...          correlation matrix of the numerical columns\n"
+                     "  groupby FILE...       statistics of the columns for each value of the column --by\n"
+                     "  interpolate FILE...   interpolates the column --y over the column --x at the points --at\n"
+                     "  bench FILE...         times loading, statistics, correlation and report of each file\n"
+                     "  batch JOBFILE         runs one command per line of JOBFILE ('-' for the standard input),\n"
+                     "                        every input file is loaded once, concurrently, and shared by the jobs\n\n"
+                     "Options:\n"
+                     "  --columns a,b,c                     columns to report (default all)\n"
+                     "  --statistics mean,median,std_dev,variance\n"
+                     "  --format text|csv|json|markdown     output format (interpolate: text|csv|json, bench: json|csv)\n"
+                     "  --output PATH                       output file, '-' for the standard output (default),\n"
+                     "                                      {name} is replaced by the name of each input file\n"
+                     "  --threads N                         threads loading files and computing statistics\n"
+                     "  --by COLUMN                         groupby: categorical column defining the groups\n"
+                     "  --x COLUMN --y COLUMN               interpolate: columns of the knots\n"
+                     "  --at v1,v2,...                      interpolate: points to interpolate\n"
+                     "  --method linear|polynomial|spline|auto\n"
+                     "                                      interpolate: method (default linear), auto picks the fastest\n"
+                     "                                      one with a held-out error within --budget (default 1e-3)\n"
+                     "  --repetitions N                     bench: repetitions per measurement (default 5)\n";
+    }
+
+    int run(const std::vector<std::string>& args) {
+        if (args.empty() || args.front() == "--help" || args.front() == "-h" || args.front() == "help") {
+            print_usage();
+            return 0;
+        }
+
+        try {
+            command cmd = parse_command(args);
+            if (cmd.name == "batch") return run_batch(cmd);
+
+            dataset_cache cache;
+            run_command(cmd, cache);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef COMMAND_LINE_HPP
+#define COMMAND_LINE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Non-interactive mode of the toolbox executable: "scientific-computing-toolbox stats data.csv --format json".
+// Every subcommand takes input files and --name value options, "batch" runs one command per line of a job
+// file after loading every input file of the jobs once, concurrently.
+
+namespace scitool::cli {
+
+    struct command {
+        std::string name;
+        // positional arguments, the input files
+        std::vector<std::string> inputs;
+        std::map<std::string, std::string> options;
+
+        bool has(const std::string& option) const;
+        std::string get(const std::string& option, const std::string& fallback = "") const;
+    };
+
+    // parses "name [files...] [--option value | --option=value]...", checking the options of the command
+    command parse_command(const std::vector<std::string>& args);
+
+    // splits a line of a job file into arguments, on whitespace outside of double quotes
+    std::vector<std::string> split_arguments(const std::string& line);
+
+    void print_usage();
+
+    // runs the command given by the arguments of the executable (without the program name) and returns
+    // the exit code: 0 on success, 1 when a command failed (the error is written to the standard error)
+    int run(const std::vector<std::string>& args);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scitool {
+
+    // number of threads used when the caller does not ask for a specific count
+    inline size_t default_thread_count() {
+        unsigned count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    // Calls func(i) for every i in [0, n) on up to `threads` threads (0 for one per hardware thread),
+    // the calling thread included. Indices are handed out one at a time, so tasks of uneven cost balance
+    // themselves. The first exception thrown by func stops the remaining tasks and is rethrown to the caller
+    template <typename Func>
+    void parallel_for(size_t n, Func func, size_t threads = 0) {
+        if (threads == 0) threads = default_thread_count();
+        threads = std::min(threads, n);
+        if (threads <= 1) {
+            for (size_t i = 0; i < n; ++i) func(i);
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+                try {
+                    func(i);
+                } catch (...) {
+                    std::lock_guard lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = n;
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool) thread.join();
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    // below this many items per thread, a single thread is faster than starting the others
+    constexpr size_t min_items_per_thread = size_t(1) << 16;
+
+    // Number of slices parallel_slices splits n items into: one per thread (0 for one per hardware thread), but
+    // never less than min_per_thread items per slice, so that small inputs stay on the calling thread
+    inline size_t slice_count(size_t n, size_t threads, size_t min_per_thread = min_items_per_thread) {
+        if (threads == 0) threads = default_thread_count();
+        return std::max<size_t>(1, std::min(threads, n / min_per_thread));
+    }
+
+    // Calls func(slice, begin, end) for `slices` contiguous slices of [0, n) of equal size, each on its own
+    // thread. Callers keeping per-slice buffers size them with the same slice_count
+    template <typename Func>
+    void parallel_slices(size_t n, size_t slices, Func func) {
+        size_t slice = (n + slices - 1) / slices;
+        parallel_for(slices, [&](size_t s) {
+            func(s, std::min(n, s * slice), std::min(n, (s + 1) * slice));
+        }, slices);
+    }
+}
+
+#endif
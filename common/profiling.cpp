@@ -0,0 +1,178 @@
+#include "profiling.hpp"
+#include "text_format.hpp"
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace scitool::profiling {
+
+    namespace {
+        // heap allocations of the current thread, updated by the replaced operator new in profiling builds
+        thread_local std::uint64_t thread_allocations = 0;
+        thread_local std::uint64_t thread_allocated_bytes = 0;
+
+        struct trace_event {
+            const operation* op;
+            std::uint64_t start_ns;
+            std::uint64_t duration_ns;
+            std::uint32_t thread;
+        };
+
+        constexpr size_t max_trace_events = 4u << 20;
+
+        struct registry {
+            std::mutex mutex;
+            // entries are never removed, so the references cached by the call sites stay valid
+            std::map<std::string, std::unique_ptr<operation>> operations;
+            std::map<std::string, std::unique_ptr<std::atomic<std::uint64_t>>> counters;
+
+            std::atomic<bool> tracing{false};
+            std::mutex trace_mutex;
+            std::vector<trace_event> events;
+            std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        };
+
+        registry& instance() {
+            // never destroyed, profiled scopes may still run while static objects are torn down
+            static auto* r = new registry();
+            return *r;
+        }
+
+        std::uint32_t thread_number() {
+            static std::atomic<std::uint32_t> next{0};
+            thread_local std::uint32_t number = next.fetch_add(1);
+            return number;
+        }
+    }
+
+    void detail::record_allocation(std::size_t size) noexcept {
+        ++thread_allocations;
+        thread_allocated_bytes += size;
+    }
+
+    bool enabled() {
+#ifdef SCITOOL_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool allocations_counted() {
+#if defined(SCITOOL_PROFILING) && !defined(_WIN32)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    operation& find_operation(const char* name) {
+        auto& r = instance();
+        std::lock_guard lock(r.mutex);
+        auto& entry = r.operations[name];
+        if (!entry) entry = std::make_unique<operation>(name);
+        return *entry;
+    }
+
+    std::atomic<std::uint64_t>& find_counter(const char* name) {
+        auto& r = instance();
+        std::lock_guard lock(r.mutex);
+        auto& entry = r.counters[name];
+        if (!entry) entry = std::make_unique<std::atomic<std::uint64_t>>(0);
+        return *entry;
+    }
+
+    scope::scope(operation& op)
+            : op(op), start(std::chrono::steady_clock::now()),
+              start_allocations(thread_allocations), start_allocated_bytes(thread_allocated_bytes) {}
+
+    scope::~scope() {
+        auto end = std::chrono::steady_clock::now();
+        auto elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+        op.calls.fetch_add(1, std::memory_order_relaxed);
+        op.nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        op.allocations.fetch_add(thread_allocations - start_allocations, std::memory_order_relaxed);
+        op.allocated_bytes.fetch_add(thread_allocated_bytes - start_allocated_bytes, std::memory_order_relaxed);
+
+        std::uint64_t max = op.max_nanoseconds.load(std::memory_order_relaxed);
+        while (elapsed > max && !op.max_nanoseconds.compare_exchange_weak(max, elapsed, std::memory_order_relaxed)) {}
+
+        auto& r = instance();
+        if (r.tracing.load(std::memory_order_relaxed)) {
+            std::lock_guard lock(r.trace_mutex);
+            auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - r.epoch).count();
+            if (r.events.size() < max_trace_events && offset >= 0)
+                r.events.push_back({&op, static_cast<std::uint64_t>(offset), elapsed, thread_number()});
+        }
+    }
+
+    snapshot take_snapshot() {
+        auto& r = instance();
+        std::lock_guard lock(r.mutex);
+
+        snapshot result;
+        for (const auto& [name, op] : r.operations) {
+            operation_stats stats;
+            stats.name = name;
+            stats.calls = op->calls.load(std::memory_order_relaxed);
+            stats.total_seconds = static_cast<double>(op->nanoseconds.load(std::memory_order_relaxed)) * 1e-9;
+            stats.max_seconds = static_cast<double>(op->max_nanoseconds.load(std::memory_order_relaxed)) * 1e-9;
+            stats.allocations = op->allocations.load(std::memory_order_relaxed);
+            stats.allocated_bytes = op->allocated_bytes.load(std::memory_order_relaxed);
+            result.operations.push_back(std::move(stats));
+        }
+        for (const auto& [name, counter] : r.counters)
+            result.counters[name] = counter->load(std::memory_order_relaxed);
+
+        return result;
+    }
+
+    void reset() {
+        auto& r = instance();
+        {
+            std::lock_guard lock(r.mutex);
+            for (auto& entry : r.operations) {
+                auto& op = *entry.second;
+                op.calls = 0;
+                op.nanoseconds = 0;
+                op.max_nanoseconds = 0;
+                op.allocations = 0;
+                op.allocated_bytes = 0;
+            }
+            for (auto& entry : r.counters) *entry.second = 0;
+        }
+
+        std::lock_guard lock(r.trace_mutex);
+        r.events.clear();
+        r.epoch = std::chrono::steady_clock::now();
+    }
+
+    void set_tracing(bool on) {
+        instance().tracing = on;
+    }
+
+    void write_chrome_trace(std::ostream& out) {
+        auto& r = instance();
+        std::lock_guard lock(r.trace_mutex);
+
+        out << "{\"traceEvents\": [\n";
+        for (size_t i = 0; i < r.events.size(); ++i) {
+            const auto& event = r.events[i];
+            // timestamps and durations are in microseconds
+            out << "  {\"name\": \"" << json_escape(event.op->name) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << event.thread
+                << ", \"ts\": " << static_cast<double>(event.start_ns) / 1e3
+                << ", \"dur\": " << static_cast<double>(event.duration_ns) / 1e3
+                << (i + 1 < r.events.size() ? "},\n" : "}\n");
+        }
+        out << "], \"displayTimeUnit\": \"ms\"}\n";
+    }
+
+    void write_chrome_trace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open())
+            throw std::runtime_error("Unable to open file: " + path);
+        write_chrome_trace(out);
+    }
+}
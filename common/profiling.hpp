@@ -0,0 +1,109 @@
+#ifndef PROFILING_HPP
+#define PROFILING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Opt-in instrumentation of the hot paths of the toolbox.
+//
+// SCITOOL_PROFILE_SCOPE("name") measures the enclosing scope as one call of the operation "name":
+// wall time, and heap allocations made by the thread while in the scope. SCITOOL_PROFILE_COUNT("name", n)
+// adds n to the counter "name" (rows processed, bytes scanned, cache hits, ...).
+// Both macros expand to nothing unless the toolbox is built with SCITOOL_PROFILING defined
+// (cmake -DSCITOOL_PROFILING=ON), so release builds pay nothing for them. In profiling builds every
+// call site resolves its registry entry once, after which recording is a few relaxed atomic updates.
+
+namespace scitool::profiling {
+
+    struct operation_stats {
+        std::string name;
+        std::uint64_t calls = 0;
+        double total_seconds = 0.0;
+        double max_seconds = 0.0;
+        std::uint64_t allocations = 0;
+        std::uint64_t allocated_bytes = 0;
+    };
+
+    struct snapshot {
+        std::vector<operation_stats> operations;
+        std::map<std::string, std::uint64_t> counters;
+    };
+
+    // true when the toolbox was built with SCITOOL_PROFILING
+    bool enabled();
+    // true when the heap allocations of the profiled scopes are counted. The counting operator new replaces the
+    // global one of the process on Linux and macOS, but on Windows every DLL keeps its own: there the allocation
+    // counts would silently read 0, so they are reported as unavailable
+    bool allocations_counted();
+
+    snapshot take_snapshot();
+    // sets every operation and counter back to zero and drops the recorded trace events
+    void reset();
+
+    // when tracing is on, every profiled scope is also recorded as a trace event (up to a few million)
+    void set_tracing(bool on);
+    // writes the recorded trace events in the Chrome trace-event format (chrome://tracing, Perfetto)
+    void write_chrome_trace(std::ostream& out);
+    void write_chrome_trace(const std::string& path);
+
+    // Registry entries, used by the macros below
+    struct operation {
+        explicit operation(std::string name) : name(std::move(name)) {}
+
+        const std::string name;
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> nanoseconds{0};
+        std::atomic<std::uint64_t> max_nanoseconds{0};
+        std::atomic<std::uint64_t> allocations{0};
+        std::atomic<std::uint64_t> allocated_bytes{0};
+    };
+
+    namespace detail {
+        // called by the allocation functions of profiling builds (see profiling_allocations.cpp)
+        void record_allocation(std::size_t size) noexcept;
+    }
+
+    operation& find_operation(const char* name);
+    std::atomic<std::uint64_t>& find_counter(const char* name);
+
+    class scope {
+    public:
+        explicit scope(operation& op);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        operation& op;
+        std::chrono::steady_clock::time_point start;
+        std::uint64_t start_allocations;
+        std::uint64_t start_allocated_bytes;
+    };
+}
+
+#ifdef SCITOOL_PROFILING
+#define SCITOOL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SCITOOL_PROFILE_CONCAT(a, b) SCITOOL_PROFILE_CONCAT_IMPL(a, b)
+#define SCITOOL_PROFILE_SCOPE(name)                                                                   \
+    static ::scitool::profiling::operation& SCITOOL_PROFILE_CONCAT(scitool_profile_op_, __LINE__) = \
+            ::scitool::profiling::find_operation(name);                                               \
+    ::scitool::profiling::scope SCITOOL_PROFILE_CONCAT(scitool_profile_scope_, __LINE__)(             \
+            SCITOOL_PROFILE_CONCAT(scitool_profile_op_, __LINE__))
+#define SCITOOL_PROFILE_COUNT(name, amount)                                                                     \
+    do {                                                                                                        \
+        static std::atomic<std::uint64_t>& scitool_profile_counter = ::scitool::profiling::find_counter(name); \
+        scitool_profile_counter.fetch_add(static_cast<std::uint64_t>(amount), std::memory_order_relaxed);     \
+    } while (false)
+#else
+#define SCITOOL_PROFILE_SCOPE(name) static_cast<void>(0)
+#define SCITOOL_PROFILE_COUNT(name, amount) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#include "profiling.hpp"
+#include <cstdlib>
+#include <new>
+
+#ifdef SCITOOL_PROFILING
+// Counting replacements of the global allocation functions, only in profiling builds. They live in their
+// own file so that the compiler never sees them inlined next to standard containers. The nothrow and
+// array forms of the standard library forward to these ones. On Windows they only replace the allocation
+// functions of this DLL, not those of the other modules, which is why allocations_counted() is false there.
+void* operator new(std::size_t size) {
+    scitool::profiling::detail::record_allocation(size);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
@@ -0,0 +1,22 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+namespace scitool {
+
+    // increment of the splitmix64 sequence, the golden ratio in 64 bits
+    constexpr std::uint64_t golden_gamma = 0x9e3779b97f4a7c15ULL;
+
+    // Finalizer of splitmix64: a bijective mix of 64 bits, where every input bit flips about half of the output
+    // bits. Used to hash keys, to seed random streams and as a counter-based random number generator
+    inline std::uint64_t splitmix64(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+}
+
+#endif
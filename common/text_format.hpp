@@ -0,0 +1,56 @@
+#ifndef TEXT_FORMAT_HPP
+#define TEXT_FORMAT_HPP
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace scitool {
+
+    // Escapes text for the inside of a JSON string: quotes and backslashes, and the control characters,
+    // which JSON does not allow unescaped, as \u00XX
+    inline std::string json_escape(std::string_view text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    // text as a CSV field, quoted when it holds a separator, a quote or a line break (quotes are doubled)
+    inline std::string csv_field(std::string_view text) {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos) return std::string(text);
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    // appends the shortest representation of value that reads back to the same value
+    inline void append_number(std::string& out, double value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    inline std::string format_number(double value) {
+        std::string text;
+        append_number(text, value);
+        return text;
+    }
+}
+
+#endif
@@ -1,34 +1,194 @@
 #include "cardinal_cubic_bspline_Interpolator.hpp"
+#include "profiling.hpp"
+#include <cmath>
 
 namespace scitool {
-    cardinal_cubic_bspline_interpolator::cardinal_cubic_bspline_interpolator(const std::vector<point> &points)
-            : interpolator(points) {
+    namespace {
+        // the cubic B-spline centered on 0 and its first two derivatives
+        double b3_spline(double x) {
+            double absx = std::abs(x);
+            if (absx < 1) {
+                double y = 2 - absx;
+                double z = 1 - absx;
+                return (1.0 / 6.0) * (y * y * y - 4 * z * z * z);
+            }
+            if (absx < 2) {
+                double y = 2 - absx;
+                return (1.0 / 6.0) * y * y * y;
+            }
+            return 0.0;
+        }
+
+        double b3_spline_prime(double x) {
+            if (x < 0) return -b3_spline_prime(-x);
+            if (x < 1) return x * (1.5 * x - 2);
+            if (x < 2) return -0.5 * (2 - x) * (2 - x);
+            return 0.0;
+        }
+
+        double b3_spline_double_prime(double x) {
+            if (x < 0) return b3_spline_double_prime(-x);
+            if (x < 1) return 3 * x - 2;
+            if (x < 2) return 2 - x;
+            return 0.0;
+        }
+    }
+
+    cardinal_cubic_bspline_interpolator::cardinal_cubic_bspline_interpolator(const table_reader &table)
+            : interpolator(table), coefficients(table.array<double>(2, x_values.size() + 2)),
+              cumulative_integral(table.array<double>(3, x_values.size())) {
+        table_array<double> parameters = table.array<double>(4, 2);
+        step_inverse = parameters[0];
+        average = parameters[1];
+    }
+
+    void cardinal_cubic_bspline_interpolator::init() {
 
-        if (points.size() < 5)
+        if (x_values.size() < 5)
             throw std::invalid_argument("At least five points are needed to perform the Cardinal Cubic interpolation");
 
-        double distance = points[1].x - points[0].x;
-        std::vector<double> function_values{points[0].y, points[1].y};
+        // the spacing is taken over the whole table; knots computed as start + i * step differ from the
+        // exact grid by a few ulps, which the spline (that recomputes the grid itself) does not care about
+        double distance = (x_values.back() - x_values.front()) / static_cast<double>(x_values.size() - 1);
+        double tolerance = 1e-8 * distance;
 
-        for (int i = 2; i < (int) points.size(); i++) {
-            if (points[i].x - points[i - 1].x != distance) {
+        for (size_t i = 1; i < x_values.size(); i++) {
+            if (std::abs(x_values[i] - x_values[i - 1] - distance) > tolerance) {
                 throw std::invalid_argument("Points do not have equal distance");
             }
-            function_values.push_back(points[i].y);
         }
 
-        spline = boost::math::interpolators::cardinal_cubic_b_spline<double>(
-                function_values.begin(), function_values.end(), points[0].x, distance
-        );
+        step_inverse = 1 / distance;
+        const double *f = y_values.data();
+        size_t length = y_values.size(), n = length - 1;
 
+        // derivatives at the ends, from one-sided finite differences of order 4
+        double t0 = 4 * (f[1] + (1.0 / 3.0) * f[3]);
+        double t1 = -(25 * (1.0 / 3.0) * f[0] + f[4]) / 4 - 3 * f[2];
+        double a1 = step_inverse * (t0 + t1);
+        t0 = 4 * (f[n - 3] + (1.0 / 3.0) * f[n - 1]);
+        t1 = -(25 * (1.0 / 3.0) * f[n - 4] + f[n]) / 4 - 3 * f[n - 2];
+        double b1 = step_inverse * (t0 + t1);
+
+        average = 0.0;
+        double t = 1;
+        for (size_t i = 0; i < length; ++i) {
+            average += (f[i] - average) / t;
+            t += 1;
+        }
+
+        // the system is tridiagonal (1 4 1) but for its first and last rows (1 0 -1), which are
+        // reduced first (Kress, equations 8.41)
+        std::vector<double> rhs(length + 2), super_diagonal(length + 2), beta(length + 2);
+        rhs[0] = -2 * distance * a1;
+        rhs[rhs.size() - 1] = -2 * distance * b1;
+        super_diagonal[0] = 0;
+        for (size_t i = 1; i < rhs.size() - 1; ++i) {
+            rhs[i] = 6 * (f[i - 1] - average);
+            super_diagonal[i] = 1;
+        }
+
+        super_diagonal[1] = 0.5;
+        rhs[1] = (rhs[1] - rhs[0]) / 4;
+        for (size_t i = 2; i < rhs.size() - 1; ++i) {
+            double diagonal = 4 - super_diagonal[i - 1];
+            rhs[i] = (rhs[i] - rhs[i - 1]) / diagonal;
+            super_diagonal[i] /= diagonal;
+        }
+
+        double final_subdiagonal = -super_diagonal[rhs.size() - 3];
+        rhs[rhs.size() - 1] = (rhs[rhs.size() - 1] - rhs[rhs.size() - 3]) / final_subdiagonal;
+        double final_diagonal = -1 / final_subdiagonal;
+        final_diagonal = final_diagonal - super_diagonal[rhs.size() - 2];
+        rhs[rhs.size() - 1] = rhs[rhs.size() - 1] - rhs[rhs.size() - 2];
+
+        beta[rhs.size() - 1] = rhs[rhs.size() - 1] / final_diagonal;
+        for (size_t i = rhs.size() - 2; i > 0; --i) {
+            beta[i] = rhs[i] - super_diagonal[i] * beta[i + 1];
+        }
+        beta[0] = beta[2] + rhs[0];
+        coefficients = std::move(beta);
+
+        std::vector<double> integral;
+        integral.reserve(x_values.size());
+        integral.push_back(0.0);
+        for (size_t i = 1; i < x_values.size(); i++) {
+            integral.push_back(integral.back() + segment_integral(x_values[i - 1], x_values[i]));
+        }
+        cumulative_integral = std::move(integral);
     }
 
-    double cardinal_cubic_bspline_interpolator::operator()(double point) const {
+    void cardinal_cubic_bspline_interpolator::save(const std::string &path) const {
+        table_array<double> parameters(std::vector<double>{step_inverse, average});
+        table_writer table(table_kind::cardinal_cubic_bspline);
+        table.add(x_values);
+        table.add(y_values);
+        table.add(coefficients);
+        table.add(cumulative_integral);
+        table.add(parameters);
+        table.write(path);
+    }
+
+    double cardinal_cubic_bspline_interpolator::spline(double x_val, int order) const {
+        // only the (at most 5) B-splines whose support contains x_val contribute
+        double t = step_inverse * (x_val - x_values[0]) + 1;
+        auto k_min = static_cast<size_t>(std::max(0L, static_cast<long>(std::ceil(t - 2))));
+        auto k_max = static_cast<size_t>(std::max(std::min(static_cast<long>(coefficients.size() - 1), static_cast<long>(std::floor(t + 2))), 0L));
 
-        if (point < points[0].x || point > points[points.size() - 1].x) {
-            throw std::out_of_range("Interpolation point out of range");
+        double z = order == 0 ? average : 0.0;
+        for (size_t k = k_min; k <= k_max; ++k) {
+            double basis = order == 0 ? b3_spline(t - k) : order == 1 ? b3_spline_prime(t - k) : b3_spline_double_prime(t - k);
+            z += coefficients[k] * basis;
         }
 
+        if (order == 1) return z * step_inverse;
+        if (order == 2) return z * step_inverse * step_inverse;
+        return z;
+    }
+
+    double cardinal_cubic_bspline_interpolator::operator()(double point) const {
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", 1);
+
+        check_range(point);
+
         return spline(point);
     }
-}
\ No newline at end of file
+
+    double cardinal_cubic_bspline_interpolator::derivative(double x_val, int order) const {
+        if (order < 0)
+            throw std::invalid_argument("The derivative order must not be negative");
+
+        check_range(x_val);
+
+        switch (order) {
+            case 0:
+            case 1:
+            case 2:
+                return spline(x_val, order);
+            case 3: {
+                // the spline is a cubic on each segment, so its third derivative is constant there
+                size_t i = segment_index(x_val);
+                return (spline(x_values[i + 1], 2) - spline(x_values[i], 2)) / (x_values[i + 1] - x_values[i]);
+            }
+            default:
+                return 0.0;
+        }
+    }
+
+    double cardinal_cubic_bspline_interpolator::segment_integral(double lo, double hi) const {
+        // Simpson's rule is exact for cubics, and the spline is a cubic between two knots
+        return (hi - lo) / 6.0 * (spline(lo) + 4.0 * spline((lo + hi) / 2.0) + spline(hi));
+    }
+
+    double cardinal_cubic_bspline_interpolator::antiderivative(double x_val) const {
+        size_t i = segment_index(x_val);
+        return cumulative_integral[i] + segment_integral(x_values[i], x_val);
+    }
+
+    double cardinal_cubic_bspline_interpolator::integrate(double a, double b) const {
+        check_range(a);
+        check_range(b);
+
+        return antiderivative(b) - antiderivative(a);
+    }
+}
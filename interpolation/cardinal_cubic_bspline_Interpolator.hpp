@@ -1,18 +1,52 @@
 #ifndef CARDINAL_CUBIC_B_SPLINE_INTERPOLATOR_HPP
 #define CARDINAL_CUBIC_B_SPLINE_INTERPOLATOR_HPP
 #include "interpolator.hpp"
-#include <boost/math/interpolators/cardinal_cubic_b_spline.hpp>
 
 namespace scitool {
+    // Cubic B-spline on uniformly spaced knots, with the end derivatives estimated from the data (the
+    // algorithm of boost::math::interpolators::cardinal_cubic_b_spline, whose coefficients are kept here
+    // so that a saved spline is used without solving its system again)
     class cardinal_cubic_bspline_interpolator : public interpolator {
     private:
-        boost::math::interpolators::cardinal_cubic_b_spline<double> spline;
+        // coefficients of the n + 2 B-splines centered on the knots and one step beyond each end
+        table_array<double> coefficients;
+        // cumulative_integral[i] is the integral of the spline between the first knot and x_values[i]
+        table_array<double> cumulative_integral;
+        // the spline is fitted to the values minus their average
+        double step_inverse = 0.0;
+        double average = 0.0;
+
+        void init();
+        // value (order 0) or derivative of the spline
+        double spline(double x_val, int order = 0) const;
+        double segment_integral(double lo, double hi) const;
+        double antiderivative(double x_val) const;
+
     public:
-        cardinal_cubic_bspline_interpolator(const std::vector<point> &points);
+        cardinal_cubic_bspline_interpolator(const std::vector<point> &points)
+                : interpolator(points) {
+            init();
+        }
+
+        template<typename X, typename Y, if_knot_array<X> = 0, if_knot_array<Y> = 0>
+        cardinal_cubic_bspline_interpolator(X &&x, Y &&y)
+                : interpolator(std::forward<X>(x), std::forward<Y>(y)) {
+            init();
+        }
+
+        cardinal_cubic_bspline_interpolator(const double *x, const double *y, size_t n)
+                : interpolator(x, y, n) {
+            init();
+        }
+
+        explicit cardinal_cubic_bspline_interpolator(const table_reader &table);
 
         double operator()(double point) const override;
+        double derivative(double x_val, int order = 1) const override;
+        double integrate(double a, double b) const override;
+        void save(const std::string &path) const override;
     };
 }
 
 
-#endif
\ No newline at end of file
+#endif
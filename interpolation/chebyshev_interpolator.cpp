@@ -0,0 +1,338 @@
+#include "chebyshev_interpolator.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace scitool {
+    namespace {
+        // keeps the work buffers of derivative and integrate on the stack
+        constexpr size_t max_degree = 64;
+        // queries evaluated together by evaluate
+        constexpr size_t lanes = 8;
+        const double pi = std::acos(-1.0);
+
+        // value at t of the Chebyshev series with the given coefficients (Clenshaw's recurrence)
+        double clenshaw(const double *c, size_t count, double t) {
+            double b1 = 0.0, b2 = 0.0;
+            for (size_t k = count - 1; k > 0; k--) {
+                double b = 2.0 * t * b1 - b2 + c[k];
+                b2 = b1;
+                b1 = b;
+            }
+            return t * b1 - b2 + c[0];
+        }
+
+        struct segment_fit {
+            double lo = 0.0, hi = 0.0;
+            std::vector<double> coefficients;
+            double error = 0.0;
+            // largest absolute value of the function seen on the segment
+            double magnitude = 0.0;
+            double left = 0.0, right = 0.0;
+        };
+
+        double sample(const std::function<double(double)> &function, double x) {
+            double y = function(x);
+            if (!std::isfinite(y))
+                throw std::invalid_argument("The function is not finite at x = " + std::to_string(x));
+            return y;
+        }
+
+        // nodes: Chebyshev points of the first kind on [-1, 1]; basis[k * n + j] = T_k(nodes[j]);
+        // checks: the extrema of T_n between the nodes, where the interpolation error is largest
+        segment_fit fit_segment(const std::function<double(double)> &function, double lo, double hi,
+                                const std::vector<double> &nodes, const std::vector<double> &basis,
+                                const std::vector<double> &checks) {
+            size_t n = nodes.size();
+            auto at = [lo, hi](double t) { return lo + (hi - lo) * (t + 1.0) / 2.0; };
+
+            segment_fit fit;
+            fit.lo = lo;
+            fit.hi = hi;
+            std::vector<double> values(n);
+            for (size_t j = 0; j < n; j++) {
+                values[j] = sample(function, at(nodes[j]));
+                fit.magnitude = std::max(fit.magnitude, std::abs(values[j]));
+            }
+
+            // discrete Chebyshev transform of the samples
+            fit.coefficients.assign(n, 0.0);
+            for (size_t k = 0; k < n; k++) {
+                double sum = 0.0;
+                for (size_t j = 0; j < n; j++) sum += values[j] * basis[k * n + j];
+                fit.coefficients[k] = (k == 0 ? 1.0 : 2.0) * sum / static_cast<double>(n);
+            }
+
+            // the ends are sampled at the exact knots, which the next segment shares
+            fit.left = sample(function, lo);
+            fit.right = sample(function, hi);
+            fit.error = std::max(std::abs(clenshaw(fit.coefficients.data(), n, -1.0) - fit.left),
+                                 std::abs(clenshaw(fit.coefficients.data(), n, 1.0) - fit.right));
+            fit.magnitude = std::max({fit.magnitude, std::abs(fit.left), std::abs(fit.right)});
+            for (double t : checks) {
+                double y = sample(function, at(t));
+                fit.error = std::max(fit.error, std::abs(clenshaw(fit.coefficients.data(), n, t) - y));
+                fit.magnitude = std::max(fit.magnitude, std::abs(y));
+            }
+            return fit;
+        }
+    }
+
+    chebyshev_interpolator::chebyshev_interpolator(const std::function<double(double)> &function, double a, double b,
+                                                   const approximation_options &options)
+            : chebyshev_interpolator(build(function, a, b, options), options.degree) {}
+
+    chebyshev_interpolator::chebyshev_interpolator(table &&built, size_t degree)
+            : interpolator(std::move(built.breaks), std::move(built.values)), stride(degree + 1),
+              coefficients(std::move(built.coefficients)), estimated_error(built.error_estimate),
+              evaluations(built.function_evaluations) {
+        init();
+    }
+
+    chebyshev_interpolator::chebyshev_interpolator(const table_reader &table)
+            : interpolator(table), stride(0), estimated_error(0.0), evaluations(0) {
+        table_array<double> parameters = table.array<double>(2, 4);
+        stride = static_cast<size_t>(parameters[0]);
+        cell_scale = parameters[1];
+        estimated_error = parameters[2];
+        evaluations = static_cast<size_t>(parameters[3]);
+        if (stride == 0 || stride > max_degree + 1)
+            table.corrupt("the degree of its segments is invalid");
+
+        coefficients = table.array<double>(3, segment_count() * stride);
+        cumulative_integral = table.array<double>(4, x_values.size());
+        cell_segment = table.array<std::uint32_t>(5);
+        if (cell_segment.empty())
+            table.corrupt("its segment index is empty");
+    }
+
+    void chebyshev_interpolator::save(const std::string &path) const {
+        table_array<double> parameters(std::vector<double>{static_cast<double>(stride), cell_scale, estimated_error,
+                                                           static_cast<double>(evaluations)});
+        table_writer table(table_kind::chebyshev);
+        table.add(x_values);
+        table.add(y_values);
+        table.add(parameters);
+        table.add(coefficients);
+        table.add(cumulative_integral);
+        table.add(cell_segment);
+        table.write(path);
+    }
+
+    chebyshev_interpolator::table chebyshev_interpolator::build(const std::function<double(double)> &function, double a, double b,
+                                                                const approximation_options &options) {
+        SCITOOL_PROFILE_SCOPE("interpolator.build");
+        if (!std::isfinite(a) || !std::isfinite(b) || !(a < b))
+            throw std::invalid_argument("The interval must have finite ends with a < b");
+        if (!(options.max_error > 0.0))
+            throw std::invalid_argument("The maximum error must be positive");
+        if (options.degree == 0 || options.degree > max_degree)
+            throw std::invalid_argument("The degree must be between 1 and " + std::to_string(max_degree));
+        if (options.initial_segments == 0 || options.initial_segments > options.max_segments)
+            throw std::invalid_argument("The initial segments must be between 1 and the maximum number of segments");
+        if (options.max_segments > UINT32_MAX)
+            throw std::invalid_argument("At most 2^32 - 1 segments are supported");
+
+        size_t n = options.degree + 1;
+        std::vector<double> nodes(n), basis(n * n), checks;
+        for (size_t j = 0; j < n; j++) {
+            double theta = pi * (static_cast<double>(j) + 0.5) / static_cast<double>(n);
+            nodes[j] = std::cos(theta);
+            for (size_t k = 0; k < n; k++) basis[k * n + j] = std::cos(static_cast<double>(k) * theta);
+        }
+        for (size_t j = 1; j < n; j++) checks.push_back(std::cos(pi * static_cast<double>(j) / static_cast<double>(n)));
+
+        // halving stops there, e.g. around a discontinuity
+        double min_width = (b - a) * 1e-12;
+        // differences below the rounding of the values cannot be resolved by any segment size
+        double rounding = 16.0 * std::numeric_limits<double>::epsilon();
+
+        std::vector<std::pair<double, double>> pending;
+        for (size_t i = 0; i < options.initial_segments; i++) {
+            double lo = i == 0 ? a : pending.back().second;
+            double hi = i + 1 == options.initial_segments ? b : a + (b - a) * static_cast<double>(i + 1) / static_cast<double>(options.initial_segments);
+            pending.emplace_back(lo, hi);
+        }
+
+        // every round fits the pending segments in parallel and halves the ones that miss the target
+        table built;
+        std::vector<segment_fit> accepted;
+        while (!pending.empty()) {
+            std::vector<segment_fit> fits(pending.size());
+            parallel_for(pending.size(), [&](size_t s) {
+                fits[s] = fit_segment(function, pending[s].first, pending[s].second, nodes, basis, checks);
+            }, options.threads);
+            built.function_evaluations += pending.size() * (2 * n + 1);
+
+            std::vector<std::pair<double, double>> next;
+            for (auto &fit : fits) {
+                double mid = fit.lo + (fit.hi - fit.lo) / 2.0;
+                if (fit.error <= std::max(options.max_error, rounding * fit.magnitude) || fit.hi - fit.lo <= min_width) {
+                    accepted.push_back(std::move(fit));
+                } else {
+                    next.emplace_back(fit.lo, mid);
+                    next.emplace_back(mid, fit.hi);
+                }
+            }
+            if (accepted.size() + next.size() > options.max_segments)
+                throw std::runtime_error("More than " + std::to_string(options.max_segments) +
+                                         " segments are needed to reach the maximum error");
+            pending.swap(next);
+        }
+
+        std::sort(accepted.begin(), accepted.end(), [](const segment_fit &l, const segment_fit &r) { return l.lo < r.lo; });
+        built.coefficients.reserve(accepted.size() * n);
+        for (const auto &fit : accepted) {
+            built.breaks.push_back(fit.lo);
+            built.values.push_back(fit.left);
+            built.coefficients.insert(built.coefficients.end(), fit.coefficients.begin(), fit.coefficients.end());
+            built.error_estimate = std::max(built.error_estimate, fit.error);
+        }
+        built.breaks.push_back(b);
+        built.values.push_back(accepted.back().right);
+        return built;
+    }
+
+    void chebyshev_interpolator::init() {
+        size_t segments = segment_count();
+
+        std::vector<double> integral;
+        integral.reserve(x_values.size());
+        integral.push_back(0.0);
+        for (size_t i = 0; i < segments; i++) {
+            // the integral of T_k over [-1, 1] is 0 for odd k and 2 / (1 - k^2) for even k
+            const double *c = &coefficients[i * stride];
+            double segment_integral = 0.0;
+            for (size_t k = 0; k < stride; k += 2)
+                segment_integral += c[k] * 2.0 / (1.0 - static_cast<double>(k * k));
+            integral.push_back(integral.back() + segment_integral * (x_values[i + 1] - x_values[i]) / 2.0);
+        }
+        cumulative_integral = std::move(integral);
+
+        // four cells per segment: with segments obtained by halving, a cell rarely overlaps more than two
+        size_t cells = 4 * segments;
+        cell_scale = static_cast<double>(cells) / (x_values.back() - x_values.front());
+        std::vector<std::uint32_t> first_segment(cells);
+        size_t i = 0;
+        for (size_t cell = 0; cell < cells; cell++) {
+            double start = x_values.front() + static_cast<double>(cell) / cell_scale;
+            while (i + 1 < segments && x_values[i + 1] <= start) i++;
+            first_segment[cell] = static_cast<std::uint32_t>(i);
+        }
+        cell_segment = std::move(first_segment);
+    }
+
+    size_t chebyshev_interpolator::find_segment(double x_val) const {
+        auto cell = static_cast<size_t>((x_val - x_values.front()) * cell_scale);
+        size_t i = cell_segment[std::min(cell, cell_segment.size() - 1)];
+        // the cell gives the first segment it overlaps, the following ones are scanned
+        // (and the previous one, when the cell of x_val was rounded up)
+        while (i + 2 < x_values.size() && x_val >= x_values[i + 1]) i++;
+        while (i > 0 && x_val < x_values[i]) i--;
+        return i;
+    }
+
+    double chebyshev_interpolator::value_in_segment(size_t i, double t) const {
+        return clenshaw(&coefficients[i * stride], stride, t);
+    }
+
+    double chebyshev_interpolator::operator()(double point) const {
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", 1);
+        check_range(point);
+
+        size_t i = find_segment(point);
+        return value_in_segment(i, local(i, point));
+    }
+
+    void chebyshev_interpolator::evaluate(const double *x, double *result, size_t n) const {
+        SCITOOL_PROFILE_SCOPE("interpolator.evaluate");
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", n);
+
+        // a single recurrence is a chain of dependent multiply-adds; running the recurrences of eight
+        // queries side by side in fixed-size loops keeps the floating-point units busy and lets the
+        // compiler vectorize them
+        double lo = x_values.front(), hi = x_values.back();
+        for (size_t start = 0; start < n; start += lanes) {
+            size_t count = std::min(lanes, n - start);
+            const double *c[lanes];
+            double t[lanes], b1[lanes], b2[lanes];
+            for (size_t l = 0; l < lanes; l++) {
+                // a last incomplete block repeats its last query
+                double x_val = x[start + std::min(l, count - 1)];
+                if (!(x_val >= lo && x_val <= hi)) check_range(x_val);
+                size_t i = find_segment(x_val);
+                c[l] = &coefficients[i * stride];
+                t[l] = local(i, x_val);
+                b1[l] = 0.0;
+                b2[l] = 0.0;
+            }
+
+            for (size_t k = stride - 1; k > 0; k--) {
+                for (size_t l = 0; l < lanes; l++) {
+                    double b = 2.0 * t[l] * b1[l] - b2[l] + c[l][k];
+                    b2[l] = b1[l];
+                    b1[l] = b;
+                }
+            }
+
+            for (size_t l = 0; l < count; l++)
+                result[start + l] = t[l] * b1[l] - b2[l] + c[l][0];
+        }
+    }
+
+    double chebyshev_interpolator::derivative(double x_val, int order) const {
+        if (order < 0)
+            throw std::invalid_argument("The derivative order must not be negative");
+
+        check_range(x_val);
+        if (order == 0) return (*this)(x_val);
+        if (static_cast<size_t>(order) >= stride) return 0.0;
+
+        // at a knot the segment on the right is used, as for the other interpolators
+        size_t i = find_segment(x_val);
+        double series[max_degree + 2] = {}, derived[max_degree + 2] = {};
+        std::copy(&coefficients[i * stride], &coefficients[i * stride] + stride, series);
+
+        // d/dt of sum c_k T_k(t): d_{k-1} = d_{k+1} + 2 k c_k, with the first coefficient halved
+        size_t count = stride;
+        for (int o = 0; o < order; o++) {
+            derived[count - 1] = 0.0;
+            derived[count] = 0.0;
+            for (size_t k = count - 1; k > 0; k--)
+                derived[k - 1] = derived[k + 1] + 2.0 * static_cast<double>(k) * series[k];
+            derived[0] /= 2.0;
+            count--;
+            std::copy(derived, derived + count, series);
+        }
+
+        double scale = 2.0 / (x_values[i + 1] - x_values[i]);
+        return clenshaw(series, count, local(i, x_val)) * std::pow(scale, order);
+    }
+
+    double chebyshev_interpolator::antiderivative(double x_val) const {
+        size_t i = find_segment(x_val);
+        const double *c = &coefficients[i * stride];
+
+        // integral of sum c_k T_k: C_1 = c_0 - c_2 / 2, C_k = (c_{k-1} - c_{k+1}) / 2k, taken from t = -1
+        double series[max_degree + 2] = {};
+        double at_start = 0.0;
+        for (size_t k = 1; k <= stride; k++) {
+            double previous = k == 1 ? 2.0 * c[0] : c[k - 1];
+            double following = k + 1 < stride ? c[k + 1] : 0.0;
+            series[k] = (previous - following) / (2.0 * static_cast<double>(k));
+            at_start += k % 2 == 0 ? series[k] : -series[k];
+        }
+
+        double half_width = (x_values[i + 1] - x_values[i]) / 2.0;
+        return cumulative_integral[i] + half_width * (clenshaw(series, stride + 1, local(i, x_val)) - at_start);
+    }
+
+    double chebyshev_interpolator::integrate(double a, double b) const {
+        check_range(a);
+        check_range(b);
+
+        return antiderivative(b) - antiderivative(a);
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef CHEBYSHEV_INTERPOLATOR_HPP
+#define CHEBYSHEV_INTERPOLATOR_HPP
+#include "interpolator.hpp"
+#include <cstdint>
+#include <functional>
+
+namespace scitool {
+
+    struct approximation_options {
+        // maximum absolute error allowed on every segment
+        double max_error = 1e-8;
+        // degree of the Chebyshev polynomial of each segment (3 gives a piecewise cubic table)
+        size_t degree = 8;
+        // equal segments the interval is split into before refining
+        size_t initial_segments = 16;
+        // the build fails rather than produce a larger table (e.g. for a noisy function)
+        size_t max_segments = 1 << 20;
+        // threads sampling the function, 0 for one per hardware thread; the function must then be thread-safe
+        size_t threads = 0;
+    };
+
+    // Piecewise Chebyshev approximation of a function on [a, b], built as a replacement for an expensive
+    // function (e.g. a model evaluated in a loop). Every segment is sampled at the Chebyshev nodes of the
+    // given degree and checked against the function between the nodes and at its ends; segments with a
+    // larger error than max_error are halved until they meet it, so the segments are small only where the
+    // function needs them. The ends of the segments are the knots of the interpolator.
+    class chebyshev_interpolator : public interpolator {
+    private:
+        // the segments found by the refinement, before they become knots
+        struct table {
+            std::vector<double> breaks;
+            std::vector<double> values;
+            std::vector<double> coefficients;
+            double error_estimate = 0.0;
+            size_t function_evaluations = 0;
+        };
+
+        size_t stride;
+        // coefficients of the polynomial of segment i in the Chebyshev basis of [x_values[i], x_values[i + 1]],
+        // stored from coefficients[i * stride]
+        table_array<double> coefficients;
+        // cumulative_integral[i] is the integral between the first knot and x_values[i]
+        table_array<double> cumulative_integral;
+        // first segment overlapping each of the equal cells of the interval, so the segment of a point
+        // is found in constant time whatever the size of the segments
+        table_array<std::uint32_t> cell_segment;
+        double cell_scale = 0.0;
+        double estimated_error;
+        size_t evaluations;
+
+        chebyshev_interpolator(table &&built, size_t degree);
+        static table build(const std::function<double(double)> &function, double a, double b, const approximation_options &options);
+
+        void init();
+        size_t find_segment(double x_val) const;
+        // position of x_val in [-1, 1] over segment i
+        double local(size_t i, double x_val) const {
+            return (2.0 * x_val - x_values[i] - x_values[i + 1]) / (x_values[i + 1] - x_values[i]);
+        }
+        double value_in_segment(size_t i, double t) const;
+        double antiderivative(double x_val) const;
+
+    public:
+        chebyshev_interpolator(const std::function<double(double)> &function, double a, double b,
+                               const approximation_options &options = {});
+
+        explicit chebyshev_interpolator(const table_reader &table);
+
+        double operator()(double point) const override;
+        // interpolates eight values at a time, interleaving their evaluation
+        void evaluate(const double *x, double *result, size_t n) const override;
+        double derivative(double x_val, int order = 1) const override;
+        double integrate(double a, double b) const override;
+        void save(const std::string &path) const override;
+
+        size_t segment_count() const {
+            return x_values.size() - 1;
+        }
+
+        size_t degree() const {
+            return stride - 1;
+        }
+
+        // largest error found when checking the segments against the function. It can exceed max_error
+        // where segments could not be halved any further (discontinuities) or where the values are too
+        // large for the rounding of double precision to allow it
+        double error_estimate() const {
+            return estimated_error;
+        }
+
+        // calls made to the function during the build
+        size_t function_evaluations() const {
+            return evaluations;
+        }
+    };
+}
+
+#endif
@@ -1,19 +1,159 @@
 #include "interpolator.hpp"
+#include "profiling.hpp"
+#include <boost/math/quadrature/gauss_kronrod.hpp>
+#include <cmath>
+#include <numeric>
 
 namespace scitool {
-    interpolator::interpolator(const std::vector<point> &points)
-            : points(points) {
+    interpolator::interpolator(const std::vector<point> &points) {
+        std::vector<double> x, y;
+        x.reserve(points.size());
+        y.reserve(points.size());
+        for (const auto &p : points) {
+            x.push_back(p.x);
+            y.push_back(p.y);
+        }
 
-        // sorting points by x-value makes calculation easier for all interpolators
-        std::sort(this->points.begin(), this->points.end(), [](const point &a, const point &b) {
-            return a.x < b.x;
-        });
+        prepare_knots(x, y);
+        x_values = std::move(x);
+        y_values = std::move(y);
+    }
+
+    interpolator::interpolator(std::vector<double> x, std::vector<double> y) {
+        if (x.size() != y.size())
+            throw std::invalid_argument("The \"x\" and \"y\" arrays must have the same size");
+
+        prepare_knots(x, y);
+        x_values = std::move(x);
+        y_values = std::move(y);
+    }
+
+    interpolator::interpolator(const double *x, const double *y, size_t n)
+            : interpolator(std::vector<double>(x, x + n), std::vector<double>(y, y + n)) {}
+
+    interpolator::interpolator(const table_reader &table)
+            : x_values(table.array<double>(0)), y_values(table.array<double>(1, x_values.size())) {
+        if (x_values.size() < 2)
+            table.corrupt("it has less than two knots");
+    }
+
+    void interpolator::prepare_knots(std::vector<double> &x_values, std::vector<double> &y_values) {
+        SCITOOL_PROFILE_SCOPE("interpolator.build");
+        // pairs with a NaN coordinate are missing values, which cannot be interpolated
+        auto is_missing = [](double value) { return std::isnan(value); };
+        if (std::any_of(x_values.begin(), x_values.end(), is_missing) ||
+            std::any_of(y_values.begin(), y_values.end(), is_missing)) {
+            size_t kept = 0;
+            for (size_t i = 0; i < x_values.size(); i++) {
+                if (is_missing(x_values[i]) || is_missing(y_values[i])) continue;
+                x_values[kept] = x_values[i];
+                y_values[kept] = y_values[i];
+                kept++;
+            }
+            x_values.resize(kept);
+            y_values.resize(kept);
+        }
+
+        // sorting points by x-value makes calculation easier for all interpolators.
+        // Tables are usually generated in order already, which is checked in linear time
+        if (!std::is_sorted(x_values.begin(), x_values.end())) {
+            std::vector<size_t> order(x_values.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&x_values](size_t a, size_t b) {
+                return x_values[a] < x_values[b];
+            });
 
-        for (int i = 1; i < (int) points.size(); i++)
-            if (points[i].x == points[i - 1].x)
+            std::vector<double> sorted_x(order.size()), sorted_y(order.size());
+            for (size_t i = 0; i < order.size(); i++) {
+                sorted_x[i] = x_values[order[i]];
+                sorted_y[i] = y_values[order[i]];
+            }
+            x_values.swap(sorted_x);
+            y_values.swap(sorted_y);
+        }
+
+        for (size_t i = 1; i < x_values.size(); i++)
+            if (x_values[i] == x_values[i - 1])
                 throw std::invalid_argument("Two points have the same value for \"x\"");
 
-        if (points.size() < 2)
+        if (x_values.size() < 2)
             throw std::invalid_argument("At least two points are needed to perform interpolation");
     }
-}
\ No newline at end of file
+
+    std::vector<point> interpolator::get_points() const {
+        std::vector<point> points;
+        points.reserve(x_values.size());
+        for (size_t i = 0; i < x_values.size(); i++)
+            points.emplace_back(x_values[i], y_values[i]);
+        return points;
+    }
+
+    void interpolator::save(const std::string &) const {
+        throw std::runtime_error("This interpolator cannot be saved");
+    }
+
+    void interpolator::check_range(double x_val) const {
+        if (x_val < x_values.front() || x_val > x_values.back()) {
+            throw std::out_of_range("Interpolation point out of range");
+        }
+    }
+
+    size_t interpolator::segment_index(double x_val) const {
+        auto it = std::upper_bound(x_values.begin(), x_values.end(), x_val);
+        size_t index = it == x_values.begin() ? 0 : static_cast<size_t>(it - x_values.begin()) - 1;
+        return std::min(index, x_values.size() - 2);
+    }
+
+    void interpolator::evaluate(const double *x, double *result, size_t n) const {
+        SCITOOL_PROFILE_SCOPE("interpolator.evaluate");
+        for (size_t i = 0; i < n; i++)
+            result[i] = (*this)(x[i]);
+    }
+
+    double interpolator::derivative(double x_val, int order) const {
+        if (order < 0)
+            throw std::invalid_argument("The derivative order must not be negative");
+
+        check_range(x_val);
+        if (order == 0) return (*this)(x_val);
+
+        double lo = x_values.front(), hi = x_values.back();
+
+        // step balancing the truncation and the rounding error of the difference quotient
+        double step = std::pow(std::numeric_limits<double>::epsilon(), 1.0 / (order + 2)) * std::max(1.0, std::abs(x_val));
+        step = std::min(step, (hi - lo) / order);
+
+        // near the ends the stencil is shifted inside the range, since the interpolator cannot extrapolate
+        double half_width = step * order / 2.0;
+        double center = std::clamp(x_val, lo + half_width, hi - half_width);
+
+        double result = 0.0, binomial = 1.0;
+        for (int i = 0; i <= order; ++i) {
+            double sample = (*this)(std::clamp(center + (order / 2.0 - i) * step, lo, hi));
+            result += (i % 2 == 0 ? binomial : -binomial) * sample;
+            binomial = binomial * (order - i) / (i + 1);
+        }
+
+        return result / std::pow(step, order);
+    }
+
+    double interpolator::integrate(double a, double b) const {
+        SCITOOL_PROFILE_SCOPE("interpolator.integrate");
+        if (a > b) return -integrate(b, a);
+
+        check_range(a);
+        check_range(b);
+
+        auto function = [this](double x) { return (*this)(x); };
+
+        // interpolants are smooth between consecutive knots, so each segment is integrated on its own
+        double result = 0.0;
+        for (size_t i = segment_index(a), last = segment_index(b); i <= last; ++i) {
+            double lo = std::max(a, x_values[i]), hi = std::min(b, x_values[i + 1]);
+            if (hi > lo)
+                result += boost::math::quadrature::gauss_kronrod<double, 15>::integrate(function, lo, hi, 5, 1e-12);
+        }
+
+        return result;
+    }
+}
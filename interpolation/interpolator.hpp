@@ -1,9 +1,13 @@
 #ifndef INTERPOLATOR_HPP
 #define INTERPOLATOR_HPP
 
+#include "table_file.hpp"
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <optional>
+#include <type_traits>
 
 namespace scitool {
 
@@ -13,20 +17,82 @@ namespace scitool {
         point(double x_val, double y_val) : x(x_val), y(y_val) {}
     };
 
+    // Subclasses take knot arrays through constructor templates restricted with this alias: unlike a
+    // plain (std::vector<double>, std::vector<double>) overload, a template is never selected for braced
+    // lists, so "linear_interpolator({{1.0, 2.0}, {3.0, 4.0}})" still means a list of points
+    template<typename T>
+    using if_knot_array = std::enable_if_t<std::is_same_v<std::decay_t<T>, std::vector<double>>, int>;
+
     class interpolator {
     protected:
-        std::vector<point> points;
+        // knots are stored as two contiguous arrays sorted by x, rather than as an array of points.
+        // For a loaded interpolator they are read in place from the mapped file
+        table_array<double> x_values;
+        table_array<double> y_values;
+
+        // the knots of a saved interpolator (its first two arrays), used as they are
+        explicit interpolator(const table_reader &table);
+
+        void check_range(double x_val) const;
+        // index i of the segment [x_values[i], x_values[i + 1]] containing x_val
+        size_t segment_index(double x_val) const;
 
     public:
         interpolator(const std::vector<point> &);
+        // takes ownership of the two arrays, no copy is made
+        interpolator(std::vector<double> x, std::vector<double> y);
+        // copies n knots from two contiguous arrays (e.g. NumPy buffers or dataset columns)
+        interpolator(const double *x, const double *y, size_t n);
         virtual ~interpolator() = default;
         virtual double operator()(double x_val) const = 0;
 
-        const std::vector<scitool::point>& get_points() const {
-            return points;
+        // interpolates the n values of x into result. The base implementation calls operator()
+        // for every value, interpolators override it when they can do better
+        virtual void evaluate(const double *x, double *result, size_t n) const;
+
+        // derivative of the given order at x_val. The base implementation uses central finite
+        // differences, interpolators override it with the closed form of their interpolant
+        virtual double derivative(double x_val, int order = 1) const;
+
+        // definite integral between a and b. The base implementation applies Gauss-Kronrod
+        // quadrature between consecutive knots, interpolators override it with an exact rule
+        virtual double integrate(double a, double b) const;
+
+        // writes the knots and the precomputed coefficients in the layout of table_file.hpp, which
+        // load_interpolator maps back without rebuilding anything. Not every interpolator supports it
+        virtual void save(const std::string &path) const;
+
+        std::vector<scitool::point> get_points() const;
+
+        const table_array<double>& get_x() const {
+            return x_values;
         }
+
+        const table_array<double>& get_y() const {
+            return y_values;
+        }
+
+        size_t size() const {
+            return x_values.size();
+        }
+
+    private:
+        static void prepare_knots(std::vector<double> &x, std::vector<double> &y);
     };
 
+    // Builds an interpolator from two dataset columns (see dataset::get_numerical_column),
+    // skipping the rows where either value is missing
+    template<typename Interpolator>
+    Interpolator from_columns(const std::vector<std::optional<double>> &x, const std::vector<std::optional<double>> &y) {
+        const double missing = std::numeric_limits<double>::quiet_NaN();
+
+        std::vector<double> xs(x.size()), ys(y.size());
+        std::transform(x.begin(), x.end(), xs.begin(), [missing](const auto &value) { return value.value_or(missing); });
+        std::transform(y.begin(), y.end(), ys.begin(), [missing](const auto &value) { return value.value_or(missing); });
+
+        return Interpolator(std::move(xs), std::move(ys));
+    }
+
 }
 
 #endif
@@ -0,0 +1,147 @@
+#include "kd_tree.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        bool closer(const kd_tree::neighbor& a, const kd_tree::neighbor& b) {
+            return a.distance_squared < b.distance_squared;
+        }
+    }
+
+    kd_tree::kd_tree(std::vector<double> xs, std::vector<double> ys)
+            : xs(std::move(xs)), ys(std::move(ys)) {
+
+        if (this->xs.size() != this->ys.size())
+            throw std::invalid_argument("Coordinate vectors must have the same size");
+
+        size_t n = this->xs.size();
+        indices.resize(n);
+        std::iota(indices.begin(), indices.end(), 0);
+        split_dimension.assign(n, 0);
+
+        build(0, n);
+
+        // store the coordinates in tree order, so that queries walk the arrays linearly
+        std::vector<double> tree_xs(n), tree_ys(n);
+        for (size_t i = 0; i < n; ++i) {
+            tree_xs[i] = this->xs[indices[i]];
+            tree_ys[i] = this->ys[indices[i]];
+        }
+        this->xs.swap(tree_xs);
+        this->ys.swap(tree_ys);
+    }
+
+    void kd_tree::build(size_t lo, size_t hi) {
+        if (hi - lo <= leaf_size) return;
+
+        double min_x = xs[indices[lo]], max_x = min_x;
+        double min_y = ys[indices[lo]], max_y = min_y;
+        for (size_t i = lo + 1; i < hi; ++i) {
+            min_x = std::min(min_x, xs[indices[i]]);
+            max_x = std::max(max_x, xs[indices[i]]);
+            min_y = std::min(min_y, ys[indices[i]]);
+            max_y = std::max(max_y, ys[indices[i]]);
+        }
+
+        // splitting along the widest dimension keeps the cells close to square,
+        // which matters for lon/lat data that is much wider in one direction
+        unsigned char dimension = (max_x - min_x) >= (max_y - min_y) ? 0 : 1;
+        const std::vector<double>& coordinates = dimension == 0 ? xs : ys;
+
+        size_t mid = lo + (hi - lo) / 2;
+        std::nth_element(indices.begin() + (long) lo, indices.begin() + (long) mid, indices.begin() + (long) hi,
+                         [&coordinates](size_t a, size_t b) { return coordinates[a] < coordinates[b]; });
+        split_dimension[mid] = dimension;
+
+        build(lo, mid);
+        build(mid + 1, hi);
+    }
+
+    void kd_tree::nearest(double x, double y, size_t k, std::vector<neighbor>& result) const {
+        result.clear();
+        if (k == 0 || xs.empty()) return;
+
+        k = std::min(k, xs.size());
+        result.reserve(k);
+        nearest(0, xs.size(), x, y, k, result);
+
+        // the search keeps a max-heap on the distance, sorting it gives increasing distances
+        std::sort_heap(result.begin(), result.end(), closer);
+    }
+
+    std::vector<kd_tree::neighbor> kd_tree::nearest(double x, double y, size_t k) const {
+        std::vector<neighbor> result;
+        nearest(x, y, k, result);
+        return result;
+    }
+
+    void kd_tree::nearest(size_t lo, size_t hi, double x, double y, size_t k, std::vector<neighbor>& heap) const {
+        auto consider = [&](size_t position) {
+            double dx = xs[position] - x;
+            double dy = ys[position] - y;
+            double distance_squared = dx * dx + dy * dy;
+
+            if (heap.size() < k) {
+                heap.push_back({position, distance_squared});
+                std::push_heap(heap.begin(), heap.end(), closer);
+            } else if (distance_squared < heap.front().distance_squared) {
+                std::pop_heap(heap.begin(), heap.end(), closer);
+                heap.back() = {position, distance_squared};
+                std::push_heap(heap.begin(), heap.end(), closer);
+            }
+        };
+
+        if (hi - lo <= leaf_size) {
+            for (size_t position = lo; position < hi; ++position)
+                consider(position);
+            return;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        consider(mid);
+
+        double diff = split_dimension[mid] == 0 ? x - xs[mid] : y - ys[mid];
+        size_t near_lo = diff < 0 ? lo : mid + 1, near_hi = diff < 0 ? mid : hi;
+        size_t far_lo = diff < 0 ? mid + 1 : lo, far_hi = diff < 0 ? hi : mid;
+
+        nearest(near_lo, near_hi, x, y, k, heap);
+        // the far half can only contain a closer point if the splitting line is closer than the current k-th neighbor
+        if (heap.size() < k || diff * diff < heap.front().distance_squared)
+            nearest(far_lo, far_hi, x, y, k, heap);
+    }
+
+    void kd_tree::within_radius(double x, double y, double radius, std::vector<neighbor>& result) const {
+        result.clear();
+        if (xs.empty() || radius <= 0) return;
+        within_radius(0, xs.size(), x, y, radius * radius, result);
+    }
+
+    void kd_tree::within_radius(size_t lo, size_t hi, double x, double y, double radius_squared,
+                                std::vector<neighbor>& result) const {
+        auto consider = [&](size_t position) {
+            double dx = xs[position] - x;
+            double dy = ys[position] - y;
+            double distance_squared = dx * dx + dy * dy;
+            if (distance_squared < radius_squared)
+                result.push_back({position, distance_squared});
+        };
+
+        if (hi - lo <= leaf_size) {
+            for (size_t position = lo; position < hi; ++position)
+                consider(position);
+            return;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        consider(mid);
+
+        double diff = split_dimension[mid] == 0 ? x - xs[mid] : y - ys[mid];
+        if (diff < 0 || diff * diff < radius_squared)
+            within_radius(lo, mid, x, y, radius_squared, result);
+        if (diff >= 0 || diff * diff < radius_squared)
+            within_radius(mid + 1, hi, x, y, radius_squared, result);
+    }
+}
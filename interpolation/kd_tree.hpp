@@ -0,0 +1,51 @@
+#ifndef KD_TREE_HPP
+#define KD_TREE_HPP
+
+#include <vector>
+#include <cstddef>
+
+namespace scitool {
+
+    // Static two-dimensional k-d tree over a set of sample coordinates.
+    // The tree is implicit: coordinates are permuted so that every range [lo, hi) is split
+    // at its middle element, which means no node objects are allocated and queries only walk
+    // contiguous arrays. Positions returned by the queries refer to the permuted order;
+    // permutation() maps them back to the order the coordinates were given in.
+    class kd_tree {
+    public:
+        struct neighbor {
+            size_t position;
+            double distance_squared;
+        };
+
+        kd_tree() = default;
+        kd_tree(std::vector<double> xs, std::vector<double> ys);
+
+        // k nearest neighbors of (x, y), sorted by increasing distance
+        void nearest(double x, double y, size_t k, std::vector<neighbor>& result) const;
+        std::vector<neighbor> nearest(double x, double y, size_t k) const;
+
+        // all the samples whose distance from (x, y) is less than radius, in no particular order
+        void within_radius(double x, double y, double radius, std::vector<neighbor>& result) const;
+
+        double x(size_t position) const { return xs[position]; }
+        double y(size_t position) const { return ys[position]; }
+        const std::vector<size_t>& permutation() const { return indices; }
+        size_t size() const { return xs.size(); }
+
+    private:
+        static constexpr size_t leaf_size = 8;
+
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<size_t> indices;
+        std::vector<unsigned char> split_dimension;
+
+        void build(size_t lo, size_t hi);
+        void nearest(size_t lo, size_t hi, double x, double y, size_t k, std::vector<neighbor>& heap) const;
+        void within_radius(size_t lo, size_t hi, double x, double y, double radius_squared, std::vector<neighbor>& result) const;
+    };
+
+}
+
+#endif
@@ -1,21 +1,78 @@
 #include "linear_interpolator.hpp"
+#include "profiling.hpp"
 
 
 namespace scitool {
-    double linear_interpolator::operator()(double point) const {
-        if (point < points[0].x || point > points[points.size() - 1].x) {
-            throw std::out_of_range("Interpolation point out of range");
+    void linear_interpolator::init() {
+        // the integral of each segment is the area of a trapezoid, summing them once
+        // makes every definite integral a difference of two antiderivative values
+        std::vector<double> integral;
+        integral.reserve(x_values.size());
+        integral.push_back(0.0);
+        for (size_t i = 1; i < x_values.size(); i++) {
+            integral.push_back(integral.back() + (x_values[i] - x_values[i - 1]) * (y_values[i - 1] + y_values[i]) / 2.0);
         }
+        cumulative_integral = std::move(integral);
+    }
 
-        // the for loop takes the first point to the left and to the right of "point" and
+    void linear_interpolator::save(const std::string &path) const {
+        table_writer table(table_kind::linear);
+        table.add(x_values);
+        table.add(y_values);
+        table.add(cumulative_integral);
+        table.write(path);
+    }
+
+    double linear_interpolator::operator()(double point) const {
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", 1);
+        check_range(point);
+
+        // the binary search takes the first point to the left and to the right of "point" and
         // interpolates with a simple linear function between the two points
-        for (int i = 0; i < (int) points.size() - 1; i++) {
-            if (point >= points[i].x && point <= points[i + 1].x) {
-                double slope = (points[i + 1].y - points[i].y) / (points[i + 1].x - points[i].x);
-                return points[i].y + slope * (point - points[i].x);
+        return value_in_segment(segment_index(point), point);
+    }
+
+    void linear_interpolator::evaluate(const double *x, double *result, size_t n) const {
+        SCITOOL_PROFILE_SCOPE("interpolator.evaluate");
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", n);
+
+        // consecutive values are often close to each other (e.g. sorted grids),
+        // so the segment of the previous value and the following one are tried before searching
+        size_t segment = 0;
+        for (size_t i = 0; i < n; i++) {
+            check_range(x[i]);
+            if (x[i] < x_values[segment] || x[i] > x_values[segment + 1]) {
+                if (segment + 2 < x_values.size() && x[i] > x_values[segment + 1] && x[i] <= x_values[segment + 2])
+                    segment++;
+                else
+                    segment = segment_index(x[i]);
             }
+            result[i] = value_in_segment(segment, x[i]);
         }
+    }
+
+    double linear_interpolator::derivative(double x_val, int order) const {
+        if (order < 0)
+            throw std::invalid_argument("The derivative order must not be negative");
+
+        check_range(x_val);
+        if (order == 0) return (*this)(x_val);
+        if (order > 1) return 0.0;
+
+        // at a knot the interpolant is not differentiable, the slope of the segment on the right is used
+        size_t i = segment_index(x_val);
+        return (y_values[i + 1] - y_values[i]) / (x_values[i + 1] - x_values[i]);
+    }
+
+    double linear_interpolator::antiderivative(double x_val) const {
+        size_t i = segment_index(x_val);
+        return cumulative_integral[i] + (x_val - x_values[i]) * (y_values[i] + value_in_segment(i, x_val)) / 2.0;
+    }
+
+    double linear_interpolator::integrate(double a, double b) const {
+        check_range(a);
+        check_range(b);
 
-        return 0.0;
+        return antiderivative(b) - antiderivative(a);
     }
-}
\ No newline at end of file
+}
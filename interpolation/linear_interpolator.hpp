@@ -4,11 +4,42 @@
 
 namespace scitool {
     class linear_interpolator : public interpolator {
+    private:
+        // cumulative_integral[i] is the integral between the first knot and x_values[i]
+        table_array<double> cumulative_integral;
+
+        void init();
+        double value_in_segment(size_t i, double x_val) const {
+            double slope = (y_values[i + 1] - y_values[i]) / (x_values[i + 1] - x_values[i]);
+            return y_values[i] + slope * (x_val - x_values[i]);
+        }
+        double antiderivative(double x_val) const;
+
     public:
         linear_interpolator(const std::vector<point> &points)
-                : interpolator(points) {}
+                : interpolator(points) {
+            init();
+        }
+
+        template<typename X, typename Y, if_knot_array<X> = 0, if_knot_array<Y> = 0>
+        linear_interpolator(X &&x, Y &&y)
+                : interpolator(std::forward<X>(x), std::forward<Y>(y)) {
+            init();
+        }
+
+        linear_interpolator(const double *x, const double *y, size_t n)
+                : interpolator(x, y, n) {
+            init();
+        }
+
+        explicit linear_interpolator(const table_reader &table)
+                : interpolator(table), cumulative_integral(table.array<double>(2, x_values.size())) {}
 
         double operator()(double point) const override;
+        void evaluate(const double *x, double *result, size_t n) const override;
+        double derivative(double x_val, int order = 1) const override;
+        double integrate(double a, double b) const override;
+        void save(const std::string &path) const override;
     };
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,135 @@
+#include "model_selection.hpp"
+#include "linear_interpolator.hpp"
+#include "polynomial_interpolator.hpp"
+#include "cardinal_cubic_bspline_Interpolator.hpp"
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace scitool {
+
+    std::vector<interpolator_candidate> default_interpolator_candidates() {
+        std::vector<interpolator_candidate> candidates;
+        candidates.push_back({"LinearInterpolator", [](const std::vector<double> &x, const std::vector<double> &y) {
+            return std::unique_ptr<interpolator>(std::make_unique<linear_interpolator>(x, y));
+        }});
+        candidates.push_back({"PolynomialInterpolator", [](const std::vector<double> &x, const std::vector<double> &y) {
+            return std::unique_ptr<interpolator>(std::make_unique<polynomial_interpolator>(x, y));
+        }, 64});
+        candidates.push_back({"CardinalCubicBSplineInterpolator", [](const std::vector<double> &x, const std::vector<double> &y) {
+            return std::unique_ptr<interpolator>(std::make_unique<cardinal_cubic_bspline_interpolator>(x, y));
+        }});
+        return candidates;
+    }
+
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        // best of a few passes over the queries, each pass long enough for the clock resolution
+        double query_latency(const interpolator &model, const std::vector<double> &queries) {
+            double best = std::numeric_limits<double>::infinity();
+            volatile double sink = 0.0;
+            for (int repetition = 0; repetition < 3; repetition++) {
+                size_t evaluated = 0;
+                auto start = clock::now();
+                double elapsed = 0.0;
+                while (elapsed < 1e-3) {
+                    for (double query : queries) sink = sink + model(query);
+                    evaluated += queries.size();
+                    elapsed = std::chrono::duration<double>(clock::now() - start).count();
+                }
+                best = std::min(best, elapsed * 1e9 / static_cast<double>(evaluated));
+            }
+            return best;
+        }
+    }
+
+    model_selection select_interpolator(const std::vector<double> &x, const std::vector<double> &y, double error_budget,
+                                        const std::vector<interpolator_candidate> &candidates) {
+        if (x.size() != y.size())
+            throw std::invalid_argument("\"x\" and \"y\" must have the same size");
+        if (error_budget < 0)
+            throw std::invalid_argument("The error budget must not be negative");
+        if (candidates.empty())
+            throw std::invalid_argument("At least one candidate interpolator is needed");
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < x.size(); i++)
+            if (!std::isnan(x[i]) && !std::isnan(y[i])) order.push_back(i);
+        std::sort(order.begin(), order.end(), [&x](size_t a, size_t b) { return x[a] < x[b]; });
+
+        if (order.size() < 3)
+            throw std::invalid_argument("At least three points are needed to select an interpolator");
+
+        // even knots are used for training and odd knots for validation; the training set stops at the
+        // last even knot, so validation points never need extrapolation and uniform spacing is preserved
+        std::vector<double> train_x, train_y, test_x, test_y;
+        size_t last = (order.size() - 1) / 2 * 2;
+        for (size_t i = 0; i <= last; i++) {
+            auto &xs = i % 2 == 0 ? train_x : test_x;
+            auto &ys = i % 2 == 0 ? train_y : test_y;
+            xs.push_back(x[order[i]]);
+            ys.push_back(y[order[i]]);
+        }
+
+        model_selection result;
+        const interpolator_candidate *fastest = nullptr, *most_accurate = nullptr;
+        double fastest_latency = 0.0, best_error = 0.0;
+
+        for (const auto &candidate : candidates) {
+            candidate_evaluation evaluation;
+            evaluation.name = candidate.name;
+
+            std::unique_ptr<interpolator> model;
+            if (train_x.size() <= candidate.max_knots) {
+                try {
+                    auto start = clock::now();
+                    model = candidate.build(train_x, train_y);
+                    evaluation.construction_seconds = std::chrono::duration<double>(clock::now() - start).count();
+                } catch (const std::invalid_argument &) {
+                    model.reset();
+                }
+            }
+
+            if (model) {
+                evaluation.applicable = true;
+                double total_error = 0.0;
+                for (size_t i = 0; i < test_x.size(); i++) {
+                    double error = std::abs((*model)(test_x[i]) - test_y[i]);
+                    total_error += error;
+                    evaluation.max_absolute_error = std::max(evaluation.max_absolute_error, error);
+                }
+                evaluation.mean_absolute_error = total_error / static_cast<double>(test_x.size());
+                evaluation.query_nanoseconds = query_latency(*model, test_x);
+
+                if (!most_accurate || evaluation.max_absolute_error < best_error) {
+                    most_accurate = &candidate;
+                    best_error = evaluation.max_absolute_error;
+                }
+                if (evaluation.max_absolute_error <= error_budget &&
+                    (!fastest || evaluation.query_nanoseconds < fastest_latency)) {
+                    fastest = &candidate;
+                    fastest_latency = evaluation.query_nanoseconds;
+                }
+            }
+
+            result.evaluations.push_back(evaluation);
+        }
+
+        if (!most_accurate)
+            throw std::runtime_error("None of the candidate interpolators can be built on the given points");
+
+        const interpolator_candidate &chosen = fastest ? *fastest : *most_accurate;
+        std::vector<double> sorted_x(order.size()), sorted_y(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            sorted_x[i] = x[order[i]];
+            sorted_y[i] = y[order[i]];
+        }
+
+        result.model = chosen.build(sorted_x, sorted_y);
+        result.name = chosen.name;
+        result.meets_budget = fastest != nullptr;
+        return result;
+    }
+}
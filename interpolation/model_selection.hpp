@@ -0,0 +1,48 @@
+#ifndef MODEL_SELECTION_HPP
+#define MODEL_SELECTION_HPP
+
+#include "interpolator.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace scitool {
+
+    // An interpolation method that can be tried on a table of knots
+    struct interpolator_candidate {
+        std::string name;
+        std::function<std::unique_ptr<interpolator>(const std::vector<double> &, const std::vector<double> &)> build;
+        // larger tables are skipped (e.g. global polynomials become slow and unstable)
+        size_t max_knots = std::numeric_limits<size_t>::max();
+    };
+
+    // linear, polynomial (up to 64 knots) and cardinal cubic B-spline (uniformly spaced knots only)
+    std::vector<interpolator_candidate> default_interpolator_candidates();
+
+    struct candidate_evaluation {
+        std::string name;
+        // false when the candidate cannot be built on the data (e.g. the B-spline on non-uniform knots)
+        bool applicable = false;
+        double mean_absolute_error = 0.0;
+        double max_absolute_error = 0.0;
+        double construction_seconds = 0.0;
+        double query_nanoseconds = 0.0;
+    };
+
+    struct model_selection {
+        std::unique_ptr<interpolator> model;
+        std::string name;
+        // false when no candidate met the budget, model is then the most accurate candidate
+        bool meets_budget = false;
+        std::vector<candidate_evaluation> evaluations;
+    };
+
+    // Picks the fastest interpolator whose maximum absolute error stays within error_budget.
+    // The error is estimated by holding out every other knot: candidates are built on the even
+    // knots and checked against the odd ones, then the chosen method is rebuilt on all the knots.
+    // At least three knots are needed.
+    model_selection select_interpolator(const std::vector<double> &x, const std::vector<double> &y, double error_budget,
+                                        const std::vector<interpolator_candidate> &candidates = default_interpolator_candidates());
+}
+
+#endif
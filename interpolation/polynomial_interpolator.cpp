@@ -1,27 +1,136 @@
 #include "polynomial_interpolator.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <cmath>
 
 
 namespace scitool {
-    double polynomial_interpolator::operator()(double point) const {
+    namespace {
+        // nodes and weights of the m-point Gauss-Legendre rule, found with Newton's method on P_m
+        void gauss_legendre(size_t m, std::vector<double> &nodes, std::vector<double> &weights) {
+            nodes.resize(m);
+            weights.resize(m);
+            const double pi = std::acos(-1.0);
 
-        if (point < points[0].x || point > points[points.size() - 1].x) {
-            throw std::out_of_range("Interpolation point out of range");
-        }
+            for (size_t i = 0; i < m; ++i) {
+                double t = std::cos(pi * (static_cast<double>(i) + 0.75) / (static_cast<double>(m) + 0.5));
+                double p_m = 0.0, p_prime = 1.0;
 
-        double result = 0.0;
+                for (int iteration = 0; iteration < 100; ++iteration) {
+                    double p_previous = 1.0;
+                    p_m = t;
+                    for (size_t k = 2; k <= m; ++k) {
+                        double p_next = ((2.0 * k - 1.0) * t * p_m - (k - 1.0) * p_previous) / static_cast<double>(k);
+                        p_previous = p_m;
+                        p_m = p_next;
+                    }
 
-        // this algorithm is the lagrange interpolator
-        // more information can be found here: https://en.wikipedia.org/wiki/Lagrange_polynomia.
-        for (int i = 0; i < (int) points.size(); ++i) {
-            double term = points[i].y;
-            for (int j = 0; j < (int) points.size(); ++j) {
-                if (j != i) {
-                    term *= (point - points[j].x) / (points[i].x - points[j].x);
+                    p_prime = static_cast<double>(m) * (t * p_m - p_previous) / (t * t - 1.0);
+                    double step = p_m / p_prime;
+                    t -= step;
+                    if (std::abs(step) < 1e-15) break;
                 }
+
+                nodes[i] = t;
+                weights[i] = 2.0 / ((1.0 - t * t) * p_prime * p_prime);
+            }
+        }
+    }
+
+    void polynomial_interpolator::init() {
+        size_t n = x_values.size();
+
+        // w_j = 1 / prod_{k != j} (x_j - x_k). Every factor is scaled by 4 / (b - a), the capacity of the interval,
+        // so that the products neither overflow nor underflow; a common factor leaves the barycentric formula unchanged
+        auto range = std::minmax_element(x_values.begin(), x_values.end());
+        double scale = 4.0 / (*range.second - *range.first);
+        std::vector<double> products(n, 1.0);
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < n; ++k) {
+                if (k != j) products[j] *= (x_values[j] - x_values[k]) * scale;
             }
-            result += term;
+            products[j] = 1.0 / products[j];
+        }
+        weights = std::move(products);
+
+        derivative_values = differentiate(y_values.data());
+
+        // the polynomial has degree n - 1, which the ceil(n / 2)-point rule integrates exactly
+        std::vector<double> nodes, node_weights;
+        gauss_legendre((n + 1) / 2, nodes, node_weights);
+        quadrature_nodes = std::move(nodes);
+        quadrature_weights = std::move(node_weights);
+    }
+
+    void polynomial_interpolator::save(const std::string &path) const {
+        table_writer table(table_kind::polynomial);
+        table.add(x_values);
+        table.add(y_values);
+        table.add(weights);
+        table.add(derivative_values);
+        table.add(quadrature_nodes);
+        table.add(quadrature_weights);
+        table.write(path);
+    }
+
+    double polynomial_interpolator::barycentric(double x_val, const double *node_values) const {
+        // this is the second (true) form of the barycentric formula for the lagrange polynomial
+        // more information can be found here: https://en.wikipedia.org/wiki/Lagrange_polynomial#Barycentric_form
+        double numerator = 0.0, denominator = 0.0;
+        for (size_t j = 0; j < x_values.size(); ++j) {
+            double difference = x_val - x_values[j];
+            if (difference == 0.0) return node_values[j];
+
+            double term = weights[j] / difference;
+            numerator += term * node_values[j];
+            denominator += term;
         }
 
+        return numerator / denominator;
+    }
+
+    std::vector<double> polynomial_interpolator::differentiate(const double *node_values) const {
+        // applies the barycentric differentiation matrix D_ij = (w_j / w_i) / (x_i - x_j), D_ii = -sum_{j != i} D_ij:
+        // the derivative of the polynomial through "node_values" is the polynomial through the result
+        std::vector<double> result(x_values.size(), 0.0);
+        for (size_t i = 0; i < x_values.size(); ++i) {
+            for (size_t j = 0; j < x_values.size(); ++j) {
+                if (j == i) continue;
+                result[i] += (weights[j] / weights[i]) * (node_values[j] - node_values[i]) / (x_values[i] - x_values[j]);
+            }
+        }
         return result;
     }
-}
\ No newline at end of file
+
+    double polynomial_interpolator::operator()(double point) const {
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", 1);
+        check_range(point);
+        return barycentric(point, y_values.data());
+    }
+
+    double polynomial_interpolator::derivative(double x_val, int order) const {
+        if (order < 0)
+            throw std::invalid_argument("The derivative order must not be negative");
+
+        check_range(x_val);
+        if (order == 0) return (*this)(x_val);
+        if (order >= (int) x_values.size()) return 0.0;
+        if (order == 1) return barycentric(x_val, derivative_values.data());
+
+        std::vector<double> higher_values = derivative_values.to_vector();
+        for (int k = 1; k < order; ++k) higher_values = differentiate(higher_values.data());
+        return barycentric(x_val, higher_values.data());
+    }
+
+    double polynomial_interpolator::integrate(double a, double b) const {
+        check_range(a);
+        check_range(b);
+
+        double half_width = (b - a) / 2.0, center = (a + b) / 2.0;
+        double result = 0.0;
+        for (size_t k = 0; k < quadrature_nodes.size(); ++k)
+            result += quadrature_weights[k] * barycentric(center + half_width * quadrature_nodes[k], y_values.data());
+
+        return result * half_width;
+    }
+}
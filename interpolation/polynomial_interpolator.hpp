@@ -4,13 +4,49 @@
 
 namespace scitool {
     class polynomial_interpolator : public interpolator {
+    private:
+        // barycentric weights of the knots, scaled so that the largest one is 1
+        table_array<double> weights;
+        // values of the first derivative of the polynomial at the knots
+        table_array<double> derivative_values;
+        // Gauss-Legendre rule on [-1, 1] that is exact for the degree of the polynomial
+        table_array<double> quadrature_nodes;
+        table_array<double> quadrature_weights;
+
+        void init();
+        // node_values holds one value per knot
+        double barycentric(double x_val, const double *node_values) const;
+        std::vector<double> differentiate(const double *node_values) const;
+
     public:
         polynomial_interpolator(const std::vector<point> &points)
-                : interpolator(points) {}
+                : interpolator(points) {
+            init();
+        }
+
+        template<typename X, typename Y, if_knot_array<X> = 0, if_knot_array<Y> = 0>
+        polynomial_interpolator(X &&x, Y &&y)
+                : interpolator(std::forward<X>(x), std::forward<Y>(y)) {
+            init();
+        }
+
+        polynomial_interpolator(const double *x, const double *y, size_t n)
+                : interpolator(x, y, n) {
+            init();
+        }
+
+        explicit polynomial_interpolator(const table_reader &table)
+                : interpolator(table), weights(table.array<double>(2, x_values.size())),
+                  derivative_values(table.array<double>(3, x_values.size())),
+                  quadrature_nodes(table.array<double>(4, (x_values.size() + 1) / 2)),
+                  quadrature_weights(table.array<double>(5, (x_values.size() + 1) / 2)) {}
 
         double operator()(double point) const override;
+        double derivative(double x_val, int order = 1) const override;
+        double integrate(double a, double b) const override;
+        void save(const std::string &path) const override;
     };
 }
 
 
-#endif
\ No newline at end of file
+#endif
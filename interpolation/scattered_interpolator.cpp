@@ -0,0 +1,199 @@
+#include "scattered_interpolator.hpp"
+#include "profiling.hpp"
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace scitool {
+
+    scattered_interpolator::scattered_interpolator(const std::vector<scattered_point>& points) {
+        build(points);
+    }
+
+    scattered_interpolator::scattered_interpolator(const std::vector<std::optional<double>>& xs,
+                                                   const std::vector<std::optional<double>>& ys,
+                                                   const std::vector<std::optional<double>>& sample_values) {
+        if (xs.size() != ys.size() || xs.size() != sample_values.size())
+            throw std::invalid_argument("Coordinate and value columns must have the same size");
+
+        std::vector<scattered_point> points;
+        points.reserve(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (xs[i] && ys[i] && sample_values[i])
+                points.emplace_back(*xs[i], *ys[i], *sample_values[i]);
+        }
+
+        build(std::move(points));
+    }
+
+    void scattered_interpolator::build(std::vector<scattered_point> points) {
+        SCITOOL_PROFILE_SCOPE("scattered_interpolator.build");
+        // samples with a NaN or infinite coordinate or value cannot be placed nor interpolated, and NaN would break
+        // the ordering of the sort and the merge below; they are dropped as missing values, as prepare_knots does
+        points.erase(std::remove_if(points.begin(), points.end(), [](const scattered_point& point) {
+            return !std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.value);
+        }), points.end());
+        if (points.empty())
+            throw std::invalid_argument("At least one point is needed to perform interpolation");
+
+        std::sort(points.begin(), points.end(), [](const scattered_point& a, const scattered_point& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+
+        // merge the samples sharing the same coordinates, they would make the RBF system singular
+        std::vector<double> xs, ys, merged_values;
+        for (size_t i = 0; i < points.size();) {
+            size_t j = i;
+            double sum = 0.0;
+            while (j < points.size() && points[j].x == points[i].x && points[j].y == points[i].y)
+                sum += points[j++].value;
+
+            xs.push_back(points[i].x);
+            ys.push_back(points[i].y);
+            merged_values.push_back(sum / static_cast<double>(j - i));
+            i = j;
+        }
+
+        tree = kd_tree(std::move(xs), std::move(ys));
+
+        values.resize(merged_values.size());
+        const auto& permutation = tree.permutation();
+        for (size_t position = 0; position < permutation.size(); ++position)
+            values[position] = merged_values[permutation[position]];
+    }
+
+    std::vector<double> scattered_interpolator::evaluate(const std::vector<double>& xs, const std::vector<double>& ys) const {
+        SCITOOL_PROFILE_SCOPE("scattered_interpolator.evaluate");
+        SCITOOL_PROFILE_COUNT("interpolator.evaluations", xs.size());
+        if (xs.size() != ys.size())
+            throw std::invalid_argument("Coordinate vectors must have the same size");
+
+        std::vector<double> result(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i)
+            result[i] = (*this)(xs[i], ys[i]);
+        return result;
+    }
+
+    idw_interpolator::idw_interpolator(const std::vector<scattered_point>& points, size_t neighbors, double power)
+            : scattered_interpolator(points), neighbors(neighbors), power(power) {
+        if (neighbors == 0)
+            throw std::invalid_argument("At least one neighbor is needed to perform inverse distance weighting");
+        if (power <= 0)
+            throw std::invalid_argument("The inverse distance weighting power must be positive");
+    }
+
+    idw_interpolator::idw_interpolator(const std::vector<std::optional<double>>& xs,
+                                       const std::vector<std::optional<double>>& ys,
+                                       const std::vector<std::optional<double>>& sample_values,
+                                       size_t neighbors, double power)
+            : scattered_interpolator(xs, ys, sample_values), neighbors(neighbors), power(power) {
+        if (neighbors == 0)
+            throw std::invalid_argument("At least one neighbor is needed to perform inverse distance weighting");
+        if (power <= 0)
+            throw std::invalid_argument("The inverse distance weighting power must be positive");
+    }
+
+    double idw_interpolator::operator()(double x, double y) const {
+        thread_local std::vector<kd_tree::neighbor> found;
+        tree.nearest(x, y, neighbors, found);
+
+        // neighbors are sorted by distance, so an exact hit can only be the first one
+        if (found.front().distance_squared == 0.0)
+            return values[found.front().position];
+
+        double weighted_sum = 0.0, weight_sum = 0.0;
+        for (const auto& neighbor : found) {
+            double weight = power == 2.0 ? 1.0 / neighbor.distance_squared
+                                         : std::pow(neighbor.distance_squared, -power / 2.0);
+            weighted_sum += weight * values[neighbor.position];
+            weight_sum += weight;
+        }
+
+        return weighted_sum / weight_sum;
+    }
+
+    rbf_interpolator::rbf_interpolator(const std::vector<scattered_point>& points, double support_radius,
+                                       rbf_kernel kernel, double smoothing)
+            : scattered_interpolator(points), support_radius(support_radius), kernel(kernel) {
+        solve(smoothing);
+    }
+
+    rbf_interpolator::rbf_interpolator(const std::vector<std::optional<double>>& xs,
+                                       const std::vector<std::optional<double>>& ys,
+                                       const std::vector<std::optional<double>>& sample_values,
+                                       double support_radius, rbf_kernel kernel, double smoothing)
+            : scattered_interpolator(xs, ys, sample_values), support_radius(support_radius), kernel(kernel) {
+        solve(smoothing);
+    }
+
+    double rbf_interpolator::basis(double distance_squared) const {
+        double r = std::sqrt(distance_squared) / support_radius;
+        if (r >= 1.0) return 0.0;
+
+        double s = 1.0 - r;
+        switch (kernel) {
+            case rbf_kernel::wendland_c4: {
+                double s3 = s * s * s;
+                return s3 * s3 * (35.0 * r * r + 18.0 * r + 3.0) / 3.0;
+            }
+            case rbf_kernel::wendland_c2:
+            default: {
+                double s2 = s * s;
+                return s2 * s2 * (4.0 * r + 1.0);
+            }
+        }
+    }
+
+    void rbf_interpolator::solve(double smoothing) {
+        SCITOOL_PROFILE_SCOPE("rbf_interpolator.solve");
+        if (support_radius <= 0)
+            throw std::invalid_argument("The RBF support radius must be positive");
+        if (smoothing < 0)
+            throw std::invalid_argument("The RBF smoothing must not be negative");
+
+        auto n = static_cast<Eigen::Index>(values.size());
+
+        // interpolating the deviations from the mean makes the interpolant decay towards
+        // the mean, rather than towards zero, outside the support of the kernels
+        Eigen::Map<const Eigen::VectorXd> sample_values(values.data(), n);
+        offset = sample_values.mean();
+
+        // Wendland kernels are positive definite in two dimensions, so the matrix is symmetric
+        // positive definite and only its lower triangle needs to be assembled
+        std::vector<Eigen::Triplet<double>> triplets;
+        std::vector<kd_tree::neighbor> found;
+        for (size_t i = 0; i < values.size(); ++i) {
+            tree.within_radius(tree.x(i), tree.y(i), support_radius, found);
+            for (const auto& neighbor : found) {
+                if (neighbor.position < i) continue;
+
+                double entry = basis(neighbor.distance_squared);
+                if (neighbor.position == i) entry += smoothing;
+                triplets.emplace_back((Eigen::Index) neighbor.position, (Eigen::Index) i, entry);
+            }
+        }
+
+        Eigen::SparseMatrix<double> matrix(n, n);
+        matrix.setFromTriplets(triplets.begin(), triplets.end());
+
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(matrix);
+        if (solver.info() != Eigen::Success)
+            throw std::runtime_error("Unable to factorize the RBF interpolation matrix");
+
+        weights = solver.solve((sample_values.array() - offset).matrix());
+        if (solver.info() != Eigen::Success)
+            throw std::runtime_error("Unable to solve the RBF interpolation system");
+    }
+
+    double rbf_interpolator::operator()(double x, double y) const {
+        thread_local std::vector<kd_tree::neighbor> found;
+        tree.within_radius(x, y, support_radius, found);
+
+        double result = offset;
+        for (const auto& neighbor : found)
+            result += weights[(Eigen::Index) neighbor.position] * basis(neighbor.distance_squared);
+
+        return result;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef SCATTERED_INTERPOLATOR_HPP
+#define SCATTERED_INTERPOLATOR_HPP
+
+#include "kd_tree.hpp"
+#include <optional>
+#include <Eigen/Core>
+
+namespace scitool {
+
+    struct scattered_point {
+        double x, y, value;
+
+        scattered_point(double x_val, double y_val, double value_val) : x(x_val), y(y_val), value(value_val) {}
+    };
+
+    // Base class for interpolators of values sampled at scattered two-dimensional coordinates
+    // (e.g. longitude/latitude pairs). Samples with a non-finite coordinate or value are skipped, samples
+    // sharing the same coordinates are merged by averaging their values, and the remaining ones are
+    // indexed by a k-d tree.
+    class scattered_interpolator {
+    protected:
+        kd_tree tree;
+        // sample values, stored in the same order as the k-d tree coordinates
+        std::vector<double> values;
+
+    public:
+        scattered_interpolator(const std::vector<scattered_point>& points);
+        // builds the samples from three columns, e.g. the output of dataset::get_numerical_column;
+        // rows where any of the three values is missing are skipped
+        scattered_interpolator(const std::vector<std::optional<double>>& xs,
+                               const std::vector<std::optional<double>>& ys,
+                               const std::vector<std::optional<double>>& sample_values);
+        virtual ~scattered_interpolator() = default;
+
+        virtual double operator()(double x, double y) const = 0;
+
+        std::vector<double> evaluate(const std::vector<double>& xs, const std::vector<double>& ys) const;
+
+        size_t size() const {
+            return values.size();
+        }
+
+    private:
+        void build(std::vector<scattered_point> points);
+    };
+
+    // Inverse distance weighting over the k nearest samples.
+    class idw_interpolator : public scattered_interpolator {
+    private:
+        size_t neighbors;
+        double power;
+
+    public:
+        idw_interpolator(const std::vector<scattered_point>& points, size_t neighbors = 8, double power = 2.0);
+        idw_interpolator(const std::vector<std::optional<double>>& xs,
+                         const std::vector<std::optional<double>>& ys,
+                         const std::vector<std::optional<double>>& sample_values,
+                         size_t neighbors = 8, double power = 2.0);
+
+        double operator()(double x, double y) const override;
+    };
+
+    enum class rbf_kernel {
+        wendland_c2,
+        wendland_c4
+    };
+
+    // Radial basis function interpolation with compactly supported (Wendland) kernels.
+    // Since every kernel vanishes beyond support_radius, the interpolation matrix is sparse and
+    // is factorized once with a sparse LDLT; a query only visits the samples within the radius.
+    // Far from every sample the interpolant falls back to the mean of the values.
+    class rbf_interpolator : public scattered_interpolator {
+    private:
+        double support_radius;
+        rbf_kernel kernel;
+        double offset = 0.0;
+        Eigen::VectorXd weights;
+
+        void solve(double smoothing);
+        double basis(double distance_squared) const;
+
+    public:
+        rbf_interpolator(const std::vector<scattered_point>& points, double support_radius,
+                         rbf_kernel kernel = rbf_kernel::wendland_c2, double smoothing = 0.0);
+        rbf_interpolator(const std::vector<std::optional<double>>& xs,
+                         const std::vector<std::optional<double>>& ys,
+                         const std::vector<std::optional<double>>& sample_values,
+                         double support_radius, rbf_kernel kernel = rbf_kernel::wendland_c2, double smoothing = 0.0);
+
+        double operator()(double x, double y) const override;
+    };
+}
+
+#endif
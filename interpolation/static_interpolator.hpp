@@ -0,0 +1,146 @@
+#ifndef STATIC_INTERPOLATOR_HPP
+#define STATIC_INTERPOLATOR_HPP
+
+#include "interpolator.hpp"
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace scitool {
+
+    // Interpolation methods available for static_interpolator
+    struct linear_method {};
+    struct polynomial_method {};
+
+    // Interpolator over a fixed number N of knots known at compile time (e.g. small calibration tables).
+    // Knots live in std::arrays inside the object and every loop has a compile-time trip count, so
+    // evaluation is fully unrolled and inlined into the caller, with no virtual call. Tables can be
+    // built in constant expressions; knots must be given in strictly increasing order of x.
+    // Use make_dynamic_interpolator to pass a table where a scitool::interpolator is expected.
+    template<typename Method, std::size_t N>
+    class static_interpolator {
+        static_assert(N >= 2, "At least two points are needed to perform interpolation");
+        static_assert(std::is_same_v<Method, linear_method> || std::is_same_v<Method, polynomial_method>,
+                      "Unsupported interpolation method");
+
+    public:
+        constexpr static_interpolator(const std::array<double, N> &x_values, const std::array<double, N> &y_values)
+                : xs(x_values), ys(y_values) {
+            for (std::size_t i = 1; i < N; ++i)
+                if (!(xs[i - 1] < xs[i]))
+                    throw std::invalid_argument("Knots of a static interpolator must have strictly increasing \"x\"");
+
+            if constexpr (std::is_same_v<Method, linear_method>) {
+                for (std::size_t i = 0; i + 1 < N; ++i)
+                    coefficients[i] = (ys[i + 1] - ys[i]) / (xs[i + 1] - xs[i]);
+            } else {
+                // barycentric weights; with at most a few dozen knots the products do not overflow
+                for (std::size_t j = 0; j < N; ++j) {
+                    double product = 1.0;
+                    for (std::size_t k = 0; k < N; ++k)
+                        if (k != j) product *= xs[j] - xs[k];
+                    coefficients[j] = 1.0 / product;
+                }
+            }
+        }
+
+        constexpr double operator()(double x_val) const {
+            if (x_val < xs[0] || x_val > xs[N - 1])
+                throw std::out_of_range("Interpolation point out of range");
+
+            std::size_t i = segment_index<N - 1>(0, x_val);
+
+            if constexpr (std::is_same_v<Method, linear_method>) {
+                return ys[i] + coefficients[i] * (x_val - xs[i]);
+            } else {
+                // the barycentric formula is singular on the knots themselves
+                if (x_val == xs[i]) return ys[i];
+                if (x_val == xs[i + 1]) return ys[i + 1];
+                return barycentric(x_val, std::make_index_sequence<N>{});
+            }
+        }
+
+        std::vector<point> points() const {
+            std::vector<point> result;
+            result.reserve(N);
+            for (std::size_t i = 0; i < N; ++i) result.emplace_back(xs[i], ys[i]);
+            return result;
+        }
+
+        constexpr const std::array<double, N> &get_x() const {
+            return xs;
+        }
+
+        constexpr const std::array<double, N> &get_y() const {
+            return ys;
+        }
+
+        static constexpr std::size_t size() {
+            return N;
+        }
+
+    private:
+        std::array<double, N> xs{};
+        std::array<double, N> ys{};
+        // slopes of the segments for linear_method, barycentric weights for polynomial_method
+        std::array<double, N> coefficients{};
+
+        // branchless binary search over Length segments starting at lo, unrolled by the recursion
+        template<std::size_t Length>
+        constexpr std::size_t segment_index(std::size_t lo, double x_val) const {
+            if constexpr (Length <= 1) {
+                return lo;
+            } else {
+                constexpr std::size_t half = Length / 2;
+                lo = xs[lo + half] <= x_val ? lo + half : lo;
+                return segment_index<Length - half>(lo, x_val);
+            }
+        }
+
+        template<std::size_t... I>
+        constexpr double barycentric(double x_val, std::index_sequence<I...>) const {
+            double numerator = ((coefficients[I] / (x_val - xs[I]) * ys[I]) + ...);
+            double denominator = ((coefficients[I] / (x_val - xs[I])) + ...);
+            return numerator / denominator;
+        }
+    };
+
+    template<typename Method, std::size_t N>
+    constexpr static_interpolator<Method, N> make_static_interpolator(const double (&x_values)[N], const double (&y_values)[N]) {
+        std::array<double, N> xs{}, ys{};
+        for (std::size_t i = 0; i < N; ++i) {
+            xs[i] = x_values[i];
+            ys[i] = y_values[i];
+        }
+        return static_interpolator<Method, N>(xs, ys);
+    }
+
+    // Adapter exposing a static_interpolator through the virtual scitool::interpolator interface,
+    // for the code (and the bindings) that store interpolators behind a base pointer
+    template<typename Method, std::size_t N>
+    class static_interpolator_adapter : public interpolator {
+    private:
+        static_interpolator<Method, N> table;
+
+    public:
+        explicit static_interpolator_adapter(const static_interpolator<Method, N> &table)
+                : interpolator(table.get_x().data(), table.get_y().data(), N), table(table) {}
+
+        double operator()(double point) const override {
+            return table(point);
+        }
+
+        const static_interpolator<Method, N> &get_table() const {
+            return table;
+        }
+    };
+
+    template<typename Method, std::size_t N>
+    std::unique_ptr<interpolator> make_dynamic_interpolator(const static_interpolator<Method, N> &table) {
+        return std::make_unique<static_interpolator_adapter<Method, N>>(table);
+    }
+}
+
+#endif
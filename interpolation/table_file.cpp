@@ -0,0 +1,209 @@
+#include "table_file.hpp"
+#include "linear_interpolator.hpp"
+#include "polynomial_interpolator.hpp"
+#include "cardinal_cubic_bspline_Interpolator.hpp"
+#include "chebyshev_interpolator.hpp"
+#include "profiling.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace scitool {
+    namespace {
+        const char magic[8] = {'S', 'C', 'I', 'T', 'A', 'B', 'L', 'E'};
+        constexpr std::uint32_t byte_order_mark = 0x01020304;
+        constexpr size_t alignment = 64;
+
+        struct file_header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t kind;
+            std::uint32_t byte_order;
+            std::uint32_t array_count;
+            std::uint64_t file_size;
+        };
+
+        struct directory_entry {
+            std::uint32_t type;
+            std::uint32_t reserved;
+            std::uint64_t count;
+            std::uint64_t offset;
+        };
+
+        size_t element_size(std::uint32_t type) {
+            return type == 1 ? sizeof(double) : sizeof(std::uint32_t);
+        }
+
+        size_t aligned(size_t offset) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    void table_writer::write(const std::string &path) const {
+        SCITOOL_PROFILE_SCOPE("interpolator.save");
+        file_header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = table_file_version;
+        header.kind = static_cast<std::uint32_t>(kind);
+        header.byte_order = byte_order_mark;
+        header.array_count = static_cast<std::uint32_t>(arrays.size());
+
+        std::vector<directory_entry> directory;
+        size_t offset = aligned(sizeof(file_header) + arrays.size() * sizeof(directory_entry));
+        for (const auto &array : arrays) {
+            directory.push_back({array.type, 0, array.count, offset});
+            offset = aligned(offset + array.count * element_size(array.type));
+        }
+        header.file_size = offset;
+
+#ifdef _WIN32
+        std::string temporary = path + ".tmp" + std::to_string(::_getpid());
+#else
+        std::string temporary = path + ".tmp" + std::to_string(::getpid());
+#endif
+        std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(temporary.c_str(), "wb"), std::fclose);
+        if (!file)
+            throw std::runtime_error("Unable to open the output file " + temporary);
+
+        // the padding before every array is shorter than the alignment
+        const char padding[alignment] = {};
+        size_t position = sizeof(header) + directory.size() * sizeof(directory_entry);
+        size_t written = std::fwrite(&header, 1, sizeof(header), file.get());
+        written += std::fwrite(directory.data(), 1, directory.size() * sizeof(directory_entry), file.get());
+        for (size_t i = 0; i < arrays.size(); i++) {
+            size_t bytes = arrays[i].count * element_size(arrays[i].type);
+            written += std::fwrite(padding, 1, directory[i].offset - position, file.get());
+            if (bytes > 0) written += std::fwrite(arrays[i].data, 1, bytes, file.get());
+            position = directory[i].offset + bytes;
+        }
+        written += std::fwrite(padding, 1, header.file_size - position, file.get());
+
+        bool failed = written != header.file_size || std::fflush(file.get()) != 0 || std::ferror(file.get());
+        failed = std::fclose(file.release()) != 0 || failed;
+#ifdef _WIN32
+        // std::rename does not replace an existing file on Windows
+        failed = failed || !::MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        failed = failed || std::rename(temporary.c_str(), path.c_str()) != 0;
+#endif
+        if (failed) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Unable to write the output file " + path);
+        }
+    }
+
+    table_reader::table_reader(std::string_view file) : path(file) {
+        SCITOOL_PROFILE_SCOPE("interpolator.load");
+#ifdef _WIN32
+        HANDLE handle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Unable to open file " + path + ": error " + std::to_string(::GetLastError()));
+
+        LARGE_INTEGER length{};
+        void *start = nullptr;
+        if (::GetFileSizeEx(handle, &length) && static_cast<size_t>(length.QuadPart) >= sizeof(file_header)) {
+            mapped_size = static_cast<size_t>(length.QuadPart);
+            HANDLE section = ::CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (section != nullptr) {
+                start = ::MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+                // the view stays valid once the section and the file are closed
+                ::CloseHandle(section);
+            }
+        }
+        ::CloseHandle(handle);
+        if (start == nullptr)
+            corrupt("it is too small or cannot be mapped");
+
+        mapping = std::shared_ptr<const void>(start, [](const void *address) {
+            ::UnmapViewOfFile(address);
+        });
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0)
+            throw std::runtime_error("Unable to open file " + path + ": " + std::strerror(errno));
+
+        struct stat status{};
+        void *start = MAP_FAILED;
+        if (::fstat(descriptor, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(file_header)) {
+            mapped_size = static_cast<size_t>(status.st_size);
+            start = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, descriptor, 0);
+        }
+        // the mapping stays valid once the descriptor is closed
+        ::close(descriptor);
+        if (start == MAP_FAILED)
+            corrupt("it is too small or cannot be mapped");
+
+        size_t length = mapped_size;
+        mapping = std::shared_ptr<const void>(start, [length](const void *address) {
+            ::munmap(const_cast<void *>(address), length);
+        });
+#endif
+
+        file_header header{};
+        std::memcpy(&header, start, sizeof(header));
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+            corrupt("it is not an interpolator file");
+        if (header.byte_order != byte_order_mark)
+            corrupt("it was written on a machine with a different byte order");
+        if (header.version != table_file_version)
+            corrupt("version " + std::to_string(header.version) + " is not supported");
+        if (header.file_size != mapped_size)
+            corrupt("it is truncated");
+        if (header.array_count > (mapped_size - sizeof(header)) / sizeof(directory_entry))
+            corrupt("its directory is truncated");
+        file_kind = static_cast<table_kind>(header.kind);
+
+        const char *bytes = static_cast<const char *>(start);
+        for (size_t i = 0; i < header.array_count; i++) {
+            directory_entry item{};
+            std::memcpy(&item, bytes + sizeof(header) + i * sizeof(directory_entry), sizeof(item));
+            if (item.type != 1 && item.type != 2)
+                corrupt("array " + std::to_string(i) + " has an unknown type");
+            if (item.offset % alignment != 0 || item.offset > mapped_size ||
+                item.count > (mapped_size - item.offset) / element_size(item.type))
+                corrupt("array " + std::to_string(i) + " lies outside the file");
+            arrays.push_back({item.type, item.count, item.offset});
+        }
+    }
+
+    void table_reader::corrupt(const std::string &reason) const {
+        throw std::runtime_error("Unable to load the interpolator file " + path + ": " + reason);
+    }
+
+    const void *table_reader::locate(size_t index, std::uint32_t type) const {
+        if (index >= arrays.size())
+            corrupt("array " + std::to_string(index) + " is missing");
+        if (arrays[index].type != type)
+            corrupt("array " + std::to_string(index) + " has the wrong type");
+        return static_cast<const char *>(mapping.get()) + arrays[index].offset;
+    }
+
+    std::unique_ptr<interpolator> load_interpolator(const std::string &path) {
+        table_reader table(path);
+        switch (table.kind()) {
+            case table_kind::linear:
+                return std::make_unique<linear_interpolator>(table);
+            case table_kind::polynomial:
+                return std::make_unique<polynomial_interpolator>(table);
+            case table_kind::cardinal_cubic_bspline:
+                return std::make_unique<cardinal_cubic_bspline_interpolator>(table);
+            case table_kind::chebyshev:
+                return std::make_unique<chebyshev_interpolator>(table);
+        }
+        table.corrupt("its interpolator type is unknown");
+    }
+}
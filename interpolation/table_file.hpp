@@ -0,0 +1,199 @@
+#ifndef TABLE_FILE_HPP
+#define TABLE_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace scitool {
+
+    class interpolator;
+
+    // Read-only contiguous values of an interpolator: the knots and the precomputed coefficients. They are either
+    // owned, for an interpolator built from points, or stored in a file mapped in memory (see load_interpolator),
+    // in which case the array only points into the mapping and keeps it alive
+    template<typename T>
+    class table_array {
+    private:
+        std::vector<T> owned;
+        const T *values = nullptr;
+        size_t count = 0;
+        std::shared_ptr<const void> mapping;
+
+    public:
+        table_array() = default;
+
+        table_array(std::vector<T> values)
+                : owned(std::move(values)), values(owned.data()), count(owned.size()) {}
+
+        table_array(const T *values, size_t count, std::shared_ptr<const void> mapping)
+                : values(values), count(count), mapping(std::move(mapping)) {}
+
+        table_array(const table_array &other)
+                : owned(other.owned), values(other.mapping ? other.values : owned.data()), count(other.count),
+                  mapping(other.mapping) {}
+
+        table_array(table_array &&other) noexcept
+                : owned(std::move(other.owned)), values(other.mapping ? other.values : owned.data()), count(other.count),
+                  mapping(std::move(other.mapping)) {
+            other.values = nullptr;
+            other.count = 0;
+        }
+
+        table_array &operator=(table_array other) noexcept {
+            owned.swap(other.owned);
+            mapping.swap(other.mapping);
+            values = mapping ? other.values : owned.data();
+            count = other.count;
+            return *this;
+        }
+
+        const T &operator[](size_t i) const {
+            return values[i];
+        }
+
+        const T *data() const {
+            return values;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        const T *begin() const {
+            return values;
+        }
+
+        const T *end() const {
+            return values + count;
+        }
+
+        const T &front() const {
+            return values[0];
+        }
+
+        const T &back() const {
+            return values[count - 1];
+        }
+
+        // true when the values are read in place from a mapped file
+        bool mapped() const {
+            return mapping != nullptr;
+        }
+
+        std::vector<T> to_vector() const {
+            return std::vector<T>(begin(), end());
+        }
+    };
+
+    // Interpolator types that can be saved; the value is stored in the files, so it must not change
+    enum class table_kind : std::uint32_t {
+        linear = 1,
+        polynomial = 2,
+        cardinal_cubic_bspline = 3,
+        chebyshev = 4
+    };
+
+    // Layout of an interpolator file (version 1, native byte order, which is checked when loading):
+    //   header:    magic "SCITABLE", version, kind, byte-order mark, array count, file size
+    //   directory: for every array its element type (1 for double, 2 for uint32), count and offset
+    //   arrays:    each starting on a 64-byte boundary, so that they are used in place once the file is mapped
+    // Every interpolator writes its knots (x then y) first, then its own arrays in a fixed order.
+    constexpr std::uint32_t table_file_version = 1;
+
+    class table_writer {
+    private:
+        struct entry {
+            std::uint32_t type;
+            const void *data;
+            size_t count;
+        };
+
+        table_kind kind;
+        std::vector<entry> arrays;
+
+    public:
+        explicit table_writer(table_kind kind) : kind(kind) {}
+
+        // the arrays are only referenced until write returns
+        void add(const table_array<double> &values) {
+            arrays.push_back({1, values.data(), values.size()});
+        }
+
+        void add(const table_array<std::uint32_t> &values) {
+            arrays.push_back({2, values.data(), values.size()});
+        }
+
+        void add(table_array<double> &&) = delete;
+        void add(table_array<std::uint32_t> &&) = delete;
+
+        // Writes a temporary file next to path and renames it over path, so that processes which mapped
+        // the previous version keep reading it unchanged. Windows does not replace a file while it is
+        // mapped: there the write fails until the readers are gone
+        void write(const std::string &path) const;
+    };
+
+    class table_reader {
+    private:
+        std::string path;
+        std::shared_ptr<const void> mapping;
+        size_t mapped_size = 0;
+        table_kind file_kind;
+        struct entry {
+            std::uint32_t type;
+            std::uint64_t count;
+            std::uint64_t offset;
+        };
+        std::vector<entry> arrays;
+
+        template<typename T>
+        static constexpr std::uint32_t type_of() {
+            return std::is_same_v<T, double> ? 1 : 2;
+        }
+
+        const void *locate(size_t index, std::uint32_t type) const;
+
+    public:
+        // maps the file read-only and checks its header and that every array lies inside the file. The path is
+        // a string_view so that braced lists such as {{1.0, 2.0}} never convert to a reader (they are points)
+        explicit table_reader(std::string_view path);
+
+        table_kind kind() const {
+            return file_kind;
+        }
+
+        size_t array_count() const {
+            return arrays.size();
+        }
+
+        // the array at index, pointing into the mapping. With expected_count, a different size is an error
+        template<typename T>
+        table_array<T> array(size_t index, size_t expected_count = SIZE_MAX) const {
+            const void *start = locate(index, type_of<T>());
+            size_t count = static_cast<size_t>(arrays[index].count);
+            if (expected_count != SIZE_MAX && count != expected_count)
+                corrupt("array " + std::to_string(index) + " has " + std::to_string(count) + " values instead of " +
+                        std::to_string(expected_count));
+            return table_array<T>(static_cast<const T *>(start), count, mapping);
+        }
+
+        // throws the error of a file that does not hold what its header announces
+        [[noreturn]] void corrupt(const std::string &reason) const;
+    };
+
+    // Loads an interpolator saved with interpolator::save. The file is mapped and its arrays are used in
+    // place: nothing is sorted, checked value by value or solved again, and processes loading the same file
+    // share its pages through the page cache. The mapping lives as long as the interpolator
+    std::unique_ptr<interpolator> load_interpolator(const std::string &path);
+}
+
+#endif
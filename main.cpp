@@ -2,8 +2,13 @@
 #include "interpolation/linear_interpolator.hpp"
 #include "interpolation/polynomial_interpolator.hpp"
 #include "interpolation/cardinal_cubic_bspline_Interpolator.hpp"
+#include "interpolation/static_interpolator.hpp"
+#include "interpolation/chebyshev_interpolator.hpp"
+#include "interpolation/scattered_interpolator.hpp"
 #include "statistics/stat_utils.hpp"
 #include "statistics/dataset.hpp"
+#include "cli/command_line.hpp"
+#include <iomanip>
 #include <map>
 
 std::vector<scitool::point> generate_points(const std::function<double(double)>& function, double start, double end, double increment) {
@@ -25,11 +30,13 @@ std::vector<scitool::point> generate_points(const std::function<double(double)>&
 }
 
 
-double calcuate_interpolator_MAE(const std::unique_ptr<scitool::interpolator>& interpolator, const std::vector<scitool::point>& test_points, const std::function<double(double)>& function) {
+// templated on the interpolator type, so that static interpolators are inlined in the loop
+template <typename Interpolator>
+double calcuate_interpolator_MAE(const Interpolator& interpolator, const std::vector<scitool::point>& test_points, const std::function<double(double)>& function) {
     double total_error = 0.0;
 
     for (const auto& point : test_points) {
-        double interpolated_value = (*interpolator)(point.x);
+        double interpolated_value = interpolator(point.x);
         double actual_value = function(point.x);
         double error = std::abs(interpolated_value - actual_value);
         total_error += error;
@@ -67,6 +74,13 @@ void test_all_interpolators(const int min_points = 10, const int max_points = 50
         std::cout << "Testing with only 3 points and the cardinal cubic B-Spline interpolator, got: " << e.what() << std::endl;
     }
 
+    {
+        // a NaN sample used to stall the merge of equal coordinates
+        scitool::idw_interpolator interpolator({{0.0, 0.0, 1.0}, {std::nan(""), 0.0, 3.0}, {1.0, 0.0, 2.0}, {2.0, 0.0, INFINITY}});
+        std::cout << "Testing scattered samples with non-finite values, kept " << interpolator.size() << " of 4 samples, value at (0.5, 0): "
+                  << interpolator(0.5, 0.0) << std::endl;
+    }
+
     std::cout << std::endl << "2) Testing interpolator functionality" << std::endl;
     std::map<std::string, std::function<double(double)>> functions;
     functions["sin(x)"] = [](double x) { return sin(x); };
@@ -85,12 +99,43 @@ void test_all_interpolators(const int min_points = 10, const int max_points = 50
 
             std::cout << "Testing with " << func.first << " function and " << point_count << " points." << std::endl;
             for (const auto& interpolator : interpolators) {
-                std::cout << "Interpolator: " << interpolator.first  << ", MAE: " << calcuate_interpolator_MAE(interpolator.second, test_points, func.second) << std::endl;
+                std::cout << "Interpolator: " << interpolator.first  << ", MAE: " << calcuate_interpolator_MAE(*interpolator.second, test_points, func.second) << std::endl;
             }
 
             std::cout << "\n";
         }
     }
+
+    std::cout << "3) Testing compile-time interpolators" << std::endl;
+    for (const auto& func : functions) {
+        std::array<double, 16> xs{}, ys{};
+        for (size_t i = 0; i < xs.size(); i++) {
+            xs[i] = static_cast<double>(i);
+            ys[i] = func.second(xs[i]);
+        }
+        std::vector<scitool::point> test_points = generate_points(func.second, 0.5, 15, 3);
+
+        scitool::static_interpolator<scitool::linear_method, 16> linear(xs, ys);
+        scitool::static_interpolator<scitool::polynomial_method, 16> polynomial(xs, ys);
+
+        std::cout << "Testing with " << func.first << " function and 16 compile-time knots." << std::endl;
+        std::cout << "Interpolator: StaticLinearInterpolator, MAE: " << calcuate_interpolator_MAE(linear, test_points, func.second) << std::endl;
+        std::cout << "Interpolator: StaticPolynomialInterpolator, MAE: " << calcuate_interpolator_MAE(polynomial, test_points, func.second) << std::endl;
+        std::cout << "\n";
+    }
+
+    std::cout << "4) Testing adaptive approximation tables" << std::endl;
+    for (const auto& func : functions) {
+        scitool::approximation_options options;
+        options.max_error = 1e-10;
+        scitool::chebyshev_interpolator table(func.second, 0.0, 50.0, options);
+        std::vector<scitool::point> test_points = generate_points(func.second, 0.5, 49, 3);
+
+        std::cout << "Testing with " << func.first << " function: " << table.segment_count() << " segments of degree "
+                  << table.degree() << " from " << table.function_evaluations() << " function calls." << std::endl;
+        std::cout << "Interpolator: ChebyshevInterpolator, MAE: " << calcuate_interpolator_MAE(table, test_points, func.second) << std::endl;
+        std::cout << "\n";
+    }
 }
 
 std::vector<scitool::point> get_user_defined_points() {
@@ -255,9 +300,13 @@ void handle_statistics_module() {
                     std::cout << "Please load a CSV file first.\n";
                     break;
                 }
-                std::cout << "Enter the path to the output file: ";
+                std::cout << "Enter the path to the output file ('-' for the terminal): ";
                 std::cin >> outputFilePath;
-                ds->output_statistics(outputFilePath);
+                try {
+                    ds->output_statistics(outputFilePath);
+                } catch (std::exception& e) {
+                    std::cout << "Unable to write the statistics. " << e.what() << std::endl;
+                }
                 break;
             }
             case 4: {
@@ -294,7 +343,11 @@ void handle_statistics_module() {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // with arguments the toolbox runs non-interactively (see cli/command_line.hpp)
+    if (argc > 1) {
+        return scitool::cli::run(std::vector<std::string>(argv + 1, argv + argc));
+    }
 
     while (true) {
         std::cout << "Choose a module:\n";
@@ -8,12 +8,20 @@ class AkimaSplineInterpolator(ExtendedInterpolator):
     def __init__(self, points: List[Point]):
         super().__init__(points)
 
-        x = [point.x for point in points]
-        y = [point.y for point in points]
-        self.spline = Akima1DInterpolator(x, y)
+        # x and y are the sorted knots kept by the C++ base class, shared without copies
+        self.spline = Akima1DInterpolator(self.x, self.y)
 
     def __call__(self, point: float) -> float:
-        if point < self.points[0].x or point > self.points[-1].x:
+        if point < self.x[0] or point > self.x[-1]:
             raise ValueError("Interpolation point out of range")
 
         return self.spline(point)
+
+    def derivative(self, x: float, order: int = 1) -> float:
+        if x < self.x[0] or x > self.x[-1]:
+            raise ValueError("Interpolation point out of range")
+
+        return float(self.spline(x, nu=order))
+
+    def integrate(self, a: float, b: float) -> float:
+        return float(self.spline.integrate(a, b))
@@ -5,8 +5,8 @@ import matplotlib.pyplot as plt
 # Advanced interpolator base class that integrates the c++ interpolator.
 class ExtendedInterpolator(Interpolator):
     def plot(self):
-        x_points = [point.x for point in self.points]
-        y_points = [point.y for point in self.points]
+        x_points = self.x
+        y_points = self.y
         x_interpolated = np.arange(x_points[0], x_points[-1], 0.001)
         y_interpolated = np.array([self(i) for i in x_interpolated.tolist()])
 
@@ -21,23 +21,16 @@ class ExtendedInterpolator(Interpolator):
         plt.show()
 
     def __len__(self):
-        return len(self.points)
+        return len(self.x)
 
-    def derivative(self, x_value):
-        epsilon = 1e-6
-        f_x = self(x_value)
-        f_x_plus_epsilon = self(x_value + epsilon)
-        return (f_x_plus_epsilon - f_x) / epsilon
-
-    def integral(self, start_x, end_x, num_samples=1000):
+    # derivative(x, order=1) and integrate(a, b) are inherited from the C++ interpolator:
+    # the C++ interpolators compute them in closed form, python subclasses get a numerical
+    # fallback unless they override them (as the Akima interpolator does)
+    def integral(self, start_x, end_x):
         if start_x >= end_x:
             raise ValueError("Start x-value should be less than the end x-value.")
 
-        x_values = np.linspace(start_x, end_x, num_samples)
-        y_values = [self(x) for x in x_values]
-
-        integral_value = np.trapz(y_values, x=x_values)
-        return integral_value
+        return self.integrate(start_x, end_x)
 
     # For new python interpolators (like Akime) we can extend this class,
     # but for c++ interpolator classes, we cannot extend it or modify the code.
@@ -50,6 +43,10 @@ class ExtendedInterpolator(Interpolator):
                 self.interpolator = interpolator
             def __call__(self, point: float):
                 return self.interpolator(point)
+            def derivative(self, x, order=1):
+                return self.interpolator.derivative(x, order)
+            def integrate(self, a, b):
+                return self.interpolator.integrate(a, b)
 
         new_interpolator = NewExtendedInterpolator(interpolator)
-        return new_interpolator
\ No newline at end of file
+        return new_interpolator
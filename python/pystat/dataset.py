@@ -6,8 +6,8 @@ import matplotlib.pyplot as plt
 
 
 class PyDataset:
-    def __init__(self, csv_file):
-        self._dataset = statistics_py.Dataset.from_csv(csv_file)
+    def __init__(self, csv_file, threads=0, block_size=4 << 20):
+        self._dataset = statistics_py.Dataset.from_csv(csv_file, block_size=block_size, threads=threads)
 
     def is_categorical(self, column_name):
         return self._dataset.is_categorical(column_name)
@@ -24,15 +24,76 @@ class PyDataset:
     def variance(self, column_name):
         return self._dataset.variance(column_name)
 
+    def quantile(self, column_name, q):
+        return self._dataset.quantile(column_name, q)
+
+    def quantiles(self, column_name, qs):
+        return self._dataset.quantiles(column_name, qs)
+
+    def histogram(self, column_name, bins=10, range=None):
+        return self._dataset.histogram(column_name, bins, range)
+
+    def histogram_2d(self, x_column, y_column, bins=10):
+        return self._dataset.histogram_2d(x_column, y_column, bins)
+
+    def sort_by(self, columns, ascending=True):
+        return self._dataset.sort_by(columns, ascending)
+
+    def top_n(self, column_name, n, largest=True):
+        return self._dataset.top_n(column_name, n, largest)
+
     def frequency_count(self, column_name):
         return self._dataset.frequency_count(column_name)
 
+    @classmethod
+    def from_numpy(cls, values, columns):
+        dataset = cls.__new__(cls)
+        dataset._dataset = statistics_py.Dataset.from_numpy(values, columns)
+        return dataset
+
+    @classmethod
+    def from_csv_with_stats(cls, csv_file, threads=0, block_size=4 << 20):
+        dataset = cls.__new__(cls)
+        dataset._dataset, stats = statistics_py.Dataset.from_csv_with_stats(csv_file, block_size=block_size, threads=threads)
+        return dataset, stats
+
+    def numerical_column(self, column_name):
+        return self._dataset.numerical_column(column_name)
+
+    def column(self, column_name, masked=False):
+        # NumPy array filled by C++, NaN (or masked) for missing values
+        return self._dataset.column(column_name, masked)
+
+    def to_numpy(self, columns=None):
+        return self._dataset.to_numpy(columns)
+
     @property
     def correlation_matrix(self):
         # Convert the Eigen matrix to a Numpy array and return it
         eigen_matrix = self._dataset.correlation_matrix
         return np.array(eigen_matrix)
 
+    def covariance_matrix(self, columns=None):
+        return np.array(self._dataset.covariance_matrix(columns or []))
+
+    # result.terms starts with "intercept", then the predictors, in the order of result.coefficients
+    def regress(self, target, predictors):
+        return self._dataset.regress(target, predictors)
+
+    @staticmethod
+    def regress_csv(csv_file, target, predictors, chunk_rows=65536):
+        return statistics_py.Dataset.regress_csv(csv_file, target, predictors, chunk_rows)
+
+    # result.lower and result.upper bound the interval, result.replicates holds the statistic of every replicate
+    def bootstrap(self, column_name, statistic, replicates=1000, confidence=0.95, seed=0):
+        return self._dataset.bootstrap(column_name, statistic, replicates, confidence, seed)
+
+    def bootstrap_quantile(self, column_name, q, replicates=1000, confidence=0.95, seed=0):
+        return self._dataset.bootstrap_quantile(column_name, q, replicates, confidence, seed)
+
+    def bootstrap_correlation(self, x_column, y_column, replicates=1000, confidence=0.95, seed=0):
+        return self._dataset.bootstrap_correlation(x_column, y_column, replicates, confidence, seed)
+
     def display_correlation_matrix(self):
         # Get the correlation matrix
         corr_matrix = self.correlation_matrix
@@ -45,6 +106,15 @@ class PyDataset:
     def output_statistics(self, output_file):
         self._dataset.output_statistics(output_file)
 
+    # format is one of 'text', 'csv', 'json' or 'markdown', statistics a subset of
+    # ['mean', 'median', 'std_dev', 'variance']
+    def report(self, format='text', columns=None, statistics=None, frequency_counts=True, correlation=True, threads=0):
+        return self._dataset.report(format, columns, statistics, frequency_counts, correlation, threads)
+
+    def write_report(self, output_file, format='text', columns=None, statistics=None, frequency_counts=True,
+                     correlation=True, threads=0):
+        self._dataset.write_report(output_file, format, columns, statistics, frequency_counts, correlation, threads)
+
     @property
     def file_name(self):
         return self._dataset.file_name
@@ -55,6 +125,51 @@ class PyDataset:
     def filter_rows(self, column_name, func):
         return self._dataset.filter_rows(column_name, func)
 
+    # e.g. dataset.lazy().map("median_income", "log").filter("housing_median_age", ">", 20).agg([("median_income", "mean")])
+    def lazy(self):
+        return self._dataset.lazy()
+
+    # e.g. dataset.rolling(["median_income"], 20, "median"), a new dataset with the same columns and rows
+    def rolling(self, columns, window, statistic="mean", min_periods=0):
+        rolled = PyDataset.__new__(PyDataset)
+        rolled._dataset = self._dataset.rolling(columns, window, min_periods).apply(statistic)
+        return rolled
+
+    def cumulative(self, columns, statistic="sum", min_periods=1):
+        accumulated = PyDataset.__new__(PyDataset)
+        accumulated._dataset = self._dataset.cumulative(columns, min_periods).apply(statistic)
+        return accumulated
+
+    # method is one of 'ffill', 'bfill', 'mean' or 'median'; the columns are filled in place
+    def fill_missing(self, columns, method, threads=0):
+        return self._dataset.fill_missing(columns, method, threads)
+
+    # e.g. dataset.interpolate_missing(["total_bedrooms"], "total_rooms"), 'linear' or 'polynomial'
+    def interpolate_missing(self, columns, by_column, method="linear", threads=0):
+        return self._dataset.interpolate_missing(columns, by_column, method, threads)
+
+    def join(self, other, on, how="inner"):
+        joined = PyDataset.__new__(PyDataset)
+        joined._dataset = self._dataset.join(other._dataset, on, how)
+        return joined
+
+    def filter_categories(self, column_name, values):
+        return self._dataset.filter_categories(column_name, values)
+
+    def set_run_length_encoding(self, column_name, enabled):
+        self._dataset.set_run_length_encoding(column_name, enabled)
+
+    @property
+    def memory_usage(self):
+        return self._dataset.memory_usage
+
+    # the batched variants call func once per NumPy chunk instead of once per value
+    def map_column_batched(self, column_name, func, chunk_size=65536):
+        return self._dataset.map_column_batched(column_name, func, chunk_size)
+
+    def filter_rows_batched(self, column_name, func, chunk_size=65536):
+        return self._dataset.filter_rows_batched(column_name, func, chunk_size)
+
     def __iter__(self):
         # Iterate over the C++ dataset and convert each data_row to a Python list
         for i in range(len(self._dataset)):
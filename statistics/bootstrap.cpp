@@ -0,0 +1,311 @@
+#include "bootstrap.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace scitool {
+
+    namespace {
+        constexpr unsigned max_weight = 15;
+        // replicates of a task, whose weights are drawn against the same chunk of values while it is in the cache
+        constexpr size_t replicates_per_task = 16;
+        constexpr size_t rows_per_chunk = 4096;
+
+        // thresholds[k]: 2^64 times the probability of a Poisson(1) variate to be at most k
+        std::array<std::uint64_t, max_weight> poisson_thresholds() {
+            std::array<std::uint64_t, max_weight> thresholds{};
+            long double probability = std::exp(-1.0L), cumulative = 0.0L;
+            for (unsigned k = 0; k < max_weight; ++k) {
+                cumulative += probability;
+                probability /= static_cast<long double>(k + 1);
+                thresholds[k] = static_cast<std::uint64_t>(std::ldexp(cumulative, 64));
+            }
+            return thresholds;
+        }
+
+        const std::array<std::uint64_t, max_weight> thresholds = poisson_thresholds();
+
+        // The weight of the 2^52 values of bits whose top 12 bits are c, or the first weight to search from with
+        // uncertain set when a threshold falls inside them (15 of the 4096 cells). The table stays in L1, so most
+        // weights take one load instead of a walk through the thresholds, whose branches are unpredictable
+        constexpr int table_bits = 12;
+        constexpr unsigned char uncertain = 0x80;
+
+        std::array<unsigned char, size_t(1) << table_bits> poisson_table() {
+            std::array<unsigned char, size_t(1) << table_bits> table{};
+            for (std::uint64_t cell = 0; cell < table.size(); ++cell) {
+                std::uint64_t first = cell << (64 - table_bits), last = first + ((std::uint64_t(1) << (64 - table_bits)) - 1);
+                unsigned low = 0, high = 0;
+                while (low < max_weight && first >= thresholds[low]) ++low;
+                while (high < max_weight && last >= thresholds[high]) ++high;
+                table[cell] = static_cast<unsigned char>(low | (low == high ? 0 : uncertain));
+            }
+            return table;
+        }
+
+        const std::array<unsigned char, size_t(1) << table_bits> weight_table = poisson_table();
+
+        void check_options(const bootstrap_options& options) {
+            if (options.replicates == 0) {
+                throw std::invalid_argument("A bootstrap needs at least one replicate");
+            }
+            if (!(options.confidence > 0.0 && options.confidence < 1.0)) {
+                throw std::invalid_argument("The confidence level must be between 0 and 1");
+            }
+        }
+
+        // the values kept by a bootstrap, with the rows whose counter draws their weights
+        struct sample {
+            std::vector<size_t> rows;
+            std::vector<double> x;
+            std::vector<double> y;
+        };
+
+        // Runs accumulate(key, first, last, replicate) for every replicate, a block of replicates per task and
+        // the rows in chunks, so that every value is read from memory once per block
+        template <typename Accumulate>
+        void for_each_replicate(size_t rows, const bootstrap_options& options, Accumulate accumulate) {
+            size_t tasks = (options.replicates + replicates_per_task - 1) / replicates_per_task;
+            parallel_for(tasks, [&](size_t task) {
+                size_t first_replicate = task * replicates_per_task;
+                size_t last_replicate = std::min(options.replicates, first_replicate + replicates_per_task);
+                for (size_t first = 0; first < rows; first += rows_per_chunk) {
+                    size_t last = std::min(rows, first + rows_per_chunk);
+                    for (size_t r = first_replicate; r < last_replicate; ++r) {
+                        accumulate(stream_key(options.seed, r), first, last, r);
+                    }
+                }
+            }, options.threads);
+        }
+
+        double quantile_of_sorted(const std::vector<double>& sorted, double q) {
+            double position = q * static_cast<double>(sorted.size() - 1);
+            auto lower = static_cast<size_t>(position);
+            if (lower + 1 >= sorted.size()) return sorted.back();
+            return sorted[lower] + (position - static_cast<double>(lower)) * (sorted[lower + 1] - sorted[lower]);
+        }
+
+        bootstrap_result summarize(double estimate, std::vector<double> replicates, double confidence) {
+            bootstrap_result result;
+            result.estimate = estimate;
+            result.confidence = confidence;
+
+            std::vector<double> defined;
+            defined.reserve(replicates.size());
+            for (double value : replicates) {
+                if (!std::isnan(value)) defined.push_back(value);
+            }
+            result.replicates = std::move(replicates);
+            if (defined.empty()) {
+                result.lower = result.upper = result.standard_error = std::numeric_limits<double>::quiet_NaN();
+                return result;
+            }
+
+            std::sort(defined.begin(), defined.end());
+            result.lower = quantile_of_sorted(defined, (1.0 - confidence) / 2.0);
+            result.upper = quantile_of_sorted(defined, (1.0 + confidence) / 2.0);
+
+            double mean = 0.0, squares = 0.0;
+            for (size_t i = 0; i < defined.size(); ++i) {
+                double delta = defined[i] - mean;
+                mean += delta / static_cast<double>(i + 1);
+                squares += delta * (defined[i] - mean);
+            }
+            result.standard_error = defined.size() > 1 ? std::sqrt(squares / static_cast<double>(defined.size() - 1)) : 0.0;
+            return result;
+        }
+
+        // the statistic of weighted values, given the total weight and the weighted sums of the deviations from center
+        double moment_statistic(aggregate statistic, double center, double weight, double sum, double squares) {
+            if (weight == 0.0) return std::numeric_limits<double>::quiet_NaN();
+            double mean = sum / weight;
+            double variance = std::max(0.0, squares / weight - mean * mean);
+            switch (statistic) {
+                case aggregate::sum:
+                    return center * weight + sum;
+                case aggregate::mean:
+                    return center + mean;
+                case aggregate::variance:
+                    return variance;
+                default:
+                    return std::sqrt(variance);
+            }
+        }
+
+        double correlation(double weight, double sx, double sy, double sxx, double syy, double sxy) {
+            if (weight == 0.0) return std::numeric_limits<double>::quiet_NaN();
+            double vx = sxx - sx * sx / weight, vy = syy - sy * sy / weight;
+            if (!(vx > 0.0 && vy > 0.0)) return std::numeric_limits<double>::quiet_NaN();
+            return (sxy - sx * sy / weight) / std::sqrt(vx * vy);
+        }
+    }
+
+    unsigned poisson_weight(std::uint64_t bits) {
+        unsigned k = weight_table[bits >> (64 - table_bits)];
+        if (k & uncertain) {
+            k &= ~unsigned(uncertain);
+            while (k < max_weight && bits >= thresholds[k]) ++k;
+        }
+        return k;
+    }
+
+    bootstrap_result bootstrap_statistic(const double* values, size_t n, aggregate statistic, const bootstrap_options& options) {
+        SCITOOL_PROFILE_SCOPE("bootstrap.statistic");
+        check_options(options);
+        if (statistic != aggregate::sum && statistic != aggregate::mean && statistic != aggregate::variance &&
+            statistic != aggregate::std_dev) {
+            throw std::invalid_argument("Cannot bootstrap the " + aggregate_name(statistic) + " with moments, only the sum, mean, variance and std_dev");
+        }
+
+        // the values are centered on their mean, so that the sums of squares keep their precision
+        sample kept;
+        double center = 0.0;
+        for (size_t row = 0; row < n; ++row) {
+            if (std::isnan(values[row])) continue;
+            kept.rows.push_back(row);
+            kept.x.push_back(values[row]);
+            center += (values[row] - center) / static_cast<double>(kept.x.size());
+        }
+        if (kept.x.empty()) {
+            throw std::runtime_error("Cannot bootstrap a column with all values missing");
+        }
+        for (double& value : kept.x) value -= center;
+
+        double sum = 0.0, squares = 0.0;
+        for (double value : kept.x) {
+            sum += value;
+            squares += value * value;
+        }
+        double estimate = moment_statistic(statistic, center, static_cast<double>(kept.x.size()), sum, squares);
+
+        std::vector<double> weights(options.replicates, 0.0), sums(options.replicates, 0.0), sums_of_squares(options.replicates, 0.0);
+        for_each_replicate(kept.x.size(), options, [&](std::uint64_t key, size_t first, size_t last, size_t r) {
+            double weight = 0.0, s = 0.0, ss = 0.0;
+            for (size_t i = first; i < last; ++i) {
+                auto w = static_cast<double>(poisson_weight(counter_random(key, kept.rows[i])));
+                double x = kept.x[i];
+                weight += w;
+                s += w * x;
+                ss += w * x * x;
+            }
+            weights[r] += weight;
+            sums[r] += s;
+            sums_of_squares[r] += ss;
+        });
+
+        std::vector<double> replicates(options.replicates);
+        for (size_t r = 0; r < options.replicates; ++r) {
+            replicates[r] = moment_statistic(statistic, center, weights[r], sums[r], sums_of_squares[r]);
+        }
+        return summarize(estimate, std::move(replicates), options.confidence);
+    }
+
+    bootstrap_result bootstrap_quantile(const double* values, const size_t* sorted_rows, size_t n, double q,
+                                        const bootstrap_options& options) {
+        SCITOOL_PROFILE_SCOPE("bootstrap.quantile");
+        check_options(options);
+        if (!(q >= 0.0 && q <= 1.0)) {
+            throw std::invalid_argument("Quantiles must be between 0 and 1");
+        }
+        if (n == 0) {
+            throw std::runtime_error("Cannot bootstrap a column with all values missing");
+        }
+
+        // With integer weights a replicate is a multiset of the values: its quantile interpolates between the
+        // values of ranks floor(q * (weight - 1)) and the next one, found walking the values in order
+        auto quantile = [&](const std::vector<unsigned char>& weights, size_t weight) {
+            if (weight == 0) return std::numeric_limits<double>::quiet_NaN();
+            double position = q * static_cast<double>(weight - 1);
+            auto lower = static_cast<size_t>(position);
+            size_t i = 0, below = weights[0];
+            while (below <= lower) below += weights[++i];
+            double a = values[sorted_rows[i]];
+            if (lower + 1 >= weight) return a;
+            while (below <= lower + 1) below += weights[++i];
+            double b = values[sorted_rows[i]];
+            double fraction = position - static_cast<double>(lower);
+            // as dataset::get_quantile, the median of an even count is the mean of the middle two
+            return fraction == 0.5 ? (a + b) / 2.0 : a + fraction * (b - a);
+        };
+
+        double estimate = quantile(std::vector<unsigned char>(n, 1), n);
+
+        // the weights of a replicate are drawn in one pass and kept, the quantile is then a partial second pass
+        std::vector<double> replicates(options.replicates);
+        size_t tasks = (options.replicates + replicates_per_task - 1) / replicates_per_task;
+        parallel_for(tasks, [&](size_t task) {
+            std::vector<unsigned char> weights(n);
+            for (size_t r = task * replicates_per_task; r < std::min(options.replicates, (task + 1) * replicates_per_task); ++r) {
+                std::uint64_t key = stream_key(options.seed, r);
+                size_t weight = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    weights[i] = static_cast<unsigned char>(poisson_weight(counter_random(key, sorted_rows[i])));
+                    weight += weights[i];
+                }
+                replicates[r] = quantile(weights, weight);
+            }
+        }, options.threads);
+
+        return summarize(estimate, std::move(replicates), options.confidence);
+    }
+
+    bootstrap_result bootstrap_correlation(const double* x, const double* y, size_t n, const bootstrap_options& options) {
+        SCITOOL_PROFILE_SCOPE("bootstrap.correlation");
+        check_options(options);
+
+        sample kept;
+        double center_x = 0.0, center_y = 0.0;
+        for (size_t row = 0; row < n; ++row) {
+            if (std::isnan(x[row]) || std::isnan(y[row])) continue;
+            kept.rows.push_back(row);
+            kept.x.push_back(x[row]);
+            kept.y.push_back(y[row]);
+            center_x += (x[row] - center_x) / static_cast<double>(kept.x.size());
+            center_y += (y[row] - center_y) / static_cast<double>(kept.y.size());
+        }
+        if (kept.x.size() < 2) {
+            throw std::runtime_error("Cannot bootstrap a correlation with less than two complete rows");
+        }
+        for (double& value : kept.x) value -= center_x;
+        for (double& value : kept.y) value -= center_y;
+
+        // per replicate: total weight, then the weighted sums of x, y, x^2, y^2 and xy
+        constexpr size_t sums = 6;
+        std::vector<double> moments(options.replicates * sums, 0.0);
+        auto accumulate = [&](auto weight_of, size_t first, size_t last, double* totals) {
+            double s[sums] = {};
+            for (size_t i = first; i < last; ++i) {
+                double w = weight_of(kept.rows[i]);
+                double dx = kept.x[i], dy = kept.y[i];
+                s[0] += w;
+                s[1] += w * dx;
+                s[2] += w * dy;
+                s[3] += w * dx * dx;
+                s[4] += w * dy * dy;
+                s[5] += w * dx * dy;
+            }
+            for (size_t k = 0; k < sums; ++k) totals[k] += s[k];
+        };
+
+        double totals[sums] = {};
+        accumulate([](size_t) { return 1.0; }, 0, kept.x.size(), totals);
+        double estimate = correlation(totals[0], totals[1], totals[2], totals[3], totals[4], totals[5]);
+
+        for_each_replicate(kept.x.size(), options, [&](std::uint64_t key, size_t first, size_t last, size_t r) {
+            accumulate([key](size_t row) { return static_cast<double>(poisson_weight(counter_random(key, row))); },
+                       first, last, &moments[r * sums]);
+        });
+
+        std::vector<double> replicates(options.replicates);
+        for (size_t r = 0; r < options.replicates; ++r) {
+            const double* m = &moments[r * sums];
+            replicates[r] = correlation(m[0], m[1], m[2], m[3], m[4], m[5]);
+        }
+        return summarize(estimate, std::move(replicates), options.confidence);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef BOOTSTRAP_HPP
+#define BOOTSTRAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "lazy_query.hpp"
+#include "random.hpp"
+
+namespace scitool {
+
+    // the key of stream number `stream` of a seed, the streams of a seed being unrelated
+    inline std::uint64_t stream_key(std::uint64_t seed, std::uint64_t stream) {
+        return splitmix64(seed + splitmix64(stream + golden_gamma));
+    }
+
+    // Counter-based random numbers: the bits of (key, counter) are the splitmix64 finalizer of key + counter times
+    // the golden ratio (see random.hpp), so any number of a stream can be drawn on any thread, in any order,
+    // without shared state
+    inline std::uint64_t counter_random(std::uint64_t key, std::uint64_t counter) {
+        return splitmix64(key + (counter + 1) * golden_gamma);
+    }
+
+    // A Poisson(1) variate from 64 uniform bits, by inversion of the distribution function (truncated at 15,
+    // whose tail has a probability below 1e-13)
+    unsigned poisson_weight(std::uint64_t bits);
+
+    struct bootstrap_options {
+        size_t replicates = 1000;
+        // coverage of the percentile interval, between 0 and 1
+        double confidence = 0.95;
+        std::uint64_t seed = 0;
+        // threads computing the replicates, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    // estimate is the statistic of the data, replicates[r] the statistic of replicate r (NaN when it is undefined,
+    // e.g. a replicate with no row). [lower, upper] is the percentile interval of the defined replicates, and
+    // standard_error their standard deviation (divided by their count minus one)
+    struct bootstrap_result {
+        double estimate = 0.0;
+        double lower = 0.0;
+        double upper = 0.0;
+        double standard_error = 0.0;
+        double confidence = 0.0;
+        std::vector<double> replicates;
+    };
+
+    // Poisson bootstrap: replicate r weights row i with the Poisson(1) variate of counter i in stream r of the seed,
+    // instead of drawing a resample of n rows. The weights are computed on the fly, so the replicates are
+    // accumulated in one streaming pass over the values, a block of replicates per task; the result only depends
+    // on the seed, not on the number of threads. Missing values (NaN) are left out.
+    //
+    // statistic is one of sum, mean, variance (population) and std_dev, over values[0..n)
+    bootstrap_result bootstrap_statistic(const double* values, size_t n, aggregate statistic, const bootstrap_options& options = {});
+    // the q-quantile (see dataset::get_quantile) of values, given the n rows of its non-missing values by increasing value
+    bootstrap_result bootstrap_quantile(const double* values, const size_t* sorted_rows, size_t n, double q,
+                                        const bootstrap_options& options = {});
+    // Pearson correlation of x and y over the rows where both have a value
+    bootstrap_result bootstrap_correlation(const double* x, const double* y, size_t n, const bootstrap_options& options = {});
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include "categorical_column.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace scitool {
+
+    categorical_column::categorical_column(std::pmr::memory_resource* resource, std::pmr::memory_resource* string_resource)
+            : resource(resource), string_resource(string_resource), dictionary(1),
+              codes(std::in_place_index<0>, resource), run_codes(resource), run_ends(resource) {}
+
+    categorical_column::code_type categorical_column::intern(std::string_view value) {
+        auto it = codes_by_value.find(value);
+        if (it != codes_by_value.end()) return it->second;
+
+        if (dictionary.size() > std::numeric_limits<code_type>::max()) {
+            throw std::length_error("Too many distinct values in a categorical column");
+        }
+
+        // the string is copied once, with a terminator so that the view never has a null data pointer
+        auto* copy = static_cast<char*>(string_resource->allocate(value.size() + 1, 1));
+        std::copy(value.begin(), value.end(), copy);
+        copy[value.size()] = '\0';
+
+        auto code = static_cast<code_type>(dictionary.size());
+        dictionary.emplace_back(copy, value.size());
+        codes_by_value.emplace(dictionary.back(), code);
+        widen_codes();
+        return code;
+    }
+
+    categorical_column::code_type categorical_column::find(std::string_view value) const {
+        auto it = codes_by_value.find(value);
+        return it == codes_by_value.end() ? missing_code : it->second;
+    }
+
+    void categorical_column::push_code(code_type code) {
+        ++row_count;
+        if (run_length) {
+            if (!run_codes.empty() && run_codes.back() == code) {
+                ++run_ends.back();
+            } else {
+                run_codes.push_back(code);
+                run_ends.push_back(row_count);
+            }
+            return;
+        }
+
+        std::visit([code](auto& values) {
+            values.push_back(static_cast<typename std::decay_t<decltype(values)>::value_type>(code));
+        }, codes);
+    }
+
+    void categorical_column::reserve(size_t rows) {
+        if (!run_length) std::visit([rows](auto& values) { values.reserve(rows); }, codes);
+    }
+
+    categorical_column::code_type categorical_column::code_at(size_t row) const {
+        if (run_length) {
+            auto run = std::upper_bound(run_ends.begin(), run_ends.end(), row);
+            return run_codes[static_cast<size_t>(run - run_ends.begin())];
+        }
+        return std::visit([row](const auto& values) { return static_cast<code_type>(values[row]); }, codes);
+    }
+
+    size_t categorical_column::code_width() const {
+        size_t largest = dictionary.size() - 1;
+        if (largest <= std::numeric_limits<std::uint8_t>::max()) return sizeof(std::uint8_t);
+        if (largest <= std::numeric_limits<std::uint16_t>::max()) return sizeof(std::uint16_t);
+        return sizeof(std::uint32_t);
+    }
+
+    categorical_column::plain_codes categorical_column::make_codes(const std::vector<code_type>& values) const {
+        auto fill = [&values](auto&& target) {
+            target.reserve(values.size());
+            for (code_type code : values) {
+                target.push_back(static_cast<typename std::decay_t<decltype(target)>::value_type>(code));
+            }
+            return plain_codes(std::move(target));
+        };
+
+        switch (code_width()) {
+            case sizeof(std::uint8_t): return fill(code_vector<std::uint8_t>(resource));
+            case sizeof(std::uint16_t): return fill(code_vector<std::uint16_t>(resource));
+            default: return fill(code_vector<std::uint32_t>(resource));
+        }
+    }
+
+    void categorical_column::widen_codes() {
+        // the width only changes when the dictionary outgrows it, so this copy happens at most twice
+        size_t current = std::visit([](const auto& values) {
+            return sizeof(typename std::decay_t<decltype(values)>::value_type);
+        }, codes);
+        if (current >= code_width()) return;
+
+        std::vector<code_type> values;
+        if (!run_length) {
+            values.reserve(row_count);
+            for (size_t row = 0; row < row_count; ++row) values.push_back(code_at(row));
+        }
+        codes = make_codes(values);
+    }
+
+    void categorical_column::set_run_length_encoding(bool enabled) {
+        if (enabled == run_length) return;
+
+        if (enabled) {
+            run_codes.clear();
+            run_ends.clear();
+            for_each_run([this](code_type code, size_t first, size_t count) {
+                run_codes.push_back(code);
+                run_ends.push_back(first + count);
+            });
+            run_codes.shrink_to_fit();
+            run_ends.shrink_to_fit();
+            codes = make_codes({});
+            run_length = true;
+            return;
+        }
+
+        std::vector<code_type> values;
+        values.reserve(row_count);
+        for_each_run([&values](code_type code, size_t, size_t count) { values.insert(values.end(), count, code); });
+        codes = make_codes(values);
+        run_codes.clear();
+        run_ends.clear();
+        run_length = false;
+    }
+
+    void categorical_column::choose_encoding() {
+        size_t runs = 0;
+        for_each_run([&runs](code_type, size_t, size_t) { ++runs; });
+        size_t run_bytes = runs * (sizeof(code_type) + sizeof(size_t));
+        set_run_length_encoding(run_bytes < row_count * code_width());
+    }
+
+    std::vector<size_t> categorical_column::code_counts() const {
+        std::vector<size_t> counts(dictionary.size(), 0);
+        for_each_run([&counts](code_type code, size_t, size_t count) { counts[code] += count; });
+        return counts;
+    }
+
+    void categorical_column::keep_rows(const std::vector<char>& keep) {
+        if (run_length) {
+            std::pmr::vector<code_type> kept_codes(resource);
+            std::pmr::vector<size_t> kept_ends(resource);
+            size_t kept = 0;
+            for_each_run([&](code_type code, size_t first, size_t count) {
+                size_t kept_in_run = static_cast<size_t>(std::count(keep.begin() + static_cast<std::ptrdiff_t>(first),
+                                                                    keep.begin() + static_cast<std::ptrdiff_t>(first + count), true));
+                if (kept_in_run == 0) return;
+                kept += kept_in_run;
+                // runs separated by removed rows merge when they have the same code
+                if (!kept_codes.empty() && kept_codes.back() == code) {
+                    kept_ends.back() = kept;
+                } else {
+                    kept_codes.push_back(code);
+                    kept_ends.push_back(kept);
+                }
+            });
+            run_codes = std::move(kept_codes);
+            run_ends = std::move(kept_ends);
+            row_count = kept;
+            return;
+        }
+
+        std::visit([&keep](auto& values) {
+            size_t kept = 0;
+            for (size_t row = 0; row < values.size(); ++row) {
+                if (keep[row]) values[kept++] = values[row];
+            }
+            values.resize(kept);
+        }, codes);
+        row_count = std::visit([](const auto& values) { return values.size(); }, codes);
+    }
+
+    void categorical_column::assign_rows(const categorical_column& source, const std::vector<size_t>& rows) {
+        if (row_count != 0 || dictionary_size() != 0) {
+            throw std::logic_error("assign_rows needs an empty categorical column");
+        }
+
+        // interned in the same order, every value keeps its code
+        for (size_t code = 1; code < source.dictionary.size(); ++code) intern(source.dictionary[code]);
+        reserve(rows.size());
+        for (size_t row : rows) push_code(row < source.size() ? source.code_at(row) : missing_code);
+    }
+
+    void categorical_column::append(const categorical_column& source) {
+        std::vector<code_type> translated(source.dictionary.size(), missing_code);
+        for (size_t code = 1; code < source.dictionary.size(); ++code) translated[code] = intern(source.dictionary[code]);
+        source.for_each_run([&](code_type code, size_t, size_t count) {
+            for (size_t i = 0; i < count; ++i) push_code(translated[code]);
+        });
+    }
+
+    size_t categorical_column::memory_usage() const {
+        size_t bytes = run_codes.capacity() * sizeof(code_type) + run_ends.capacity() * sizeof(size_t);
+        bytes += std::visit([](const auto& values) {
+            return values.capacity() * sizeof(typename std::decay_t<decltype(values)>::value_type);
+        }, codes);
+
+        // the dictionary, its strings and the nodes and buckets of the lookup table
+        bytes += dictionary.capacity() * sizeof(std::string_view);
+        for (std::string_view value : dictionary) bytes += value.empty() ? 0 : value.size() + 1;
+        bytes += codes_by_value.bucket_count() * sizeof(void*) +
+                 codes_by_value.size() * (sizeof(std::string_view) + sizeof(code_type) + 2 * sizeof(void*));
+        return bytes;
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef CATEGORICAL_COLUMN_HPP
+#define CATEGORICAL_COLUMN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace scitool {
+
+    // Values of a categorical column, stored as integer codes into a dictionary of its distinct strings.
+    // Every distinct string is stored once (interned) and the codes use the narrowest width that fits the
+    // dictionary: one byte up to 255 distinct values, two up to 65535, four beyond. Code 0 is the missing value.
+    //
+    // The codes can also be run-length encoded, as (code, end of run) pairs: a sorted or clustered column
+    // then takes a few bytes per run instead of per row, at the cost of a binary search for random access.
+    class categorical_column {
+    public:
+        using code_type = std::uint32_t;
+        static constexpr code_type missing_code = 0;
+
+        // the codes and runs are allocated from resource, the strings of the dictionary from string_resource
+        categorical_column(std::pmr::memory_resource* resource, std::pmr::memory_resource* string_resource);
+
+        // the code of the value, which is added to the dictionary when it is new
+        code_type intern(std::string_view value);
+        // the code of the value, missing_code when it is not in the dictionary
+        code_type find(std::string_view value) const;
+
+        void push_back(std::string_view value) {
+            push_code(intern(value));
+        }
+
+        void push_code(code_type code);
+        void reserve(size_t rows);
+
+        size_t size() const {
+            return row_count;
+        }
+
+        code_type code_at(size_t row) const;
+
+        // the value of a row, a null view for a missing value
+        std::string_view operator[](size_t row) const {
+            return dictionary[code_at(row)];
+        }
+
+        std::string_view value_of(code_type code) const {
+            return dictionary[code];
+        }
+
+        // number of distinct values, the missing value excluded
+        size_t dictionary_size() const {
+            return dictionary.size() - 1;
+        }
+
+        // bytes per code when the column is not run-length encoded
+        size_t code_width() const;
+
+        bool run_length_encoded() const {
+            return run_length;
+        }
+
+        void set_run_length_encoding(bool enabled);
+        // run-length encodes the column when that takes less memory than the plain codes
+        void choose_encoding();
+
+        // calls func(code, first_row, count) for every run of consecutive rows with the same code
+        template <typename Func>
+        void for_each_run(Func func) const {
+            if (run_length) {
+                size_t first = 0;
+                for (size_t run = 0; run < run_codes.size(); ++run) {
+                    func(run_codes[run], first, run_ends[run] - first);
+                    first = run_ends[run];
+                }
+                return;
+            }
+
+            std::visit([&func](const auto& values) {
+                size_t first = 0;
+                for (size_t row = 1; row <= values.size(); ++row) {
+                    if (row == values.size() || values[row] != values[first]) {
+                        func(static_cast<code_type>(values[first]), first, row - first);
+                        first = row;
+                    }
+                }
+            }, codes);
+        }
+
+        // number of rows of every code, indexed by code (index 0 counts the missing values)
+        std::vector<size_t> code_counts() const;
+
+        // keeps the rows whose flag is set, in order
+        void keep_rows(const std::vector<char>& keep);
+        // fills an empty column with the given rows of source, with the same dictionary and codes. Rows past the
+        // end of source (e.g. the unmatched rows of a left join) are missing values
+        void assign_rows(const categorical_column& source, const std::vector<size_t>& rows);
+        // appends the rows of source, whose values are added to the dictionary in their order in source
+        void append(const categorical_column& source);
+
+        // approximate bytes used by the codes or runs, the dictionary and its strings
+        size_t memory_usage() const;
+
+    private:
+        template <typename Code>
+        using code_vector = std::pmr::vector<Code>;
+        using plain_codes = std::variant<code_vector<std::uint8_t>, code_vector<std::uint16_t>, code_vector<std::uint32_t>>;
+
+        std::pmr::memory_resource* resource;
+        std::pmr::memory_resource* string_resource;
+        // dictionary[code] is the value of the code, dictionary[0] the missing value (a null view)
+        std::vector<std::string_view> dictionary;
+        std::unordered_map<std::string_view, code_type> codes_by_value;
+
+        plain_codes codes;
+        bool run_length = false;
+        std::pmr::vector<code_type> run_codes;
+        // run_ends[i] is the row following the last row of run i
+        std::pmr::vector<size_t> run_ends;
+        size_t row_count = 0;
+
+        // plain codes of the width needed by the dictionary, holding the given codes
+        plain_codes make_codes(const std::vector<code_type>& values) const;
+        void widen_codes();
+    };
+}
+
+#endif
@@ -0,0 +1,732 @@
+#include "csv_reader.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <zlib.h>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef SCITOOL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace scitool {
+
+    // The bytes of the file, decompressed when it is compressed, read in order by the reader thread
+    class byte_source {
+    public:
+        virtual ~byte_source() = default;
+        // fills data with size bytes, fewer only at the end of the text (then none on the later calls)
+        virtual size_t read(char* data, size_t size) = 0;
+        // bytes of the file decoded so far, and bytes of text they gave
+        virtual size_t consumed() const = 0;
+        virtual size_t produced() const = 0;
+        // a lower bound of the size of the whole text written in the file, 0 when it has none
+        virtual size_t known_text() const {
+            return 0;
+        }
+    };
+
+    // The file read by the reader: positional reads, with pread on POSIX systems and ReadFile at an offset on
+    // Windows, so that the header of a compressed file can be peeked at without moving a file position
+    class read_only_file {
+    public:
+        explicit read_only_file(const std::string& path) {
+#ifdef _WIN32
+            handle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (handle == INVALID_HANDLE_VALUE) throw std::invalid_argument("Unable to open file: " + path);
+            LARGE_INTEGER length{};
+            if (::GetFileSizeEx(handle, &length)) size = static_cast<size_t>(length.QuadPart);
+#else
+            descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (descriptor < 0) throw std::invalid_argument("Unable to open file: " + path);
+            struct stat status{};
+            if (::fstat(descriptor, &status) == 0) size = static_cast<size_t>(status.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+            // a larger read-ahead window for the kernel
+            ::posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+        }
+
+        ~read_only_file() {
+#ifdef _WIN32
+            ::CloseHandle(handle);
+#else
+            ::close(descriptor);
+#endif
+        }
+
+        read_only_file(const read_only_file&) = delete;
+        read_only_file& operator=(const read_only_file&) = delete;
+
+        size_t file_size() const {
+            return size;
+        }
+
+        // reads up to count bytes at offset, fewer only at the end of the file
+        size_t read_at(char* data, size_t count, size_t offset) const {
+            size_t done = 0;
+            while (done < count) {
+#ifdef _WIN32
+                // ReadFile takes a 32-bit count, the offset goes in the OVERLAPPED structure
+                DWORD part = static_cast<DWORD>(std::min<size_t>(count - done, size_t(1) << 30));
+                std::uint64_t position = offset + done;
+                OVERLAPPED at{};
+                at.Offset = static_cast<DWORD>(position);
+                at.OffsetHigh = static_cast<DWORD>(position >> 32);
+                DWORD read = 0;
+                if (!::ReadFile(handle, data + done, part, &read, &at)) {
+                    if (::GetLastError() == ERROR_HANDLE_EOF) break;
+                    throw std::runtime_error("Error reading file: error " + std::to_string(::GetLastError()));
+                }
+                if (read == 0) break;
+                done += read;
+#else
+                ssize_t read = ::pread(descriptor, data + done, count - done, static_cast<off_t>(offset + done));
+                if (read < 0 && errno == EINTR) continue;
+                if (read < 0) throw std::runtime_error(std::string("Error reading file: ") + std::strerror(errno));
+                if (read == 0) break;
+                done += static_cast<size_t>(read);
+#endif
+            }
+            return done;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE handle;
+#else
+        int descriptor;
+#endif
+        size_t size = 0;
+    };
+
+    namespace {
+        double seconds_since(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // compressed bytes read at once: a window this large without a whole frame is corrupt
+        constexpr size_t max_window = size_t(256) << 20;
+        // zstd frames holding more text than this are streamed instead of decompressed whole
+        constexpr size_t max_frame_text = size_t(32) << 20;
+
+        class plain_source final : public byte_source {
+        public:
+            explicit plain_source(const read_only_file& file) : file(file) {}
+
+            size_t read(char* data, size_t size) override {
+                size_t count = file.read_at(data, size, offset);
+                offset += count;
+                return count;
+            }
+
+            size_t consumed() const override {
+                return offset;
+            }
+
+            size_t produced() const override {
+                return offset;
+            }
+
+        private:
+            const read_only_file& file;
+            size_t offset = 0;
+        };
+
+        // The compressed bytes read ahead from the file, consumed from the front
+        class compressed_input {
+        public:
+            compressed_input(const read_only_file& file, size_t capacity) : file(file), data(capacity) {}
+
+            const char* bytes() const {
+                return data.data() + begin;
+            }
+
+            size_t available() const {
+                return end - begin;
+            }
+
+            bool end_of_file() const {
+                return at_end;
+            }
+
+            size_t capacity() const {
+                return data.size();
+            }
+
+            // bytes of the file consumed
+            size_t position() const {
+                return offset - available();
+            }
+
+            void consume(size_t count) {
+                begin += count;
+            }
+
+            // doubles the bytes read at once, up to max_window
+            void grow() {
+                if (data.size() < max_window) data.resize(2 * data.size());
+            }
+
+            // moves the bytes not consumed yet to the front and reads as many more as fit, doubling the buffer
+            // when it is full. False when nothing more could be read
+            bool refill() {
+                if (at_end) return false;
+                std::memmove(data.data(), data.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+                if (end == data.size()) data.resize(2 * data.size());
+                size_t count = file.read_at(data.data() + end, data.size() - end, offset);
+                offset += count;
+                end += count;
+                at_end = end < data.size();
+                return count > 0;
+            }
+
+        private:
+            const read_only_file& file;
+            std::vector<char> data;
+            size_t begin = 0;
+            size_t end = 0;
+            size_t offset = 0;
+            bool at_end = false;
+        };
+
+        // zlib stream decoding one gzip member
+        class inflater {
+        public:
+            inflater() {
+                if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) throw std::runtime_error("Unable to initialize zlib");
+            }
+
+            ~inflater() {
+                inflateEnd(&stream);
+            }
+
+            inflater(const inflater&) = delete;
+            inflater& operator=(const inflater&) = delete;
+
+            z_stream stream{};
+        };
+
+        uInt clamp_to_uint(size_t size) {
+            return static_cast<uInt>(std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+        }
+
+        bool gzip_magic(const unsigned char* data, size_t size) {
+            return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+        }
+
+        // the length of a bgzip (BGZF) member, stored in the "BC" field of its header; 0 when there is none or it
+        // is not whole in size bytes
+        size_t bgzf_length(const unsigned char* data, size_t size) {
+            if (size < 12 || !gzip_magic(data, size) || (data[3] & 4) == 0) return 0;
+            size_t extra_end = 12 + (data[10] | (size_t(data[11]) << 8));
+            for (size_t at = 12; at + 4 <= std::min(extra_end, size);) {
+                size_t length = data[at + 2] | (size_t(data[at + 3]) << 8);
+                if (data[at] == 'B' && data[at + 1] == 'C' && length == 2 && at + 6 <= size) {
+                    return (data[at + 4] | (size_t(data[at + 5]) << 8)) + 1;
+                }
+                at += 4 + length;
+            }
+            return 0;
+        }
+
+        // Gzip file decoded as one stream, the members of a concatenation one after the other
+        class gzip_stream_source final : public byte_source {
+        public:
+            explicit gzip_stream_source(const read_only_file& file) : input(file, size_t(1) << 20) {
+                // the text size of the last member (modulo 2^32) ends the file, the whole text of a single member
+                unsigned char trailer[4] = {};
+                size_t file_size = file.file_size();
+                if (file_size >= 18 && file.read_at(reinterpret_cast<char*>(trailer), 4, file_size - 4) == 4) {
+                    last_member = trailer[0] | (size_t(trailer[1]) << 8) | (size_t(trailer[2]) << 16) | (size_t(trailer[3]) << 24);
+                }
+            }
+
+            size_t read(char* data, size_t size) override {
+                auto& stream = decoder.stream;
+                size_t done = 0;
+                while (done < size && !finished) {
+                    if (input.available() == 0) input.refill();
+                    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.bytes()));
+                    stream.avail_in = clamp_to_uint(input.available());
+                    stream.next_out = reinterpret_cast<Bytef*>(data + done);
+                    stream.avail_out = clamp_to_uint(size - done);
+                    uInt in_before = stream.avail_in, out_before = stream.avail_out;
+                    int status = inflate(&stream, Z_NO_FLUSH);
+                    input.consume(in_before - stream.avail_in);
+                    done += out_before - stream.avail_out;
+                    text += out_before - stream.avail_out;
+
+                    if (status == Z_STREAM_END) {
+                        // another member may follow (concatenated files)
+                        if (input.available() < 2) input.refill();
+                        if (input.available() == 0) finished = true;
+                        else if (gzip_magic(reinterpret_cast<const unsigned char*>(input.bytes()), input.available())) inflateReset(&stream);
+                        else throw std::runtime_error("Trailing data after the gzip stream");
+                    } else if (status == Z_BUF_ERROR && input.available() == 0 && input.end_of_file()) {
+                        throw std::runtime_error("Truncated gzip file");
+                    } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                        throw std::runtime_error(std::string("Corrupt gzip data: ") + (stream.msg ? stream.msg : "unknown error"));
+                    }
+                }
+                return done;
+            }
+
+            size_t consumed() const override {
+                return input.position();
+            }
+
+            size_t produced() const override {
+                return text;
+            }
+
+            size_t known_text() const override {
+                return last_member;
+            }
+
+        private:
+            compressed_input input;
+            inflater decoder;
+            size_t last_member = 0;
+            size_t text = 0;
+            bool finished = false;
+        };
+
+        // Compressed file made of independent frames whose length is known before decoding them: a window of whole
+        // frames is read, the frames are decompressed in parallel, then their text is handed out in order
+        class frame_source : public byte_source {
+        public:
+            frame_source(const read_only_file& file, size_t threads) : input(file, size_t(4) << 20), threads(threads) {}
+
+            size_t read(char* data, size_t size) override {
+                size_t done = 0;
+                while (done < size) {
+                    if (current == frames.size() && !decompress_window()) break;
+                    auto& frame = frames[current];
+                    size_t count = std::min(frame.size() - position, size - done);
+                    std::memcpy(data + done, frame.data() + position, count);
+                    position += count;
+                    done += count;
+                    if (position == frame.size()) {
+                        ++current;
+                        position = 0;
+                    }
+                }
+                return done;
+            }
+
+            size_t consumed() const override {
+                return input.position();
+            }
+
+            size_t produced() const override {
+                return text;
+            }
+
+        protected:
+            // length of the frame at the start of data, 0 when it is not whole in size bytes
+            virtual size_t frame_length(const char* data, size_t size) const = 0;
+            virtual void decompress(const char* data, size_t size, std::vector<char>& text) const = 0;
+            virtual std::string format() const = 0;
+
+        private:
+            compressed_input input;
+            size_t threads;
+            std::vector<std::vector<char>> frames;
+            size_t current = 0;
+            size_t position = 0;
+            size_t text = 0;
+
+            bool decompress_window() {
+                frames.clear();
+                current = position = 0;
+                input.refill();
+                std::vector<std::pair<size_t, size_t>> spans;
+                size_t end = 0;
+                while (spans.empty()) {
+                    for (size_t length; (length = frame_length(input.bytes() + end, input.available() - end)) > 0; end += length) {
+                        spans.emplace_back(end, length);
+                    }
+                    if (!spans.empty()) break;
+                    if (input.available() == 0 && input.end_of_file()) return false;
+                    if (input.end_of_file() || input.capacity() >= max_window) {
+                        throw std::runtime_error("Truncated or corrupt " + format() + " file");
+                    }
+                    input.refill();
+                }
+
+                frames.resize(spans.size());
+                parallel_for(spans.size(), [&](size_t i) {
+                    decompress(input.bytes() + spans[i].first, spans[i].second, frames[i]);
+                }, threads);
+                input.consume(end);
+                for (const auto& frame : frames) text += frame.size();
+                // a window of fewer frames than threads leaves threads idle: the next window is larger
+                if (spans.size() < threads) input.grow();
+                return true;
+            }
+        };
+
+        // bgzip output: gzip members of at most 64 KiB, their length in their header
+        class bgzf_source final : public frame_source {
+        public:
+            using frame_source::frame_source;
+
+        protected:
+            size_t frame_length(const char* data, size_t size) const override {
+                auto bytes = reinterpret_cast<const unsigned char*>(data);
+                if (size == 0) return 0;
+                if (!gzip_magic(bytes, size)) {
+                    if (size < 2) return 0;
+                    throw std::runtime_error("Trailing data after the gzip stream");
+                }
+                size_t length = bgzf_length(bytes, size);
+                // a member holds its header and its 8-byte trailer at least
+                if (length > 0 && length < 20) throw std::runtime_error("Corrupt gzip data: invalid member size");
+                if (length > 0) return length <= size ? length : 0;
+
+                // a plain member among bgzip ones: its end is only found by decoding it
+                inflater decoder;
+                auto& stream = decoder.stream;
+                std::vector<Bytef> scratch(size_t(1) << 16);
+                stream.next_in = const_cast<Bytef*>(bytes);
+                stream.avail_in = clamp_to_uint(size);
+                while (true) {
+                    stream.next_out = scratch.data();
+                    stream.avail_out = clamp_to_uint(scratch.size());
+                    int status = inflate(&stream, Z_NO_FLUSH);
+                    if (status == Z_STREAM_END) return size - stream.avail_in;
+                    if (status == Z_BUF_ERROR || (status == Z_OK && stream.avail_in == 0)) return 0;
+                    if (status != Z_OK) {
+                        throw std::runtime_error(std::string("Corrupt gzip data: ") + (stream.msg ? stream.msg : "unknown error"));
+                    }
+                }
+            }
+
+            void decompress(const char* data, size_t size, std::vector<char>& text) const override {
+                // the size of the text modulo 2^32 ends the member
+                auto trailer = reinterpret_cast<const unsigned char*>(data + size - 4);
+                text.resize(std::max<size_t>(1, trailer[0] | (size_t(trailer[1]) << 8) | (size_t(trailer[2]) << 16) | (size_t(trailer[3]) << 24)));
+                inflater decoder;
+                auto& stream = decoder.stream;
+                stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                stream.avail_in = clamp_to_uint(size);
+                size_t done = 0;
+                while (true) {
+                    if (done == text.size()) text.resize(2 * text.size());
+                    stream.next_out = reinterpret_cast<Bytef*>(text.data() + done);
+                    stream.avail_out = clamp_to_uint(text.size() - done);
+                    uInt before = stream.avail_out;
+                    int status = inflate(&stream, Z_FINISH);
+                    done += before - stream.avail_out;
+                    if (status == Z_STREAM_END) break;
+                    if (stream.avail_out > 0) {
+                        throw std::runtime_error(std::string("Corrupt gzip data: ") + (stream.msg ? stream.msg : "truncated member"));
+                    }
+                }
+                text.resize(done);
+            }
+
+            std::string format() const override {
+                return "gzip";
+            }
+        };
+
+#ifdef SCITOOL_HAVE_ZSTD
+        using zstd_context = std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)>;
+
+        zstd_context make_zstd_context() {
+            zstd_context context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+            if (!context) throw std::runtime_error("Unable to initialize zstd");
+            return context;
+        }
+
+        void check_zstd(size_t code) {
+            if (ZSTD_isError(code)) throw std::runtime_error(std::string("Corrupt zstd data: ") + ZSTD_getErrorName(code));
+        }
+
+        // Zstd file decoded as one stream, whatever its frames
+        class zstd_stream_source final : public byte_source {
+        public:
+            zstd_stream_source(const read_only_file& file, size_t first_frame)
+                    : input(file, std::max<size_t>(ZSTD_DStreamInSize(), size_t(1) << 20)), context(make_zstd_context()),
+                      first_frame(first_frame) {}
+
+            size_t read(char* data, size_t size) override {
+                ZSTD_outBuffer out{data, size, 0};
+                while (out.pos < out.size && !finished) {
+                    if (input.available() == 0) input.refill();
+                    ZSTD_inBuffer in{input.bytes(), input.available(), 0};
+                    size_t before = out.pos;
+                    size_t hint = ZSTD_decompressStream(context.get(), &out, &in);
+                    check_zstd(hint);
+                    input.consume(in.pos);
+                    if (in.pos == 0 && out.pos == before) {
+                        // nothing left to decode: the last frame must be complete
+                        if (pending != 0) throw std::runtime_error("Truncated zstd file");
+                        finished = true;
+                    } else {
+                        pending = hint;
+                    }
+                }
+                text += out.pos;
+                return out.pos;
+            }
+
+            size_t consumed() const override {
+                return input.position();
+            }
+
+            size_t produced() const override {
+                return text;
+            }
+
+            size_t known_text() const override {
+                return first_frame;
+            }
+
+        private:
+            compressed_input input;
+            zstd_context context;
+            // text of the first frame, the whole text when the zstd tool wrote the file
+            size_t first_frame;
+            size_t pending = 0;
+            size_t text = 0;
+            bool finished = false;
+        };
+
+        // zstd frames found with ZSTD_findFrameCompressedSize, which only reads the block headers
+        class zstd_frame_source final : public frame_source {
+        public:
+            using frame_source::frame_source;
+
+        protected:
+            size_t frame_length(const char* data, size_t size) const override {
+                if (size == 0) return 0;
+                size_t length = ZSTD_findFrameCompressedSize(data, size);
+                // an error here is a frame not whole yet, a corrupt one is caught once the window cannot grow
+                return ZSTD_isError(length) ? 0 : length;
+            }
+
+            void decompress(const char* data, size_t size, std::vector<char>& text) const override {
+                auto context = make_zstd_context();
+                unsigned long long known = ZSTD_getFrameContentSize(data, size);
+                if (known == ZSTD_CONTENTSIZE_ERROR) throw std::runtime_error("Corrupt zstd data: invalid frame header");
+                if (known != ZSTD_CONTENTSIZE_UNKNOWN) {
+                    text.resize(static_cast<size_t>(known));
+                    size_t count = ZSTD_decompressDCtx(context.get(), text.data(), text.size(), data, size);
+                    check_zstd(count);
+                    text.resize(count);
+                    return;
+                }
+                text.resize(ZSTD_DStreamOutSize());
+                ZSTD_inBuffer in{data, size, 0};
+                size_t done = 0, hint = 1;
+                while (hint != 0) {
+                    if (done == text.size()) text.resize(2 * text.size());
+                    ZSTD_outBuffer out{text.data(), text.size(), done};
+                    hint = ZSTD_decompressStream(context.get(), &out, &in);
+                    check_zstd(hint);
+                    if (out.pos == done && in.pos == size && hint != 0) throw std::runtime_error("Truncated zstd file");
+                    done = out.pos;
+                }
+                text.resize(done);
+            }
+
+            std::string format() const override {
+                return "zstd";
+            }
+        };
+#endif
+
+        bool zstd_magic(const unsigned char* data, size_t size) {
+            if (size < 4) return false;
+            std::uint32_t magic = data[0] | (std::uint32_t(data[1]) << 8) | (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24);
+            // a zstd frame, or a skippable frame (pzstd starts with one)
+            return magic == 0xFD2FB528u || (magic & 0xFFFFFFF0u) == 0x184D2A50u;
+        }
+
+        // chooses the decoder from the first bytes of the file
+        std::unique_ptr<byte_source> open_source(const read_only_file& file, size_t threads, std::string& compression) {
+            unsigned char head[18] = {};
+            size_t count = file.read_at(reinterpret_cast<char*>(head), sizeof head, 0);
+            if (gzip_magic(head, count)) {
+                compression = "gzip";
+                if (bgzf_length(head, count) > 0) return std::make_unique<bgzf_source>(file, threads);
+                return std::make_unique<gzip_stream_source>(file);
+            }
+            if (zstd_magic(head, count)) {
+                compression = "zstd";
+#ifdef SCITOOL_HAVE_ZSTD
+                // frames small enough are decompressed whole, in parallel; a large one (the zstd tool writes the
+                // whole file as one frame) is streamed
+                unsigned long long text = ZSTD_getFrameContentSize(head, count);
+                if (text != ZSTD_CONTENTSIZE_UNKNOWN && text != ZSTD_CONTENTSIZE_ERROR && text <= max_frame_text) {
+                    return std::make_unique<zstd_frame_source>(file, threads);
+                }
+                bool known = text != ZSTD_CONTENTSIZE_UNKNOWN && text != ZSTD_CONTENTSIZE_ERROR;
+                return std::make_unique<zstd_stream_source>(file, known ? static_cast<size_t>(text) : 0);
+#else
+                throw std::invalid_argument("Unable to read a zstd-compressed file: built without zstd support");
+#endif
+            }
+            compression = "none";
+            return std::make_unique<plain_source>(file);
+        }
+    }
+
+    std::string csv_read_stats::bound() const {
+        return parse_wait_seconds / static_cast<double>(std::max<size_t>(1, parse_threads)) > read_wait_seconds ? "io" : "cpu";
+    }
+
+    line_block_reader::line_block_reader(const std::string& path, size_t block_size, size_t buffer_count, size_t threads)
+            : block_size(std::max<size_t>(1, block_size)), buffers(std::max<size_t>(1, buffer_count)) {
+        file = std::make_unique<read_only_file>(path);
+        size = file->file_size();
+        source = open_source(*file, std::max<size_t>(1, threads), compression_name);
+        // the header is read apart, the reader thread starts after its line break
+        std::vector<char> chunk(size_t(1) << 16);
+        while (true) {
+            size_t count = source->read(chunk.data(), chunk.size());
+            auto end = std::find(chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(count), '\n');
+            header_line.append(chunk.begin(), end);
+            if (end != chunk.begin() + static_cast<std::ptrdiff_t>(count)) {
+                carry.assign(end + 1, chunk.begin() + static_cast<std::ptrdiff_t>(count));
+                break;
+            }
+            if (count < chunk.size()) break;
+        }
+        consumed = source->consumed();
+        produced = source->produced();
+        known_text = source->known_text();
+
+        for (size_t buffer = 0; buffer < buffers.size(); ++buffer) free_buffers.push_back(buffer);
+        reader = std::thread([this]() { read_blocks(); });
+    }
+
+    line_block_reader::~line_block_reader() {
+        cancel();
+        reader.join();
+    }
+
+    void line_block_reader::read_blocks() {
+        try {
+            size_t index = 0;
+            bool end_of_file = false;
+            while (!end_of_file) {
+                auto wait_start = std::chrono::steady_clock::now();
+                size_t buffer;
+                {
+                    std::unique_lock lock(mutex);
+                    changed.wait(lock, [this]() { return stopping || !free_buffers.empty(); });
+                    waiting += seconds_since(wait_start);
+                    if (stopping) return;
+                    buffer = free_buffers.front();
+                    free_buffers.pop_front();
+                }
+
+                // the partial line of the previous block first, then as much of the file as fits
+                auto& data = buffers[buffer];
+                if (data.size() < std::max(block_size, 2 * carry.size())) data.resize(std::max(block_size, 2 * carry.size()));
+                std::copy(carry.begin(), carry.end(), data.begin());
+                size_t filled = carry.size(), length = 0;
+                double read_time = 0.0;
+                while (true) {
+                    auto read_start = std::chrono::steady_clock::now();
+                    size_t count = source->read(data.data() + filled, data.size() - filled);
+                    read_time += seconds_since(read_start);
+                    filled += count;
+                    end_of_file = filled < data.size();
+
+                    auto last_line = std::find(std::make_reverse_iterator(data.begin() + static_cast<std::ptrdiff_t>(filled)), data.rend(), '\n');
+                    length = end_of_file ? filled : static_cast<size_t>(data.rend() - last_line);
+                    if (length > 0 || end_of_file) break;
+                    // a line longer than the buffer
+                    data.resize(2 * data.size());
+                }
+                carry.assign(data.begin() + static_cast<std::ptrdiff_t>(length), data.begin() + static_cast<std::ptrdiff_t>(filled));
+
+                std::lock_guard lock(mutex);
+                reading += read_time;
+                consumed = source->consumed();
+                produced = source->produced();
+                if (length > 0) full_blocks.push_back({index++, buffer, std::string_view(data.data(), length)});
+                else free_buffers.push_back(buffer);
+                changed.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            error = std::current_exception();
+        }
+
+        std::lock_guard lock(mutex);
+        finished = true;
+        changed.notify_all();
+    }
+
+    bool line_block_reader::next(block& out) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this]() { return finished || stopping || !full_blocks.empty(); });
+        if (!full_blocks.empty()) {
+            out = full_blocks.front();
+            full_blocks.pop_front();
+            return true;
+        }
+        if (error) std::rethrow_exception(error);
+        return false;
+    }
+
+    void line_block_reader::release(const block& done) {
+        std::lock_guard lock(mutex);
+        free_buffers.push_back(done.buffer);
+        changed.notify_all();
+    }
+
+    void line_block_reader::cancel() {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        full_blocks.clear();
+        changed.notify_all();
+    }
+
+    size_t line_block_reader::expected_size() const {
+        std::lock_guard lock(mutex);
+        if (compression_name == "none") return size;
+        if (consumed == 0) return std::max(size, known_text);
+        auto extrapolated = static_cast<size_t>(static_cast<double>(size) * static_cast<double>(produced) / static_cast<double>(consumed));
+        return std::max(extrapolated, known_text);
+    }
+
+    size_t line_block_reader::text_bytes() const {
+        std::lock_guard lock(mutex);
+        return produced;
+    }
+
+    double line_block_reader::read_seconds() const {
+        std::lock_guard lock(mutex);
+        return reading;
+    }
+
+    double line_block_reader::wait_seconds() const {
+        std::lock_guard lock(mutex);
+        return waiting;
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef CSV_READER_HPP
+#define CSV_READER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace scitool {
+
+    struct csv_read_options {
+        // bytes read at once, a block always ends at the end of a line (it grows to hold a longer line)
+        size_t block_size = size_t(4) << 20;
+        // blocks read, being parsed or waiting to be appended at once, which bounds the memory of the pipeline;
+        // 0 for two more than the parsing threads
+        size_t blocks_in_flight = 0;
+        // threads parsing blocks, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    // Time spent by every stage of dataset::from_csv. The reader waiting for a free block means the parsers
+    // cannot keep up (CPU-bound), the parsers waiting for a block means the disk cannot (I/O-bound)
+    struct csv_read_stats {
+        // bytes of the file, and of its text once decompressed
+        size_t bytes = 0;
+        size_t text_bytes = 0;
+        // "none", "gzip" or "zstd"
+        std::string compression;
+        size_t blocks = 0;
+        size_t rows = 0;
+        size_t parse_threads = 0;
+        double wall_seconds = 0.0;
+        // reading and decompressing
+        double read_seconds = 0.0;
+        double read_wait_seconds = 0.0;
+        // summed over the parsing threads
+        double parse_seconds = 0.0;
+        double parse_wait_seconds = 0.0;
+        double append_seconds = 0.0;
+        double append_wait_seconds = 0.0;
+
+        // "io" when the parsers waited for the reader longer than the reader waited for them, "cpu" otherwise
+        std::string bound() const;
+    };
+
+    // First stage of the CSV pipeline: a reader thread reads the file with large positional reads into a ring of
+    // reusable buffers, while the blocks already read are handed out to the parsers. Every block holds whole
+    // lines, the partial line at the end of a read is carried over to the next block. A buffer is only reused
+    // once its block is released, so at most `buffers` blocks are in memory and the reader waits for the
+    // slowest stage (back-pressure). The header line is read apart, when the reader is created.
+    // Files compressed with gzip or zstd (with SCITOOL_HAVE_ZSTD) are recognized by their first bytes and
+    // decompressed on the fly by the reader thread, so the blocks always hold text. Files made of independent
+    // frames whose length is in their header (bgzip members, zstd frames of pzstd or of the seekable format) are
+    // decompressed a window of frames at a time, the frames in parallel on `threads` threads
+    class byte_source;
+    class read_only_file;
+
+    class line_block_reader {
+    public:
+        struct block {
+            size_t index;
+            size_t buffer;
+            std::string_view text;
+        };
+
+        line_block_reader(const std::string& path, size_t block_size, size_t buffers, size_t threads = 1);
+        ~line_block_reader();
+
+        line_block_reader(const line_block_reader&) = delete;
+        line_block_reader& operator=(const line_block_reader&) = delete;
+
+        // the first line of the file, without its line break
+        const std::string& header() const {
+            return header_line;
+        }
+
+        size_t file_size() const {
+            return size;
+        }
+
+        // "none", "gzip" or "zstd"
+        const std::string& compression() const {
+            return compression_name;
+        }
+
+        // size of the text of the file: the file size, or when the file is compressed the compression ratio so far
+        // extrapolated (at least the text size stored in the file, when there is one)
+        size_t expected_size() const;
+        // bytes of text read so far, the header included
+        size_t text_bytes() const;
+
+        // waits for the next block, false once every block was handed out. Safe to call from several threads,
+        // rethrows the error of the reader thread
+        bool next(block& out);
+        // gives the buffer of a block back to the reader
+        void release(const block& done);
+        // stops reading: the blocks not handed out yet are dropped and next returns false
+        void cancel();
+
+        // seconds the reader spent reading (and decompressing), and waiting for a free buffer
+        double read_seconds() const;
+        double wait_seconds() const;
+
+    private:
+        // declared before the source reading it, so that it is closed after
+        std::unique_ptr<read_only_file> file;
+        size_t size = 0;
+        size_t block_size;
+        std::string header_line;
+        std::string compression_name;
+        std::unique_ptr<byte_source> source;
+        // the text read along with the header, after its line break
+        std::vector<char> carry;
+
+        std::vector<std::vector<char>> buffers;
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<size_t> free_buffers;
+        std::deque<block> full_blocks;
+        bool finished = false;
+        bool stopping = false;
+        std::exception_ptr error;
+        double reading = 0.0;
+        double waiting = 0.0;
+        size_t consumed = 0;
+        size_t produced = 0;
+        size_t known_text = 0;
+        std::thread reader;
+
+        void read_blocks();
+    };
+}
+
+#endif
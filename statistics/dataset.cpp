@@ -4,65 +4,418 @@
 
 #include "stat_utils.cpp"
 #include "dataset.hpp"
-#include <fstream>
-#include <iomanip>
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include "report.hpp"
+#include "sorting.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <thread>
 
 namespace scitool {
 
-    std::unique_ptr<dataset> dataset::from_csv(const std::string& input_file) {
-        std::ifstream file(input_file);
-        if (!file.is_open()) {
-            throw std::invalid_argument("Unable to open file: " + input_file);
+    namespace {
+        // splits off the text up to the next delimiter, like std::getline: a delimiter at the very
+        // end of the text does not start a new (empty) field
+        bool next_field(std::string_view& text, std::string_view& field, char delimiter) {
+            if (text.empty()) return false;
+            size_t end = text.find(delimiter);
+            field = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+            return true;
         }
 
+        enum class cell_kind { missing, integer, number, text };
+
+        cell_kind parse_cell(std::string_view cell, double& value) {
+            if (cell.empty()) return cell_kind::missing;
+
+            const char* first = cell.data();
+            const char* last = cell.data() + cell.size();
+            int integer;
+            auto [int_end, int_error] = std::from_chars(first, last, integer);
+            if (int_error == std::errc() && int_end == last) {
+                value = integer;
+                return cell_kind::integer;
+            }
+
+            auto [double_end, double_error] = std::from_chars(first, last, value);
+            if (double_error == std::errc() && double_end == last) return cell_kind::number;
+
+            return cell_kind::text;
+        }
+    }
+
+    dataset::dataset(std::vector<std::string> cols, std::set<int> num_cols, std::set<int> cat_cols)
+            : columns(std::move(cols)), numerical_columns(std::move(num_cols)), categorical_columns(std::move(cat_cols)) {
+        init_columns();
+    }
+
+    dataset::dataset(std::vector<std::string> cols, const matrix& matrix, std::set<int> num_cols, std::set<int> cat_cols)
+            : dataset(std::move(cols), std::move(num_cols), std::move(cat_cols)) {
+        row_count = matrix.size();
+        for (size_t col = 0; col < columns.size(); ++col) {
+            auto& column = column_values[col];
+            if (column.categorical) {
+                column.categories.reserve(row_count);
+            } else {
+                column.numbers.reserve(row_count);
+                column.integral = true;
+            }
+
+            for (const auto& row : matrix) {
+                const std::optional<data_variant>* cell = col < row.size() ? &row[col] : nullptr;
+                if (column.categorical) {
+                    const auto* text = cell && *cell ? std::get_if<std::string>(&**cell) : nullptr;
+                    if (text) column.categories.push_back(*text);
+                    else column.categories.push_code(categorical_column::missing_code);
+                } else if (cell && *cell && std::holds_alternative<int>(**cell)) {
+                    column.numbers.push_back(std::get<int>(**cell));
+                } else if (cell && *cell && std::holds_alternative<double>(**cell)) {
+                    column.numbers.push_back(std::get<double>(**cell));
+                    column.integral = false;
+                } else {
+                    column.numbers.push_back(std::numeric_limits<double>::quiet_NaN());
+                }
+            }
+            if (column.categorical) column.categories.choose_encoding();
+        }
+    }
+
+    void dataset::init_columns() {
+        for (size_t col_idx = 0; col_idx < columns.size(); ++col_idx) {
+            column_statistics[columns[col_idx]] = column_stat{};
+            column_statistics[columns[col_idx]].col_index = static_cast<int>(col_idx);
+        }
+
+        arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+        string_arena = std::make_unique<std::pmr::monotonic_buffer_resource>();
+        column_values.clear();
+        column_values.reserve(columns.size());
+        for (size_t col_idx = 0; col_idx < columns.size(); ++col_idx) {
+            column_values.emplace_back(arena.get(), string_arena.get());
+            column_values.back().categorical = categorical_columns.count(static_cast<int>(col_idx)) > 0;
+        }
+    }
+
+    std::unique_ptr<dataset> dataset::from_csv(const std::string& input_file, const csv_read_options& options, csv_read_stats* stats) {
+        SCITOOL_PROFILE_SCOPE("dataset.from_csv");
+        auto start = std::chrono::steady_clock::now();
+        auto seconds_since = [](std::chrono::steady_clock::time_point since) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+        };
+        size_t threads = options.threads == 0 ? default_thread_count() : options.threads;
+        line_block_reader reader(input_file, options.block_size, options.blocks_in_flight == 0 ? threads + 2 : options.blocks_in_flight, threads);
+        std::vector<std::string> names = split_header(reader.header());
+
+        // The parsers take the blocks in order and leave them parsed, with their own dictionaries and arenas. This
+        // thread appends them in order, then gives their buffer back to the reader
+        struct parsed_block {
+            line_block_reader::block source;
+            std::unique_ptr<dataset> rows;
+            std::vector<column_kind> kinds;
+        };
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::map<size_t, parsed_block> parsed;
+        std::exception_ptr error;
+        size_t stopped_parsers = 0;
+        double parse_seconds = 0.0, parse_wait_seconds = 0.0;
+
+        auto parse_blocks = [&]() {
+            double busy = 0.0, idle = 0.0;
+            try {
+                while (true) {
+                    auto wait_start = std::chrono::steady_clock::now();
+                    parsed_block block;
+                    bool more = reader.next(block.source);
+                    idle += seconds_since(wait_start);
+                    if (!more) break;
+
+                    auto parse_start = std::chrono::steady_clock::now();
+                    block.rows = parse_csv(names, block.source.text, &block.kinds);
+                    busy += seconds_since(parse_start);
+                    std::lock_guard lock(mutex);
+                    parsed.emplace(block.source.index, std::move(block));
+                    ready.notify_all();
+                }
+            } catch (...) {
+                reader.cancel();
+                std::lock_guard lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+            std::lock_guard lock(mutex);
+            parse_seconds += busy;
+            parse_wait_seconds += idle;
+            ++stopped_parsers;
+            ready.notify_all();
+        };
+
+        std::unique_ptr<dataset> ds(new dataset(names, {}, {}));
+        for (auto& column : ds->column_values) column.integral = true;
+        std::vector<column_kind> kinds(names.size(), column_kind::unknown);
+        double append_seconds = 0.0, append_wait_seconds = 0.0;
+        size_t blocks = 0;
+
+        std::vector<std::thread> parsers;
+        auto stop_parsers = [&]() {
+            reader.cancel();
+            for (auto& parser : parsers) parser.join();
+        };
+        try {
+            for (size_t t = 0; t < threads; ++t) parsers.emplace_back(parse_blocks);
+            while (true) {
+                auto wait_start = std::chrono::steady_clock::now();
+                parsed_block block;
+                {
+                    std::unique_lock lock(mutex);
+                    ready.wait(lock, [&]() { return error || parsed.count(blocks) > 0 || stopped_parsers == threads; });
+                    append_wait_seconds += seconds_since(wait_start);
+                    if (error || parsed.count(blocks) == 0) break;
+                    block = std::move(parsed.at(blocks));
+                    parsed.erase(blocks);
+                }
+
+                auto append_start = std::chrono::steady_clock::now();
+                size_t text_size = blocks == 0 ? reader.expected_size() : 0;
+                if (text_size > 2 * block.source.text.size()) {
+                    // the columns are reserved once, for the number of rows the first block suggests
+                    double lines_per_byte = static_cast<double>(block.rows->row_count) / static_cast<double>(block.source.text.size());
+                    auto expected = static_cast<size_t>(1.05 * lines_per_byte * static_cast<double>(text_size));
+                    for (size_t col = 0; col < names.size(); ++col) {
+                        if (block.kinds[col] == column_kind::categorical) ds->column_values[col].categories.reserve(expected);
+                        else ds->column_values[col].numbers.reserve(expected);
+                    }
+                }
+                ds->append_block(*block.rows, block.kinds, kinds, block.source.text);
+                reader.release(block.source);
+                append_seconds += seconds_since(append_start);
+                ++blocks;
+            }
+        } catch (...) {
+            stop_parsers();
+            throw;
+        }
+        stop_parsers();
+        if (error) std::rethrow_exception(error);
+
+        // columns without any value are numerical columns of missing values
+        for (size_t col = 0; col < names.size(); ++col) {
+            if (kinds[col] == column_kind::categorical) {
+                ds->categorical_columns.insert(static_cast<int>(col));
+                ds->column_values[col].categories.choose_encoding();
+            } else {
+                ds->numerical_columns.insert(static_cast<int>(col));
+            }
+        }
+        ds->file_name = extract_file_name(input_file);
+
+        if (stats) {
+            stats->bytes = reader.file_size();
+            stats->text_bytes = reader.text_bytes();
+            stats->compression = reader.compression();
+            stats->blocks = blocks;
+            stats->rows = ds->row_count;
+            stats->parse_threads = threads;
+            stats->read_seconds = reader.read_seconds();
+            stats->read_wait_seconds = reader.wait_seconds();
+            stats->parse_seconds = parse_seconds;
+            stats->parse_wait_seconds = parse_wait_seconds;
+            stats->append_seconds = append_seconds;
+            stats->append_wait_seconds = append_wait_seconds;
+            stats->wall_seconds = seconds_since(start);
+        }
+        return ds;
+    }
+
+    void dataset::append_block(dataset& block, std::vector<column_kind>& block_kinds, std::vector<column_kind>& kinds, std::string_view text) {
+        // a column whose type an earlier block decided otherwise is parsed again with that type, as from_csv keeps
+        // the type of the first value of a column
+        for (size_t col = 0; col < kinds.size(); ++col) {
+            if (kinds[col] != column_kind::unknown && block_kinds[col] != column_kind::unknown && kinds[col] != block_kinds[col]) {
+                block_kinds = kinds;
+                auto reparsed = parse_csv(columns, text, &block_kinds);
+                return append_block(*reparsed, block_kinds, kinds, text);
+            }
+        }
+
+        size_t rows = block.row_count;
+        for (size_t col = 0; col < kinds.size(); ++col) {
+            auto& target = column_values[col];
+            auto& source = block.column_values[col];
+            if (kinds[col] == column_kind::unknown && block_kinds[col] == column_kind::categorical) {
+                // the rows so far were all missing
+                target.categorical = true;
+                target.categories.reserve(target.numbers.capacity());
+                for (size_t row = 0; row < row_count; ++row) target.categories.push_code(categorical_column::missing_code);
+                target.numbers = std::pmr::vector<double>(target.numbers.get_allocator());
+            }
+            if (kinds[col] == column_kind::unknown) kinds[col] = block_kinds[col];
+
+            if (kinds[col] == column_kind::categorical) {
+                if (source.categorical) target.categories.append(source.categories);
+                else for (size_t row = 0; row < rows; ++row) target.categories.push_code(categorical_column::missing_code);
+            } else {
+                target.numbers.insert(target.numbers.end(), source.numbers.begin(), source.numbers.end());
+                target.integral = target.integral && source.integral;
+            }
+        }
+        row_count += rows;
+    }
+
+    void dataset::read_csv_chunks(const std::string& input_file, size_t chunk_rows, const std::function<void(dataset&)>& func) {
+        SCITOOL_PROFILE_SCOPE("dataset.read_csv_chunks");
+        if (chunk_rows == 0) {
+            throw std::invalid_argument("The chunk size must be positive");
+        }
+        // one block read ahead while the chunk is parsed, decompressed when the file is compressed
+        line_block_reader reader(input_file, size_t(1) << 20, 2);
         std::vector<std::string> columns_;
-        dataset::matrix data_matrix_;
-        std::set<int> numerical_columns_;
-        std::set<int> categorical_columns_;
+        if (reader.text_bytes() > 0) columns_ = split_header(reader.header());
 
-        // Read header
-        std::string line;
-        if (std::getline(file, line)) {
-            std::istringstream header_stream(line);
-            std::string column;
-            while (std::getline(header_stream, column, ',')) {
-                columns_.push_back(column);
+        // the lines of a chunk are gathered in one buffer and parsed as from_csv parses a whole file
+        std::string text;
+        size_t rows = 0;
+        auto flush = [&]() {
+            auto chunk = parse_csv(columns_, text);
+            chunk->file_name = extract_file_name(input_file);
+            func(*chunk);
+            text.clear();
+            rows = 0;
+        };
+        line_block_reader::block block;
+        while (reader.next(block)) {
+            std::string_view lines = block.text;
+            while (!lines.empty()) {
+                size_t end = lines.find('\n');
+                size_t length = end == std::string_view::npos ? lines.size() : end + 1;
+                text.append(lines.substr(0, length));
+                if (end == std::string_view::npos) text += '\n';
+                lines.remove_prefix(length);
+                if (++rows == chunk_rows) flush();
             }
+            reader.release(block);
         }
+        if (rows > 0) flush();
+    }
 
-        while (std::getline(file, line)) {
-            std::istringstream line_stream(line);
-            std::string cell;
-            dataset::data_row data_row;
-            int column_index = 0;
+    std::vector<std::string> dataset::split_header(std::string_view line) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        std::vector<std::string> names;
+        std::string_view cell;
+        while (next_field(line, cell, ',')) {
+            names.emplace_back(cell);
+        }
+        return names;
+    }
 
-            while (std::getline(line_stream, cell, ',')) {
-                // Convert string to data_variant
-                auto data_variant = dataset::convert(cell);
-                data_row.push_back(data_variant);
-                if (!data_variant.has_value()) continue;
+    std::unique_ptr<dataset> dataset::parse_csv(std::vector<std::string> column_names, std::string_view text,
+                                                std::vector<column_kind>* column_kinds) {
+        size_t max_rows = static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1;
+        auto strip = [](std::string_view line) {
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            return line;
+        };
+        std::string_view line, cell;
 
-                // On first row, determine if the column is numerical
-                if (numerical_columns_.size() + categorical_columns_.size() < columns_.size()) {
+        std::unique_ptr<dataset> ds(new dataset(std::move(column_names), {}, {}));
+        size_t num_columns = ds->columns.size();
+        for (auto& column : ds->column_values) {
+            column.integral = true;
+        }
+
+        // The type of a column is the one of its first value, cells read before it were missing
+        std::vector<column_kind> local_kinds;
+        std::vector<column_kind>& kinds = column_kinds ? *column_kinds : local_kinds;
+        kinds.resize(num_columns, column_kind::unknown);
+        const double missing = std::numeric_limits<double>::quiet_NaN();
+        for (size_t col = 0; col < num_columns; ++col) {
+            auto& column = ds->column_values[col];
+            if (kinds[col] == column_kind::categorical) {
+                column.categorical = true;
+                column.categories.reserve(max_rows);
+            } else if (kinds[col] == column_kind::numerical) {
+                column.numbers.reserve(max_rows);
+            }
+        }
+
+        size_t rows = 0;
+        while (next_field(text, line, '\n')) {
+            SCITOOL_PROFILE_COUNT("dataset.rows_read", 1);
+            SCITOOL_PROFILE_COUNT("dataset.bytes_read", line.size() + 1);
+            line = strip(line);
 
-                    if (std::holds_alternative<int>(data_variant.value()) ||
-                        std::holds_alternative<double>(data_variant.value())) {
-                        numerical_columns_.insert(column_index);
+            for (size_t col = 0; col < num_columns; ++col) {
+                if (!next_field(line, cell, ',')) cell = {};
+                auto& column = ds->column_values[col];
+
+                double value = 0.0;
+                cell_kind kind = parse_cell(cell, value);
+                if (kinds[col] == column_kind::unknown) {
+                    if (kind == cell_kind::missing) continue;
+                    if (kind == cell_kind::text) {
+                        kinds[col] = column_kind::categorical;
+                        column.categorical = true;
+                        column.categories.reserve(max_rows);
+                        for (size_t row = 0; row < rows; ++row) column.categories.push_code(categorical_column::missing_code);
                     } else {
-                        categorical_columns_.insert(column_index);
+                        kinds[col] = column_kind::numerical;
+                        column.numbers.reserve(max_rows);
+                        column.numbers.resize(rows, missing);
                     }
                 }
 
-                column_index++;
+                if (kinds[col] == column_kind::categorical) {
+                    // numbers in a categorical column are not categories, they are stored as missing
+                    if (kind == cell_kind::text) column.categories.push_back(cell);
+                    else column.categories.push_code(categorical_column::missing_code);
+                } else {
+                    if (kind == cell_kind::number) column.integral = false;
+                    column.numbers.push_back(kind == cell_kind::integer || kind == cell_kind::number ? value : missing);
+                }
+            }
+            ++rows;
+        }
+
+        // columns without any value are numerical columns of missing values
+        for (size_t col = 0; col < num_columns; ++col) {
+            if (kinds[col] == column_kind::categorical) {
+                ds->categorical_columns.insert(static_cast<int>(col));
+                ds->column_values[col].categories.choose_encoding();
+            } else {
+                ds->numerical_columns.insert(static_cast<int>(col));
+                if (kinds[col] == column_kind::unknown) ds->column_values[col].numbers.assign(rows, missing);
             }
-            data_matrix_.push_back(std::move(data_row));
         }
+        ds->row_count = rows;
+        return ds;
+    }
 
-        std::string file_name = extract_file_name(input_file);
+    std::unique_ptr<dataset> dataset::from_numerical_data(std::vector<std::string> column_names, const double* values, size_t rows) {
+        size_t num_columns = column_names.size();
+        if (num_columns == 0) {
+            throw std::invalid_argument("At least one column is needed to build a dataset");
+        }
 
-        auto ds = std::make_unique<dataset>(std::move(columns_), std::move(data_matrix_),
-                                            std::move(numerical_columns_), std::move(categorical_columns_));
-        ds->file_name = std::move(file_name);
+        std::set<int> numerical_columns_;
+        for (size_t col = 0; col < num_columns; ++col) numerical_columns_.insert(static_cast<int>(col));
+
+        std::unique_ptr<dataset> ds(new dataset(std::move(column_names), std::move(numerical_columns_), {}));
+        for (size_t col = 0; col < num_columns; ++col) {
+            auto& numbers = ds->column_values[col].numbers;
+            numbers.resize(rows);
+            for (size_t row = 0; row < rows; ++row) {
+                numbers[row] = values[row * num_columns + col];
+            }
+        }
+        ds->row_count = rows;
         return ds;
     }
 
@@ -82,268 +435,559 @@ namespace scitool {
         return path.substr(last_slash, last_dot - last_slash);
     }
 
-    void dataset::calculate_statistics() {
-        // Calculate statistics for numerical columns
-        for (auto colIndex : numerical_columns) {
-            const auto& columnName = columns[colIndex];
-            column_statistics[columnName].mean = get_mean(columnName);
-            column_statistics[columnName].std_dev = get_std_dev(columnName);
-            column_statistics[columnName].variance = get_variance(columnName);
-            column_statistics[columnName].median = get_median(columnName);
+    void dataset::output_statistics(const std::string& output_file) {
+        SCITOOL_PROFILE_SCOPE("dataset.output_statistics");
+        write_report(*this, output_file);
+    }
+
+    // The statistics read the contiguous values of the column, the median works on a copy in a
+    // per-thread buffer that is reused by the next calls (see stat_utils.hpp)
+    const double* dataset::numerical_values(int col_index) const {
+        SCITOOL_PROFILE_COUNT("dataset.rows_scanned", row_count);
+        SCITOOL_PROFILE_COUNT("dataset.bytes_scanned", row_count * sizeof(double));
+        return column_values[col_index].numbers.data();
+    }
+
+    double dataset::calculate_mean(int col_index) const {
+        SCITOOL_PROFILE_SCOPE("dataset.mean");
+        return scitool::mean(numerical_values(col_index), row_count);
+    }
+
+    double dataset::calculate_std_dev(int col_index) const {
+        SCITOOL_PROFILE_SCOPE("dataset.std_dev");
+        return scitool::std_dev(numerical_values(col_index), row_count);
+    }
+
+    double dataset::calculate_median(int col_index) const {
+        SCITOOL_PROFILE_SCOPE("dataset.median");
+        return scitool::median(numerical_values(col_index), row_count);
+    }
+
+    double dataset::calculate_variance(int col_index) const {
+        SCITOOL_PROFILE_SCOPE("dataset.variance");
+        return scitool::variance(numerical_values(col_index), row_count);
+    }
+
+    // Helper function to extract numerical data from a column
+    std::vector<std::optional<double>> dataset::extract_numerical_column_data(int col_index) const {
+        std::vector<std::optional<double>> column_data;
+        column_data.reserve(row_count); // Reserve space to avoid repeated reallocations
+
+        const double* values = numerical_values(col_index);
+        for (size_t row = 0; row < row_count; ++row) {
+            if (std::isnan(values[row])) column_data.emplace_back(std::nullopt);
+            else column_data.emplace_back(values[row]);
         }
 
-        // Calculate the correlation matrix for numerical columns
-        correlation_matrix = get_correlation_matrix();
+        return column_data;
+    }
+
+    // Helper function to extract categorical data from a column
+    std::map<std::string, int> dataset::extract_categorical_column_data(int colIndex) const {
+        SCITOOL_PROFILE_SCOPE("dataset.frequency_count");
+        SCITOOL_PROFILE_COUNT("dataset.rows_scanned", row_count);
 
-        // Calculate frequency counts for categorical columns
-        for (auto colIndex : categorical_columns) {
-            const auto& columnName = columns[colIndex];
-            column_statistics[columnName].frequency_count = get_frequency_count(columnName);
+        // the rows are counted per dictionary code, a string is built once per distinct value
+        const auto& categories = column_values[colIndex].categories;
+        std::vector<size_t> counts = categories.code_counts();
+        std::map<std::string, int> frequency_map;
+        for (size_t code = 1; code < counts.size(); ++code) {
+            if (counts[code] > 0) {
+                frequency_map.emplace(categories.value_of(static_cast<categorical_column::code_type>(code)), static_cast<int>(counts[code]));
+            }
         }
+        return frequency_map;
     }
 
-    void dataset::output_statistics(const std::string& output_file) {
-        std::ofstream out_file(output_file);
-        if (!out_file.is_open()) {
-            throw std::runtime_error("Unable to open file: " + output_file);
+    int dataset::column_index(const std::string& column_name) const {
+        auto col_it = column_statistics.find(column_name);
+        if (col_it == column_statistics.end()) {
+            throw std::invalid_argument("Column '" + column_name + "' does not exist");
         }
+        return col_it->second.col_index;
+    }
 
-        calculate_statistics();
+    template <typename Calculate>
+    double dataset::cached_statistic(const std::string& column_name, std::optional<double> column_stat::* statistic, Calculate calculate) {
+        int col_index = column_index(column_name);
+        {
+            std::shared_lock lock(cache_mutex);
+            const auto& cached = column_statistics.at(column_name).*statistic;
+            if (cached) {
+                SCITOOL_PROFILE_COUNT("dataset.stat_cache.hits", 1);
+                return *cached;
+            }
+        }
+        SCITOOL_PROFILE_COUNT("dataset.stat_cache.misses", 1);
 
-        // Output for Numerical Data
-        out_file << "Numerical Data Statistics:\n";
-        for (int col_index : numerical_columns) {
-            auto& col_name = columns[col_index];
-            out_file << col_name << ":\n";
-            out_file << "  Mean: " << column_statistics[col_name].mean.value() << "\n";
-            out_file << "  Median: " << column_statistics[col_name].median.value() << "\n";
-            out_file << "  Standard Deviation: " << column_statistics[col_name].std_dev.value() << "\n";
-            out_file << "  Variance: " << column_statistics[col_name].variance.value() << "\n";
+        // concurrent callers may both compute the value, but only the first one stores it
+        double value = calculate(col_index);
+        std::unique_lock lock(cache_mutex);
+        auto& cached = column_statistics.at(column_name).*statistic;
+        if (!cached) cached = value;
+        return *cached;
+    }
+
+    double dataset::get_mean(const std::string& column_name) {
+        return cached_statistic(column_name, &column_stat::mean, [this](int col_index) { return calculate_mean(col_index); });
+    }
+
+    double dataset::get_variance(const std::string& column_name) {
+        return cached_statistic(column_name, &column_stat::variance, [this](int col_index) { return calculate_variance(col_index); });
+    }
+
+    double dataset::get_std_dev(const std::string& column_name) {
+        return cached_statistic(column_name, &column_stat::std_dev, [this](int col_index) { return calculate_std_dev(col_index); });
+    }
+
+    double dataset::get_median(const std::string& column_name) {
+        return cached_statistic(column_name, &column_stat::median, [this, &column_name](int col_index) {
+            // the sorted order of the column is used when a sort or a quantile query already computed it,
+            // otherwise a selection is cheaper than sorting
+            std::shared_ptr<const std::vector<size_t>> order;
+            {
+                std::shared_lock lock(cache_mutex);
+                order = column_statistics.at(column_name).sorted_rows;
+            }
+            return order ? order_statistic(col_index, *order, 0.5) : calculate_median(col_index);
+        });
+    }
+
+    double dataset::get_quantile(const std::string& column_name, double q) {
+        return get_quantiles(column_name, {q}).front();
+    }
+
+    std::vector<double> dataset::get_quantiles(const std::string& column_name, const std::vector<double>& qs) {
+        if (is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a numerical column");
+        }
+        for (double q : qs) {
+            if (!(q >= 0.0 && q <= 1.0)) throw std::invalid_argument("Quantiles must be between 0 and 1");
         }
 
-        // Output for Categorical Data
-        out_file << "\nCategorical Data Frequency Counts:\n";
-        for (int col_index : categorical_columns) {
-            auto& col_name = columns[col_index];
-            out_file << col_name << ":\n";
-            for (const auto& pair : column_statistics[col_name].frequency_count.value()) {
-                out_file << "  " << pair.first << ": " << pair.second << "\n";
+        int col_index = column_index(column_name);
+        auto order = sorted_rows(col_index);
+        std::vector<double> quantiles;
+        quantiles.reserve(qs.size());
+        for (double q : qs) quantiles.push_back(order_statistic(col_index, *order, q));
+        return quantiles;
+    }
+
+    std::shared_ptr<const std::vector<size_t>> dataset::sorted_rows(int col_index) {
+        auto& stat = column_statistics.at(columns[col_index]);
+        {
+            std::shared_lock lock(cache_mutex);
+            if (stat.sorted_rows) {
+                SCITOOL_PROFILE_COUNT("dataset.stat_cache.hits", 1);
+                return stat.sorted_rows;
             }
         }
+        SCITOOL_PROFILE_COUNT("dataset.stat_cache.misses", 1);
 
-        out_file << "\n\n";
+        std::vector<size_t> rows(row_count);
+        std::iota(rows.begin(), rows.end(), size_t(0));
+        std::vector<std::uint64_t> keys = sort_keys(col_index, rows, true);
+        radix_sort(keys, rows);
+        auto order = std::make_shared<const std::vector<size_t>>(std::move(rows));
 
-        auto column_widths = dataset::get_width(columns);
-        int max_row_label_width = *std::max_element(column_widths.begin(), column_widths.end());
+        std::unique_lock lock(cache_mutex);
+        if (!stat.sorted_rows) stat.sorted_rows = std::move(order);
+        return stat.sorted_rows;
+    }
 
-        // Output column headers
-        out_file << std::setw(max_row_label_width) << std::setfill(' ') << " |";
-        for (int col_index : numerical_columns) {
-            out_file << std::setw(column_widths[col_index] - 1) << columns[col_index] << "|";
+    double dataset::order_statistic(int col_index, const std::vector<size_t>& order, double q) const {
+        const double* values = column_values[col_index].numbers.data();
+        // the missing values are at the end of the order
+        size_t present = static_cast<size_t>(std::partition_point(order.begin(), order.end(), [values](size_t row) {
+            return !std::isnan(values[row]);
+        }) - order.begin());
+        if (present == 0) {
+            throw std::runtime_error("Cannot compute quantiles with all values missing");
         }
-        out_file << "\n";
 
-        // Output horizontal separator with '+' at intersections
-        out_file << std::setfill('-') << std::setw(max_row_label_width) << "+";
-        for (int col_index : numerical_columns) {
-            out_file << std::setw(column_widths[col_index]) << std::setfill('-') << "+";
-        }
-        out_file << std::setfill(' ') << "\n";
+        double position = q * static_cast<double>(present - 1);
+        auto lower = static_cast<size_t>(position);
+        if (lower + 1 >= present) return values[order[present - 1]];
 
-        // Output rows with row labels
-        for (Eigen::Index i = 0; i < correlation_matrix.value().rows(); ++i) {
-            out_file << std::setw(max_row_label_width - 1) << columns[i] << "|";
-            for (Eigen::Index j = 0; j < correlation_matrix.value().cols(); ++j) {
-                out_file << std::setw(column_widths[j] - 1) << std::setprecision(3) << correlation_matrix.value()(i, j) << "|";
+        double a = values[order[lower]], b = values[order[lower + 1]];
+        double fraction = position - static_cast<double>(lower);
+        // the median of an even number of values is the mean of the middle two, as in calculate_median
+        return fraction == 0.5 ? (a + b) / 2.0 : a + fraction * (b - a);
+    }
+
+    std::vector<std::uint64_t> dataset::sort_keys(int col_index, const std::vector<size_t>& rows, bool ascending) const {
+        const auto& column = column_values[col_index];
+        const std::uint64_t missing = std::numeric_limits<std::uint64_t>::max();
+        std::vector<std::uint64_t> keys(rows.size());
+
+        if (!column.categorical) {
+            const double* values = column.numbers.data();
+            for (size_t i = 0; i < rows.size(); ++i) {
+                std::uint64_t key = order_key(values[rows[i]]);
+                keys[i] = ascending || key == missing ? key : ~key;
             }
-            out_file << "\n";
+            return keys;
         }
 
-        out_file << std::setfill('-') << std::setw(max_row_label_width) << "+";
-        for (size_t i = 0; i < numerical_columns.size(); ++i) {
-            out_file << std::setw(column_widths[i]) << std::setfill('-') << "+";
+        // the key of a code is the rank of its string among the values of the dictionary
+        const auto& categories = column.categories;
+        std::vector<categorical_column::code_type> codes(categories.dictionary_size());
+        std::iota(codes.begin(), codes.end(), categorical_column::code_type(1));
+        std::sort(codes.begin(), codes.end(), [&categories](auto a, auto b) {
+            return categories.value_of(a) < categories.value_of(b);
+        });
+
+        std::vector<std::uint64_t> rank(categories.dictionary_size() + 1, missing);
+        for (size_t i = 0; i < codes.size(); ++i) {
+            rank[codes[i]] = ascending ? i : codes.size() - 1 - i;
+        }
+        for (size_t i = 0; i < rows.size(); ++i) keys[i] = rank[categories.code_at(rows[i])];
+        return keys;
+    }
+
+    std::vector<size_t> dataset::sort_by(const std::vector<std::string>& column_names, bool ascending) {
+        return sort_by(column_names, std::vector<bool>(column_names.size(), ascending));
+    }
+
+    std::vector<size_t> dataset::sort_by(const std::vector<std::string>& column_names, const std::vector<bool>& ascending) {
+        SCITOOL_PROFILE_SCOPE("dataset.sort_by");
+        if (column_names.empty()) {
+            throw std::invalid_argument("At least one column is needed to sort");
+        }
+        if (ascending.size() != column_names.size()) {
+            throw std::invalid_argument("One sort direction is needed per column");
+        }
+
+        std::vector<int> indices;
+        for (const auto& name : column_names) indices.push_back(column_index(name));
+
+        // the increasing order of a single numerical column is cached for the quantile queries
+        if (indices.size() == 1 && ascending.front() && !column_values[indices.front()].categorical) {
+            return *sorted_rows(indices.front());
         }
-        out_file << std::setfill(' ') << "\n";
 
-        out_file.close();
+        // the radix sort is stable, so sorting by the last column first leaves ties ordered by the next ones
+        std::vector<size_t> rows(row_count);
+        std::iota(rows.begin(), rows.end(), size_t(0));
+        for (size_t i = indices.size(); i-- > 0;) {
+            std::vector<std::uint64_t> keys = sort_keys(indices[i], rows, ascending[i]);
+            radix_sort(keys, rows);
+        }
+        return rows;
     }
 
-    void dataset::calculate_mean(const std::string& column_name) {
-        int col_index = column_statistics[column_name].col_index;
-        std::vector<std::optional<double>> column_data = extract_numerical_column_data(col_index);
-        double mean_value = scitool::mean(column_data);
-        column_statistics[column_name].mean = mean_value;
+    rolling_window dataset::rolling(const std::vector<std::string>& column_names, size_t window, size_t min_periods) const {
+        if (window == 0) {
+            throw std::invalid_argument("The window must hold at least one row");
+        }
+        return rolling_window(*this, column_names, window, min_periods == 0 ? window : min_periods);
     }
 
-    void dataset::calculate_std_dev(const std::string& column_name) {
-        int col_index = column_statistics[column_name].col_index;
-        std::vector<std::optional<double>> column_data = extract_numerical_column_data(col_index);
-        double std_dev_value = scitool::std_dev(column_data);
-        column_statistics[column_name].std_dev = std_dev_value;
+    rolling_window dataset::cumulative(const std::vector<std::string>& column_names, size_t min_periods) const {
+        return rolling_window(*this, column_names, 0, min_periods);
     }
 
-    void dataset::calculate_median(const std::string& column_name) {
-        int col_index = column_statistics[column_name].col_index;
-        std::vector<std::optional<double>> column_data = extract_numerical_column_data(col_index);
-        double median_value = scitool::median(column_data);
-        column_statistics[column_name].median = median_value;
+    bootstrap_result dataset::bootstrap(const std::string& column_name, aggregate statistic, const bootstrap_options& options) {
+        if (statistic == aggregate::median) return bootstrap_quantile(column_name, 0.5, options);
+        return bootstrap_statistic(get_numerical_data(column_name), row_count, statistic, options);
     }
 
-    void dataset::calculate_variance(const std::string& column_name) {
-        int col_index = column_statistics[column_name].col_index;
-        std::vector<std::optional<double>> column_data = extract_numerical_column_data(col_index);
-        double variance_value = scitool::variance(column_data);
-        column_statistics[column_name].variance = variance_value;
+    bootstrap_result dataset::bootstrap_quantile(const std::string& column_name, double q, const bootstrap_options& options) {
+        const double* values = get_numerical_data(column_name);
+        // the cached order of the column, whose missing values come last
+        auto order = sorted_rows(column_index(column_name));
+        size_t present = static_cast<size_t>(std::partition_point(order->begin(), order->end(), [values](size_t row) {
+            return !std::isnan(values[row]);
+        }) - order->begin());
+        return scitool::bootstrap_quantile(values, order->data(), present, q, options);
     }
 
-    void dataset::calculate_frequency_count(const std::string& column_name) {
-        int col_index = column_statistics[column_name].col_index;
-        std::map<std::string, int> frequency_map = extract_categorical_column_data(col_index);
-        column_statistics[column_name].frequency_count = frequency_map;
+    bootstrap_result dataset::bootstrap_correlation(const std::string& x_column, const std::string& y_column,
+                                                    const bootstrap_options& options) const {
+        return scitool::bootstrap_correlation(get_numerical_data(x_column), get_numerical_data(y_column), row_count, options);
     }
 
-    // Helper function to extract numerical data from a column
-    std::vector<std::optional<double>> dataset::extract_numerical_column_data(int col_index) {
-        std::vector<std::optional<double>> column_data;
-        column_data.reserve(data_matrix.size()); // Reserve space to avoid repeated reallocations
+    std::vector<size_t> dataset::fill_missing(const std::vector<std::string>& column_names, imputation_method method, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.fill_missing");
+        std::vector<int> indices = fillable_columns(column_names);
+        // every column is computed before any is filled, so that an error leaves the dataset unchanged
+        std::vector<filled_cells> cells(indices.size());
+        parallel_for(indices.size(), [&](size_t i) {
+            int col_index = indices[i];
+            const double* values = column_values[col_index].numbers.data();
+            double fill_value = std::numeric_limits<double>::quiet_NaN();
+            // a column without any value has no mean or median, it is left missing
+            bool any_value = std::any_of(values, values + row_count, [](double value) { return !std::isnan(value); });
+            if (method == imputation_method::mean && any_value) fill_value = get_mean(columns[col_index]);
+            if (method == imputation_method::median && any_value) fill_value = get_median(columns[col_index]);
 
-        for (const auto& row : data_matrix) {
-            const auto& cell = row[col_index];
-            if (!cell) {
-                // If the cell is empty, add std::nullopt
-                column_data.emplace_back(std::nullopt);
-                continue;
-            }
+            cells[i] = impute_gaps(values, row_count, method, fill_value);
+        }, threads);
+        return apply_filled_columns(indices, cells, threads);
+    }
 
-            // Extract the value if it's an int or double, else add std::nullopt
-            column_data.emplace_back(
-                    std::visit([](const auto& arg) -> std::optional<double> {
-                        using T = std::decay_t<decltype(arg)>;
-                        if constexpr (std::is_same_v<T, int> || std::is_same_v<T, double>) {
-                            return static_cast<double>(arg);
-                        } else {
-                            return std::nullopt;
-                        }
-                    }, cell.value())
-            );
+    std::vector<size_t> dataset::interpolate_missing(const std::vector<std::string>& column_names, const std::string& by_column,
+                                                     interpolation_method method, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.interpolate_missing");
+        std::vector<int> indices = fillable_columns(column_names);
+        int by_index = column_index(by_column);
+        if (column_values[by_index].categorical) {
+            throw std::invalid_argument("Column '" + by_column + "' is not a numerical column");
+        }
+        if (std::find(indices.begin(), indices.end(), by_index) != indices.end()) {
+            throw std::invalid_argument("Column '" + by_column + "' cannot be interpolated as a function of itself");
         }
 
-        return column_data;
+        // the knots of every column are collected in the cached increasing order of by_column
+        auto order = sorted_rows(by_index);
+        std::vector<filled_cells> cells(indices.size());
+        parallel_for(indices.size(), [&](size_t i) {
+            cells[i] = interpolate_gaps(column_values[by_index].numbers.data(), column_values[indices[i]].numbers.data(),
+                                        *order, method);
+        }, threads);
+        return apply_filled_columns(indices, cells, threads);
     }
 
-    // Helper function to extract categorical data from a column
-    std::map<std::string, int> dataset::extract_categorical_column_data(int colIndex) {
-        std::map<std::string, int> frequency_map;
-        for (const auto& row : data_matrix) {
-            auto& cell = row[colIndex];
-            if (cell.has_value() && std::holds_alternative<std::string>(cell.value())) {
-                std::string value = std::get<std::string>(cell.value());
-                frequency_map[value]++;
+    std::vector<int> dataset::fillable_columns(const std::vector<std::string>& column_names) const {
+        std::vector<int> indices;
+        for (const auto& name : column_names) {
+            int col_index = column_index(name);
+            if (column_values[col_index].categorical) {
+                throw std::invalid_argument("Column '" + name + "' is not a numerical column");
+            }
+            if (std::find(indices.begin(), indices.end(), col_index) != indices.end()) {
+                throw std::invalid_argument("Column '" + name + "' is listed twice");
             }
+            indices.push_back(col_index);
         }
-        return frequency_map;
+        return indices;
     }
 
-    double dataset::get_mean(const std::string& column_name) {
-        auto& col_stats = column_statistics[column_name];
-        if (!col_stats.mean) {
-            calculate_mean(column_name);
-        }
-        return col_stats.mean.value();
+    std::vector<size_t> dataset::apply_filled_columns(const std::vector<int>& indices, const std::vector<filled_cells>& cells,
+                                                      size_t threads) {
+        std::vector<size_t> filled(indices.size(), 0);
+        parallel_for(indices.size(), [&](size_t i) {
+            apply_filled_cells(indices[i], cells[i]);
+            filled[i] = cells[i].rows.size();
+        }, threads);
+        return filled;
     }
 
-    double dataset::get_variance(const std::string& column_name) {
-        auto& col_stats = column_statistics[column_name];
-        if (!col_stats.variance) {
-            calculate_variance(column_name);
+    void dataset::apply_filled_cells(int col_index, const filled_cells& cells) {
+        if (cells.rows.empty()) return;
+
+        auto& column = column_values[col_index];
+        // the sum is shifted by the first value, so that equal values (a mean imputation) have exactly their mean
+        double shift = cells.values.front(), sum = 0.0;
+        bool integral = column.integral;
+        for (size_t i = 0; i < cells.rows.size(); ++i) {
+            double value = cells.values[i];
+            column.numbers[cells.rows[i]] = value;
+            sum += value - shift;
+            integral = integral && std::trunc(value) == value && value >= std::numeric_limits<int>::min() &&
+                       value <= std::numeric_limits<int>::max();
         }
-        return col_stats.variance.value();
-    }
+        column.integral = integral;
 
-    double dataset::get_std_dev(const std::string& column_name) {
-        auto& col_stats = column_statistics[column_name];
-        if (!col_stats.std_dev) {
-            calculate_std_dev(column_name);
+        auto filled = static_cast<double>(cells.rows.size());
+        double filled_mean = shift + sum / filled;
+        double filled_m2 = 0.0;
+        for (double value : cells.values) filled_m2 += (value - filled_mean) * (value - filled_mean);
+
+        // the values were missing at the end of the cached order: they are sorted by themselves and merged
+        // with the values present before, ties ordered by row as the radix sort of sorted_rows leaves them
+        std::shared_ptr<const std::vector<size_t>> order;
+        {
+            std::shared_lock lock(cache_mutex);
+            order = column_statistics.at(columns[col_index]).sorted_rows;
+        }
+        if (order) {
+            const double* values = column.numbers.data();
+            auto before = [values](size_t a, size_t b) {
+                std::uint64_t key_a = order_key(values[a]), key_b = order_key(values[b]);
+                return key_a < key_b || (key_a == key_b && a < b);
+            };
+            std::vector<size_t> rows(cells.rows);
+            std::sort(rows.begin(), rows.end(), before);
+
+            auto present_end = order->begin() + static_cast<std::ptrdiff_t>(cells.present);
+            std::vector<size_t> merged;
+            merged.reserve(row_count);
+            std::merge(order->begin(), present_end, rows.begin(), rows.end(), std::back_inserter(merged), before);
+            std::copy_if(present_end, order->end(), std::back_inserter(merged), [values](size_t row) {
+                return std::isnan(values[row]);
+            });
+            order = std::make_shared<const std::vector<size_t>>(std::move(merged));
         }
-        return col_stats.std_dev.value();
+
+        std::unique_lock lock(cache_mutex);
+        auto& stat = column_statistics.at(columns[col_index]);
+        // Chan's update of the mean and the sum of squared deviations with those of the filled values. A column
+        // without any value before has them exactly
+        auto present = static_cast<double>(cells.present);
+        std::optional<double> old_mean = cells.present == 0 ? std::optional<double>(0.0) : stat.mean;
+        std::optional<double> old_variance = cells.present == 0 ? std::optional<double>(0.0) : stat.variance;
+        if (!old_variance && stat.std_dev) old_variance = *stat.std_dev * *stat.std_dev;
+        if (old_mean) {
+            double delta = filled_mean - *old_mean;
+            stat.mean = *old_mean + delta * filled / (present + filled);
+            if (old_variance) {
+                double m2 = *old_variance * present + filled_m2 + delta * delta * present * filled / (present + filled);
+                stat.variance = m2 / (present + filled);
+                stat.std_dev = std::sqrt(*stat.variance);
+            }
+        }
+        if (!old_mean || !old_variance) {
+            stat.variance = std::nullopt;
+            stat.std_dev = std::nullopt;
+        }
+
+        // filling with copies of the median (median imputation) leaves it unchanged, otherwise it is read
+        // from the merged order
+        bool median_kept = stat.median && std::all_of(cells.values.begin(), cells.values.end(), [&stat](double value) {
+            return value == *stat.median;
+        });
+        stat.sorted_rows = order;
+        if (!median_kept) stat.median = order ? std::optional<double>(order_statistic(col_index, *order, 0.5)) : std::nullopt;
+        // every correlation with the column now covers more rows
+        correlation_matrix = std::nullopt;
     }
 
-    double dataset::get_median(const std::string& column_name) {
-        auto& col_stats = column_statistics[column_name];
-        if (!col_stats.median) {
-            calculate_median(column_name);
+    std::vector<size_t> dataset::top_n(const std::string& column_name, size_t n, bool largest) const {
+        if (is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a numerical column");
         }
-        return col_stats.median.value();
+
+        const double* values = column_values[column_index(column_name)].numbers.data();
+        // "better" orders the candidates best first, so the top of the heap is the worst row kept so far
+        auto better = [values, largest](size_t a, size_t b) {
+            if (values[a] != values[b]) return largest ? values[a] > values[b] : values[a] < values[b];
+            return a < b;
+        };
+
+        std::vector<size_t> heap;
+        heap.reserve(std::min(n, row_count));
+        for (size_t row = 0; row < row_count && n > 0; ++row) {
+            if (std::isnan(values[row])) continue;
+            if (heap.size() < n) {
+                heap.push_back(row);
+                std::push_heap(heap.begin(), heap.end(), better);
+            } else if (better(row, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), better);
+                heap.back() = row;
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), better);
+        return heap;
     }
 
     Eigen::MatrixXd dataset::get_correlation_matrix() {
-        if (!correlation_matrix) {
-            calculate_correlation_matrix();
+        {
+            std::shared_lock lock(cache_mutex);
+            if (correlation_matrix) {
+                SCITOOL_PROFILE_COUNT("dataset.stat_cache.hits", 1);
+                return *correlation_matrix;
+            }
         }
-        return correlation_matrix.value();
+        SCITOOL_PROFILE_COUNT("dataset.stat_cache.misses", 1);
+
+        Eigen::MatrixXd matrix = calculate_correlation_matrix();
+        std::unique_lock lock(cache_mutex);
+        if (!correlation_matrix) correlation_matrix = std::move(matrix);
+        return *correlation_matrix;
     }
 
     std::map<std::string, int> dataset::get_frequency_count(const std::string& column_name) {
         // Check if the column exists and is categorical
-        auto col_it = std::find(columns.begin(), columns.end(), column_name);
-        if (col_it == columns.end()) {
-            throw std::invalid_argument("Column '" + column_name + "' does not exist");
-        }
-
         if (!is_categorical(column_name)) {
             throw std::invalid_argument("Column '" + column_name + "' is not a categorical column");
         }
 
-        auto& col_stats = column_statistics[column_name];
-        if (!col_stats.frequency_count) {
-            calculate_frequency_count(column_name);
+        {
+            std::shared_lock lock(cache_mutex);
+            const auto& cached = column_statistics.at(column_name).frequency_count;
+            if (cached) {
+                SCITOOL_PROFILE_COUNT("dataset.stat_cache.hits", 1);
+                return *cached;
+            }
         }
+        SCITOOL_PROFILE_COUNT("dataset.stat_cache.misses", 1);
 
-        return col_stats.frequency_count.value();
+        std::map<std::string, int> frequency_map = extract_categorical_column_data(column_index(column_name));
+        std::unique_lock lock(cache_mutex);
+        auto& cached = column_statistics.at(column_name).frequency_count;
+        if (!cached) cached = std::move(frequency_map);
+        return *cached;
     }
 
-    void dataset::calculate_correlation_matrix() {
-        size_t num_numerical_columns = numerical_columns.size();
-        Eigen::MatrixXd matrix_xd(num_numerical_columns, num_numerical_columns);
+    std::vector<std::optional<double>> dataset::get_numerical_column(const std::string& column_name) {
+        if (is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a numerical column");
+        }
 
-        std::vector<std::vector<std::optional<double>>> column_data(num_numerical_columns);
+        return extract_numerical_column_data(column_index(column_name));
+    }
 
-        // Extract data for each numerical column
-        int idx = 0;
-        for (auto col_index : numerical_columns) {
-            column_data[idx++] = extract_numerical_column_data(col_index);
+    const std::vector<std::string>& dataset::get_column_names() const {
+        return columns;
+    }
+
+    std::vector<std::string> dataset::get_numerical_column_names() const {
+        std::vector<std::string> names;
+        for (int col_index : numerical_columns) {
+            names.push_back(columns[col_index]);
         }
+        return names;
+    }
 
-        for (size_t i = 0; i < num_numerical_columns; ++i) {
-            for (size_t j = 0; j <= i; ++j) { // Compute only half the matrix_xd
-                matrix_xd(i, j) = matrix_xd(j, i) = scitool::correlation(column_data[i], column_data[j]);
-            }
+    void dataset::copy_numerical_column(const std::string& column_name, double* out, size_t stride) {
+        const double* values = get_numerical_data(column_name);
+        if (stride == 1) {
+            std::copy(values, values + row_count, out);
+            return;
         }
 
-        correlation_matrix.emplace(matrix_xd);
+        for (size_t row = 0; row < row_count; ++row) {
+            out[row * stride] = values[row];
+        }
     }
 
-    bool dataset::is_categorical(const std::string& column_name) {
-        auto col_it = std::find(columns.begin(), columns.end(), column_name);
-        if (col_it == columns.end()) {
-            throw std::invalid_argument("Column '" + column_name + "' does not exist");
+    const double* dataset::get_numerical_data(const std::string& column_name) const {
+        if (is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a numerical column");
         }
 
-        auto& col_stats = column_statistics[column_name];
-        return std::find(categorical_columns.begin(), categorical_columns.end(), col_stats.col_index) != categorical_columns.end();
+        return column_values[column_index(column_name)].numbers.data();
     }
 
-    std::optional<dataset::data_variant> dataset::convert(const std::string &str) {
-        if (str.empty()) return std::nullopt;
+    Eigen::MatrixXd dataset::calculate_correlation_matrix() const {
+        SCITOOL_PROFILE_SCOPE("dataset.correlation_matrix");
+        size_t num_numerical_columns = numerical_columns.size();
+        Eigen::MatrixXd matrix_xd(num_numerical_columns, num_numerical_columns);
 
-        char* end;
-        int i = (int) strtol(str.c_str(), &end, 10);
-        if (*end == 0) return i;
+        std::vector<const double*> column_data;
+        std::vector<double> means;
+        column_data.reserve(num_numerical_columns);
+        means.reserve(num_numerical_columns);
+        for (auto col_index : numerical_columns) {
+            column_data.push_back(numerical_values(col_index));
+            means.push_back(scitool::mean(column_data.back(), row_count));
+        }
 
-        double d = strtod(str.c_str(), &end);
-        if (*end == 0) return d;
+        // the rows of the lower half are independent, each task fills one of them and its mirror column
+        parallel_for(num_numerical_columns, [&](size_t i) {
+            for (size_t j = 0; j <= i; ++j) {
+                matrix_xd(i, j) = matrix_xd(j, i) = scitool::correlation(column_data[i], column_data[j], row_count, means[i], means[j]);
+            }
+        });
 
-        return str;
+        return matrix_xd;
+    }
+
+    bool dataset::is_categorical(const std::string& column_name) const {
+        return categorical_columns.count(column_index(column_name)) > 0;
     }
 
     const std::string& dataset::get_file_name() const {
@@ -354,15 +998,317 @@ namespace scitool {
         // Check if the column index is valid
         if(col_index < columns.size()) {
             // Reset the column statistics to their default (empty) state
+            std::unique_lock lock(cache_mutex);
             auto &col_stat = column_statistics[columns[col_index]];
             col_stat.mean = std::nullopt;
             col_stat.std_dev = std::nullopt;
             col_stat.median = std::nullopt;
             col_stat.variance = std::nullopt;
             col_stat.frequency_count = std::nullopt;
+            col_stat.sorted_rows = nullptr;
             correlation_matrix = std::nullopt;
         } else {
             throw std::out_of_range("Column index out of range");
         }
     }
+
+    void dataset::clear_statistics_cache() {
+        reset_all_values();
+    }
+
+    void dataset::reset_all_values() {
+        std::unique_lock lock(cache_mutex);
+        for (auto& entry : column_statistics) {
+            auto& col_stat = entry.second;
+            col_stat.mean = std::nullopt;
+            col_stat.std_dev = std::nullopt;
+            col_stat.median = std::nullopt;
+            col_stat.variance = std::nullopt;
+            col_stat.frequency_count = std::nullopt;
+            col_stat.sorted_rows = nullptr;
+        }
+        correlation_matrix = std::nullopt;
+    }
+
+    void dataset::compact_rows(const std::vector<char>& keep) {
+        size_t kept = 0;
+        for (auto& column : column_values) {
+            if (column.categorical) {
+                column.categories.keep_rows(keep);
+                kept = column.categories.size();
+                continue;
+            }
+
+            kept = 0;
+            for (size_t row = 0; row < row_count; ++row) {
+                if (keep[row]) column.numbers[kept++] = column.numbers[row];
+            }
+            column.numbers.resize(kept);
+        }
+        if (column_values.empty()) kept = static_cast<size_t>(std::count(keep.begin(), keep.end(), true));
+        row_count = kept;
+
+        // every column lost rows, so every statistic is stale
+        reset_all_values();
+    }
+
+    void dataset::filter_categories(const std::string& column_name, const std::vector<std::string>& values) {
+        if (!is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a categorical column");
+        }
+
+        // the values are looked up once, the rows compare codes only
+        const auto& categories = column_values[column_index(column_name)].categories;
+        std::vector<char> wanted(categories.dictionary_size() + 1, false);
+        for (const auto& value : values) {
+            auto code = categories.find(value);
+            if (code != categorical_column::missing_code) wanted[code] = true;
+        }
+
+        std::vector<char> keep(row_count, false);
+        categories.for_each_run([&](categorical_column::code_type code, size_t first, size_t count) {
+            if (wanted[code]) std::fill(keep.begin() + static_cast<std::ptrdiff_t>(first),
+                                        keep.begin() + static_cast<std::ptrdiff_t>(first + count), true);
+        });
+        compact_rows(keep);
+    }
+
+    void dataset::set_run_length_encoding(const std::string& column_name, bool enabled) {
+        if (!is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a categorical column");
+        }
+        column_values[column_index(column_name)].categories.set_run_length_encoding(enabled);
+    }
+
+    bool dataset::is_run_length_encoded(const std::string& column_name) const {
+        if (!is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a categorical column");
+        }
+        return column_values[column_index(column_name)].categories.run_length_encoded();
+    }
+
+    size_t dataset::memory_usage() const {
+        size_t bytes = 0;
+        for (const auto& column : column_values) {
+            bytes += column.categorical ? column.categories.memory_usage() : column.numbers.capacity() * sizeof(double);
+        }
+        return bytes;
+    }
+
+    std::map<std::string, std::unique_ptr<dataset>> dataset::group_by(const std::string& column_name) const {
+        SCITOOL_PROFILE_SCOPE("dataset.group_by");
+        if (!is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is not a categorical column");
+        }
+
+        // rows of each dictionary code, in the order of the dataset
+        const auto& keys = column_values[column_index(column_name)].categories;
+        std::vector<std::vector<size_t>> code_rows(keys.dictionary_size() + 1);
+        keys.for_each_run([&code_rows](categorical_column::code_type code, size_t first, size_t count) {
+            for (size_t row = first; row < first + count; ++row) code_rows[code].push_back(row);
+        });
+
+        std::map<std::string, std::unique_ptr<dataset>> groups;
+        for (size_t code = 1; code < code_rows.size(); ++code) {
+            const auto& rows = code_rows[code];
+            if (rows.empty()) continue;
+
+            std::unique_ptr<dataset> group(new dataset(columns, numerical_columns, categorical_columns));
+            for (size_t col = 0; col < column_values.size(); ++col) {
+                const auto& source = column_values[col];
+                auto& target = group->column_values[col];
+                target.integral = source.integral;
+                if (source.categorical) {
+                    target.categories.assign_rows(source.categories, rows);
+                    target.categories.choose_encoding();
+                } else {
+                    target.numbers.reserve(rows.size());
+                    for (size_t row : rows) target.numbers.push_back(source.numbers[row]);
+                }
+            }
+            group->row_count = rows.size();
+            group->file_name = file_name;
+            groups.emplace(keys.value_of(static_cast<categorical_column::code_type>(code)), std::move(group));
+        }
+        return groups;
+    }
+
+    Eigen::MatrixXd dataset::covariance_matrix(const std::vector<std::string>& column_names) {
+        return lazy().covariance_matrix(column_names);
+    }
+
+    regression_result dataset::regress(const std::string& target, const std::vector<std::string>& predictors) {
+        return lazy().regress(target, predictors);
+    }
+
+    regression_result dataset::regress_csv(const std::string& input_file, const std::string& target, const std::vector<std::string>& predictors,
+                                           size_t chunk_rows) {
+        std::vector<std::string> variables = predictors;
+        variables.push_back(target);
+        scatter_accumulator total(variables.size());
+        read_csv_chunks(input_file, chunk_rows, [&](dataset& chunk) {
+            total.merge(chunk.lazy().scatter(variables));
+        });
+        return fit_least_squares(total, predictors);
+    }
+
+    binning dataset::value_range_bins(const std::string& column_name, size_t bins) const {
+        const double* values = get_numerical_data(column_name);
+        double low = std::numeric_limits<double>::infinity(), high = -low;
+        for (size_t row = 0; row < row_count; ++row) {
+            // NaN fails both comparisons
+            if (values[row] < low) low = values[row];
+            if (values[row] > high) high = values[row];
+        }
+        // NumPy counts an empty column over [0, 1]
+        if (low > high) return binning(bins, 0.0, 1.0);
+        return binning::of_range(bins, low, high);
+    }
+
+    histogram_result dataset::histogram(const std::string& column_name, size_t bins, size_t threads) const {
+        return compute_histogram(get_numerical_data(column_name), row_count, value_range_bins(column_name, bins), threads);
+    }
+
+    histogram_result dataset::histogram(const std::string& column_name, size_t bins, double low, double high, size_t threads) const {
+        return compute_histogram(get_numerical_data(column_name), row_count, binning::of_range(bins, low, high), threads);
+    }
+
+    histogram_result dataset::histogram(const std::string& column_name, const std::vector<double>& edges, size_t threads) const {
+        return compute_histogram(get_numerical_data(column_name), row_count, binning(edges), threads);
+    }
+
+    histogram_2d_result dataset::histogram_2d(const std::string& x_column, const std::string& y_column, size_t x_bins, size_t y_bins,
+                                              size_t threads) const {
+        return compute_histogram_2d(get_numerical_data(x_column), get_numerical_data(y_column), row_count,
+                                    value_range_bins(x_column, x_bins), value_range_bins(y_column, y_bins), threads);
+    }
+
+    histogram_2d_result dataset::histogram_2d(const std::string& x_column, const std::string& y_column, const std::vector<double>& x_edges,
+                                              const std::vector<double>& y_edges, size_t threads) const {
+        return compute_histogram_2d(get_numerical_data(x_column), get_numerical_data(y_column), row_count,
+                                    binning(x_edges), binning(y_edges), threads);
+    }
+
+    join_keys dataset::join_columns(const std::vector<std::string>& on_columns, const dataset& dictionaries) const {
+        join_keys keys;
+        keys.rows = row_count;
+        keys.missing.assign(row_count, false);
+        for (const auto& name : on_columns) {
+            const auto& column = column_values[column_index(name)];
+            std::vector<std::uint64_t> values(row_count);
+            if (!column.categorical) {
+                for (size_t row = 0; row < row_count; ++row) {
+                    double value = column.numbers[row];
+                    if (std::isnan(value)) keys.missing[row] = true;
+                    // -0.0 and 0.0 are equal keys
+                    if (value == 0.0) value = 0.0;
+                    std::memcpy(&values[row], &value, sizeof(value));
+                }
+            } else {
+                // the codes of the other dataset are translated to the dictionary of this one, its values
+                // that do not appear here cannot match and count as missing
+                const auto& target = dictionaries.column_values[dictionaries.column_index(name)].categories;
+                std::vector<categorical_column::code_type> translated(column.categories.dictionary_size() + 1, categorical_column::missing_code);
+                for (size_t code = 1; code < translated.size(); ++code) {
+                    translated[code] = &target == &column.categories ? static_cast<categorical_column::code_type>(code)
+                                                                     : target.find(column.categories.value_of(static_cast<categorical_column::code_type>(code)));
+                }
+                column.categories.for_each_run([&](categorical_column::code_type code, size_t first, size_t count) {
+                    auto key = translated[code];
+                    for (size_t row = first; row < first + count; ++row) {
+                        values[row] = key;
+                        if (key == categorical_column::missing_code) keys.missing[row] = true;
+                    }
+                });
+            }
+            keys.keys.push_back(std::move(values));
+        }
+        return keys;
+    }
+
+    std::unique_ptr<dataset> dataset::join(const dataset& other, const std::vector<std::string>& on_columns, join_kind kind, size_t threads) const {
+        SCITOOL_PROFILE_SCOPE("dataset.join");
+        if (on_columns.empty()) {
+            throw std::invalid_argument("At least one column is needed to join");
+        }
+        for (const auto& name : on_columns) {
+            if (is_categorical(name) != other.is_categorical(name)) {
+                throw std::invalid_argument("Join column '" + name + "' must be numerical in both datasets or categorical in both");
+            }
+        }
+
+        join_result matches = hash_join(join_columns(on_columns, *this), other.join_columns(on_columns, *this), kind, threads);
+
+        // the columns of this dataset, then those of other that are not join columns
+        std::vector<std::string> names = columns;
+        std::set<int> num_cols = numerical_columns, cat_cols = categorical_columns;
+        std::vector<int> other_cols;
+        for (size_t col = 0; col < other.columns.size(); ++col) {
+            const std::string& name = other.columns[col];
+            if (std::find(on_columns.begin(), on_columns.end(), name) != on_columns.end()) continue;
+
+            std::string unique_name = name;
+            while (std::find(names.begin(), names.end(), unique_name) != names.end()) unique_name += "_right";
+            auto index = static_cast<int>(names.size());
+            names.push_back(unique_name);
+            (other.column_values[col].categorical ? cat_cols : num_cols).insert(index);
+            other_cols.push_back(static_cast<int>(col));
+        }
+
+        std::unique_ptr<dataset> result(new dataset(std::move(names), std::move(num_cols), std::move(cat_cols)));
+        size_t rows = matches.left_rows.size();
+        auto source_of = [&](size_t col) -> std::pair<const column_data*, const std::vector<size_t>*> {
+            if (col < column_values.size()) return {&column_values[col], &matches.left_rows};
+            return {&other.column_values[other_cols[col - column_values.size()]], &matches.right_rows};
+        };
+
+        // the arena is not thread-safe: the columns are allocated first, then the numbers are gathered in parallel
+        for (size_t col = 0; col < result->column_values.size(); ++col) {
+            auto [source, source_rows] = source_of(col);
+            auto& target = result->column_values[col];
+            target.integral = source->integral;
+            if (source->categorical) {
+                target.categories.assign_rows(source->categories, *source_rows);
+                target.categories.choose_encoding();
+            } else {
+                target.numbers.resize(rows);
+            }
+        }
+        parallel_for(result->column_values.size(), [&](size_t col) {
+            auto [source, source_rows] = source_of(col);
+            if (source->categorical) return;
+            double* numbers = result->column_values[col].numbers.data();
+            for (size_t i = 0; i < rows; ++i) {
+                size_t row = (*source_rows)[i];
+                numbers[i] = row == no_match ? std::numeric_limits<double>::quiet_NaN() : source->numbers[row];
+            }
+        }, threads);
+
+        result->row_count = rows;
+        result->file_name = file_name;
+        return result;
+    }
+
+    dataset::data_row dataset::operator[](size_t index) const {
+        if (index >= row_count) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        data_row row;
+        row.reserve(column_values.size());
+        for (const auto& column : column_values) {
+            if (column.categorical) {
+                std::string_view value = column.categories[index];
+                if (value.data()) row.emplace_back(std::string(value));
+                else row.emplace_back(std::nullopt);
+                continue;
+            }
+
+            double value = column.numbers[index];
+            if (std::isnan(value)) row.emplace_back(std::nullopt);
+            else if (column.integral) row.emplace_back(static_cast<int>(value));
+            else row.emplace_back(value);
+        }
+        return row;
+    }
 } // scitool
\ No newline at end of file
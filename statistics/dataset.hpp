@@ -2,13 +2,27 @@
 // Created by Giovanni Coronica on 01/12/23.
 //
 #include "stat_utils.hpp"
+#include "categorical_column.hpp"
+#include "csv_reader.hpp"
+#include "bootstrap.hpp"
+#include "histogram.hpp"
+#include "imputation.hpp"
+#include "join.hpp"
+#include "lazy_query.hpp"
+#include "rolling.hpp"
 #include <set>
 #include <map>
 #include <optional>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <cmath>
+#include <mutex>
+#include <shared_mutex>
 #include <variant>
 #include <iostream>
 #include <fstream>
+#include <functional>
 #include "Eigen/Core"
 
 #ifndef DATASET_HPP
@@ -29,122 +43,305 @@ namespace scitool {
             std::optional<double> median;
             std::optional<double> variance;
             std::optional<std::map<std::string, int>> frequency_count;
+            // rows of the numerical column by increasing value, missing values last. Shared, so that
+            // quantile queries can read it outside of the cache lock
+            std::shared_ptr<const std::vector<size_t>> sorted_rows;
         };
 
+        // Iterates over the rows, assembling each of them from the columns (see operator[])
         class iterator {
         public:
-            explicit iterator(typename matrix::iterator it) : current(it) {}
+            iterator(const dataset* owner, size_t row) : owner(owner), row(row) {}
 
             iterator& operator++() {
-                ++current;
+                ++row;
                 return *this;
             }
 
             bool operator!=(const iterator& other) const {
-                return current != other.current;
+                return row != other.row;
             }
 
-            const data_row& operator*() const {
-                return *current;
+            data_row operator*() const {
+                return (*owner)[row];
             }
 
         private:
-            typename matrix::iterator current;
+            const dataset* owner;
+            size_t row;
         };
 
-        dataset(std::vector<std::string> cols, matrix matrix, std::set<int> num_cols, std::set<int> cat_cols)
-                : data_matrix(std::move(matrix)), columns(std::move(cols)), numerical_columns(std::move(num_cols)), categorical_columns(std::move(cat_cols)) {
-            for (size_t col_idx = 0; col_idx < columns.size(); ++col_idx) {
-                column_statistics[columns[col_idx]] = column_stat{};
-                column_statistics[columns[col_idx]].col_index = col_idx;
-            }
-        }
+        dataset(std::vector<std::string> cols, const matrix& matrix, std::set<int> num_cols, std::set<int> cat_cols);
 
-        static std::unique_ptr<dataset> from_csv(const std::string& input_file);
+        // Reads a CSV file, the first line naming the columns. The type of a column is the one of its first value:
+        // numerical when it parses as a number, categorical otherwise. The file is read through a pipeline (see
+        // csv_reader.hpp): a reader thread reads blocks of lines while other threads parse the previous ones, and
+        // the parsed blocks are appended in order; stats, when given, receives the time spent by every stage.
+        // A file compressed with gzip or zstd is decompressed on the fly, without being written anywhere
+        static std::unique_ptr<dataset> from_csv(const std::string& input_file, const csv_read_options& options = {},
+                                                 csv_read_stats* stats = nullptr);
+        // builds a dataset of numerical columns from a row-major table of rows x column_names.size()
+        // values (e.g. a NumPy array), NaN values are stored as missing
+        static std::unique_ptr<dataset> from_numerical_data(std::vector<std::string> column_names, const double* values, size_t rows);
 
-        bool is_categorical(const std::string& column_name);
+        // Reads a CSV file chunk_rows lines at a time, calling func with a dataset of each chunk, so that files larger
+        // than memory can be summarized. The type of a column is decided in every chunk, as from_csv does for a file,
+        // and compressed files are read as from_csv reads them
+        static void read_csv_chunks(const std::string& input_file, size_t chunk_rows, const std::function<void(dataset&)>& func);
+
+        bool is_categorical(const std::string& column_name) const;
 
         double get_mean(const std::string& column_name);
         double get_std_dev(const std::string& column_name);
         double get_median(const std::string& column_name);
         double get_variance(const std::string& column_name);
+        // q-quantile of a numerical column (0 <= q <= 1), interpolating linearly between the two closest
+        // order statistics (as NumPy does by default). The sorted order of the column is computed once
+        // and cached, so further quantiles and the median are read from it
+        double get_quantile(const std::string& column_name, double q);
+        std::vector<double> get_quantiles(const std::string& column_name, const std::vector<double>& qs);
         const std::string& get_file_name() const;
         std::map<std::string, int> get_frequency_count(const std::string& column_name);
+        std::vector<std::optional<double>> get_numerical_column(const std::string& column_name);
+        const std::vector<std::string>& get_column_names() const;
+        std::vector<std::string> get_numerical_column_names() const;
+        // copies the values of a numerical column to out[0], out[stride], out[2 * stride], ...
+        // with NaN for missing values, so that columns can be written straight into a NumPy buffer
+        void copy_numerical_column(const std::string& column_name, double* out, size_t stride = 1);
+        // the size() values of a numerical column, stored contiguously with NaN for missing values. The pointer
+        // stays valid as long as the dataset, filter_rows shrinks the column in place
+        const double* get_numerical_data(const std::string& column_name) const;
         Eigen::MatrixXd get_correlation_matrix();
-
+        // population covariances of numerical columns (all of them when empty), each pair over the rows where both
+        // have a value. Computed in one scan with the machinery of lazy queries, as the correlations of agg
+        Eigen::MatrixXd covariance_matrix(const std::vector<std::string>& column_names = {});
+        // least squares fit of target on predictors with an intercept over the complete rows (see regression.hpp):
+        // the scatter matrix of the columns is accumulated in one parallel pass over chunks of rows
+        regression_result regress(const std::string& target, const std::vector<std::string>& predictors);
+        // the same fit, streaming a CSV file chunk_rows lines at a time with read_csv_chunks
+        static regression_result regress_csv(const std::string& input_file, const std::string& target,
+                                             const std::vector<std::string>& predictors, size_t chunk_rows = 65536);
+
+        // writes the text report of every column (see report.hpp for the other formats), "-" for the standard output
         void output_statistics(const std::string& output_file);
 
-        auto begin() {
-            return data_matrix.begin();
+        iterator begin() const {
+            return iterator(this, 0);
         }
 
-        auto end() {
-            return data_matrix.end();
+        iterator end() const {
+            return iterator(this, row_count);
         }
 
+        // rewrites the non-missing values of a numerical column with func, as a one-step lazy query (see lazy())
         template <typename Func>
         void map_column(const std::string& column_name, Func func) {
+            lazy().map(column_name, std::function<double(double)>(std::move(func))).collect(1);
+        }
+
+        size_t size() const  {
+            return row_count;
+        }
+
+        // keeps the rows whose value in the column passes func, as a one-step lazy query (see lazy()). Rows with a
+        // missing or non-numerical value in the column are removed
+        template <typename Func>
+        void filter_rows(const std::string& column_name, Func func) {
+            lazy().filter(column_name, std::function<bool(double)>(std::move(func))).collect(1);
+        }
+
+        // A lazy query over the rows of this dataset (see lazy_query.hpp): its map and filter steps run fused with
+        // the aggregations of agg in a single chunked, parallel scan, or are applied to the dataset by collect
+        lazy_query lazy() {
+            return lazy_query(*this);
+        }
+
+        // Like map_column, but func(double* values, size_t n) transforms in place the values of up to chunk_size
+        // consecutive non-missing cells at a time, so that callers can work on whole arrays (e.g. NumPy chunks)
+        template <typename Func>
+        void map_column_chunks(const std::string& column_name, size_t chunk_size, Func func) {
             if (is_categorical(column_name)) {
                 throw std::invalid_argument("Column '" + column_name + "' is categorical and cannot be mapped with a double-to-double function.");
             }
+            if (chunk_size == 0) {
+                throw std::invalid_argument("The chunk size must be positive");
+            }
 
-            int col_index = column_statistics[column_name].col_index;
-            for (auto& row : data_matrix) {
-                auto& element = row[col_index];
-                if (element) {
-                    if (std::holds_alternative<double>(*element)) {
-                        auto& val = std::get<double>(*element);
-                        val = func(val);
-                    } else if (std::holds_alternative<int>(*element)) {
-                        int val = std::get<int>(*element);
-                        *element = func(static_cast<double>(val));
-                    }
+            int col_index = column_index(column_name);
+            auto& column = column_values[col_index];
+            std::vector<double> values;
+            std::vector<size_t> rows;
+            values.reserve(chunk_size);
+            rows.reserve(chunk_size);
+
+            auto flush = [&]() {
+                func(values.data(), values.size());
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    column.numbers[rows[i]] = values[i];
                 }
+                values.clear();
+                rows.clear();
+            };
+
+            column.integral = false;
+            try {
+                for (size_t row = 0; row < row_count; ++row) {
+                    if (std::isnan(column.numbers[row])) continue;
+                    values.push_back(column.numbers[row]);
+                    rows.push_back(row);
+                    if (values.size() == chunk_size) flush();
+                }
+                if (!values.empty()) flush();
+            } catch (...) {
+                // the chunks mapped before the failure are kept, the cached statistics must not be
+                reset_values(col_index);
+                throw;
             }
 
             reset_values(col_index);
         }
 
-        auto size() const  {
-            return data_matrix.size();
-        }
-
+        // Like filter_rows, but func(const double* values, size_t n, bool* keep) decides up to chunk_size rows
+        // at a time. Rows with a missing or non-numerical value in the column are removed
         template <typename Func>
-        void filter_rows(const std::string& column_name, Func func) {
-            int col_index = column_statistics[column_name].col_index;
-
-            auto new_end = std::remove_if(data_matrix.begin(), data_matrix.end(), [&](const data_row& row) -> bool {
-
-                const auto& data_variant = *row[col_index];  // Get the variant
-
-                // Check and apply filter based on type
-                if (std::holds_alternative<double>(data_variant)) {
-                    double value = std::get<double>(data_variant);
-                    bool filterResult = func(value);
-                    return !filterResult;
-                } else if (std::holds_alternative<int>(data_variant)) {
-                    auto value = static_cast<double>(std::get<int>(data_variant));
-                    bool filterResult = func(value);
-                    return !filterResult;
-                } else {
-                    return true;
+        void filter_rows_chunks(const std::string& column_name, size_t chunk_size, Func func) {
+            if (chunk_size == 0) {
+                throw std::invalid_argument("The chunk size must be positive");
+            }
+
+            int col_index = column_index(column_name);
+            const auto& column = column_values[col_index];
+            std::vector<char> keep_row(row_count, false);
+            std::vector<double> values;
+            std::vector<size_t> rows;
+            values.reserve(chunk_size);
+            rows.reserve(chunk_size);
+            std::unique_ptr<bool[]> keep(new bool[chunk_size]);
+
+            auto flush = [&]() {
+                func(values.data(), values.size(), keep.get());
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    keep_row[rows[i]] = keep[i];
                 }
-            });
+                values.clear();
+                rows.clear();
+            };
+
+            if (!column.categorical) {
+                for (size_t row = 0; row < row_count; ++row) {
+                    if (std::isnan(column.numbers[row])) continue;
+                    values.push_back(column.numbers[row]);
+                    rows.push_back(row);
+                    if (values.size() == chunk_size) flush();
+                }
+                if (!values.empty()) flush();
+            }
 
-            data_matrix.erase(new_end, data_matrix.end());
-            reset_values(col_index);  // Assuming this function correctly resets column stats
+            compact_rows(keep_row);
         }
 
-
-        const data_row& operator[](size_t index) const {
-            if (index >= data_matrix.size()) {
-                throw std::out_of_range("Index out of range");
-            }
-            return data_matrix[index];
-        }
+        // Indices of the rows ordered by the values of the columns, the first column first and ties broken by
+        // the next ones; the rows themselves are not moved. Numerical columns sort by value, categorical ones by
+        // their strings, and missing values come last in either direction. The columns are sorted with a
+        // parallel radix sort (see sorting.hpp)
+        std::vector<size_t> sort_by(const std::vector<std::string>& column_names, bool ascending = true);
+        // with one direction per column
+        std::vector<size_t> sort_by(const std::vector<std::string>& column_names, const std::vector<bool>& ascending);
+
+        // rows of the n largest (or smallest) values of a numerical column, best first, ties by row. A heap of
+        // n rows is kept while scanning, so the column is never fully sorted
+        std::vector<size_t> top_n(const std::string& column_name, size_t n, bool largest = true) const;
+
+        // Histograms of a numerical column (see histogram.hpp): `bins` bins of equal width over the range of the
+        // values or over [low, high], or the bins between increasing edges. The column is counted in one pass,
+        // split between `threads` threads (0 for one per hardware thread)
+        histogram_result histogram(const std::string& column_name, size_t bins, size_t threads = 0) const;
+        histogram_result histogram(const std::string& column_name, size_t bins, double low, double high, size_t threads = 0) const;
+        histogram_result histogram(const std::string& column_name, const std::vector<double>& edges, size_t threads = 0) const;
+        // joint histograms of the values of two numerical columns in the same row
+        histogram_2d_result histogram_2d(const std::string& x_column, const std::string& y_column, size_t x_bins, size_t y_bins,
+                                         size_t threads = 0) const;
+        histogram_2d_result histogram_2d(const std::string& x_column, const std::string& y_column, const std::vector<double>& x_edges,
+                                         const std::vector<double>& y_edges, size_t threads = 0) const;
+
+        // Rolling statistics of numerical columns over the last `window` rows (see rolling.hpp), each computed in
+        // O(n) as a new dataset with the same columns, e.g. rolling({"price"}, 20).mean(). A row gets a value when
+        // its window holds at least min_periods non-missing values (0 for a full window)
+        rolling_window rolling(const std::vector<std::string>& column_names, size_t window, size_t min_periods = 0) const;
+        // the same statistics over all the rows up to each row: cumulative sums, counts, means, extremes...
+        rolling_window cumulative(const std::vector<std::string>& column_names, size_t min_periods = 1) const;
+
+        // Fills the missing values of numerical columns from the column itself (see imputation.hpp), or interpolates
+        // them as a function of by_column from the rows where both have a value. The columns are filled in parallel
+        // on `threads` threads (0 for one per hardware thread) and the number of cells filled in each is returned.
+        // The cached statistics of a filled column are updated rather than dropped: its mean, variance and standard
+        // deviation are combined with those of the filled values, and its sorted order is merged with their rows.
+        // Every column is computed before any is written, so that an error leaves all of them unchanged
+        std::vector<size_t> fill_missing(const std::vector<std::string>& column_names, imputation_method method, size_t threads = 0);
+        std::vector<size_t> interpolate_missing(const std::vector<std::string>& column_names, const std::string& by_column,
+                                                interpolation_method method = interpolation_method::linear, size_t threads = 0);
+
+        // Bootstrap confidence intervals of a statistic of a numerical column (sum, mean, variance, std_dev or median),
+        // of one of its quantiles, or of the correlation of two numerical columns over their complete rows. The
+        // replicates are Poisson bootstraps accumulated in parallel, reproducible for a given seed (see bootstrap.hpp)
+        bootstrap_result bootstrap(const std::string& column_name, aggregate statistic, const bootstrap_options& options = {});
+        bootstrap_result bootstrap_quantile(const std::string& column_name, double q, const bootstrap_options& options = {});
+        bootstrap_result bootstrap_correlation(const std::string& x_column, const std::string& y_column,
+                                               const bootstrap_options& options = {}) const;
+
+        // keeps the rows whose value in the categorical column is one of values, comparing dictionary codes
+        void filter_categories(const std::string& column_name, const std::vector<std::string>& values);
+
+        // Categorical columns are run-length encoded after loading when that is smaller than one code per
+        // row (sorted or clustered data), this forces the encoding of a column on or off
+        void set_run_length_encoding(const std::string& column_name, bool enabled);
+        bool is_run_length_encoded(const std::string& column_name) const;
+
+        // approximate bytes held by the values of the columns, categorical dictionaries included
+        size_t memory_usage() const;
+        // drops the cached statistics of every column, so that the next getters compute them again (the statistics
+        // benchmark times the getters this way)
+        void clear_statistics_cache();
+
+        // splits the rows by the values of a categorical column, into one dataset per value with every column
+        // of this one. Rows with a missing value in the column are left out
+        std::map<std::string, std::unique_ptr<dataset>> group_by(const std::string& column_name) const;
+
+        // Joins the rows of this dataset with the rows of other having equal values in every column of on_columns,
+        // which must be numerical in both datasets or categorical in both (categorical values are compared as
+        // strings). The result holds the columns of this dataset and then the other columns of other, suffixed
+        // with "_right" when the name is taken, and its rows are ordered as the rows of this dataset. Missing
+        // keys never match; a left join keeps the unmatched rows with missing values from other (see join.hpp)
+        std::unique_ptr<dataset> join(const dataset& other, const std::vector<std::string>& on_columns,
+                                      join_kind kind = join_kind::inner, size_t threads = 0) const;
+
+        // the row is assembled from the columns: integers for the numerical columns holding only integers,
+        // doubles for the other numerical columns and strings for the categorical ones
+        data_row operator[](size_t index) const;
 
     private:
-        matrix data_matrix;
+        friend class lazy_query;
+        friend class rolling_window;
+
+        // Values of one column. Numerical columns are contiguous doubles with NaN for missing values,
+        // categorical columns are codes into a dictionary of their distinct values (see categorical_column.hpp)
+        struct column_data {
+            bool categorical = false;
+            // every value of the numerical column was read as an integer
+            bool integral = false;
+            std::pmr::vector<double> numbers;
+            categorical_column categories;
+
+            column_data(std::pmr::memory_resource* resource, std::pmr::memory_resource* string_resource)
+                    : numbers(resource), categories(resource, string_resource) {}
+        };
+
+        // The columns are allocated from arena and the dictionary strings from string_arena, both are
+        // released in bulk with the dataset. They are declared first so that they outlive the columns
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> string_arena;
+        std::vector<column_data> column_values;
+        size_t row_count = 0;
         std::vector<std::string> columns;
         std::unordered_map<std::string, column_stat> column_statistics;
         std::optional<Eigen::MatrixXd> correlation_matrix;
@@ -152,29 +349,59 @@ namespace scitool {
         std::set<int> categorical_columns;
         std::string file_name;
 
+        // Guards column_statistics and correlation_matrix, so that statistics can be requested from several
+        // threads at once: lookups share the lock and the computations run outside of it. Methods modifying
+        // the data (map_column, filter_rows) must not run concurrently with any other call
+        mutable std::shared_mutex cache_mutex;
+
         // Helper methods to calculate statistics
-        void calculate_statistics();
-        void calculate_mean(const std::string& column_name);
-        void calculate_std_dev(const std::string& column_name);
-        void calculate_median(const std::string& column_name);
-        void calculate_variance(const std::string& column_name);
-        void calculate_frequency_count(const std::string& column_name); // For frequency count
-        void calculate_correlation_matrix();
-
-        std::map<std::string, int> extract_categorical_column_data(int colIndex);
-        std::vector<std::optional<double>> extract_numerical_column_data(int col_index);
-
-        static std::optional<dataset::data_variant> convert(const std::string &str);
+        double calculate_mean(int col_index) const;
+        double calculate_std_dev(int col_index) const;
+        double calculate_median(int col_index) const;
+        double calculate_variance(int col_index) const;
+        Eigen::MatrixXd calculate_correlation_matrix() const;
+        const double* numerical_values(int col_index) const;
+        std::shared_ptr<const std::vector<size_t>> sorted_rows(int col_index);
+        std::vector<std::uint64_t> sort_keys(int col_index, const std::vector<size_t>& rows, bool ascending) const;
+        double order_statistic(int col_index, const std::vector<size_t>& order, double q) const;
+        // keys of the join columns, categorical values as codes of the dictionaries of `dictionaries` (this dataset
+        // for both sides)
+        join_keys join_columns(const std::vector<std::string>& on_columns, const dataset& dictionaries) const;
+
+        int column_index(const std::string& column_name) const;
+        // bins of equal width over the smallest to the largest value of a numerical column
+        binning value_range_bins(const std::string& column_name, size_t bins) const;
+        template <typename Calculate>
+        double cached_statistic(const std::string& column_name, std::optional<double> column_stat::* statistic, Calculate calculate);
+
+        std::map<std::string, int> extract_categorical_column_data(int colIndex) const;
+        std::vector<std::optional<double>> extract_numerical_column_data(int col_index) const;
+
+        dataset(std::vector<std::string> cols, std::set<int> num_cols, std::set<int> cat_cols);
+        void init_columns();
+        // keeps the rows whose flag is set, moving them to the front of every column
+        void compact_rows(const std::vector<char>& keep);
         static std::string extract_file_name(const std::string& path);
-        static std::vector<int> get_width(const std::vector<std::string>& vector) {
-            std::vector<int> widths;
-            for (const auto& col : vector) {
-                widths.push_back(static_cast<int>(col.length()) + 2);  // Additional space for padding
-            }
-            return widths;
-        }
+        static std::vector<std::string> split_header(std::string_view line);
+        enum class column_kind { unknown, numerical, categorical };
+        // Parses the lines of a CSV file following its header. When kinds is given, its known kinds are imposed on
+        // the columns (their other values being missing) and it receives the kinds of the columns, unknown for
+        // the columns without any value
+        static std::unique_ptr<dataset> parse_csv(std::vector<std::string> column_names, std::string_view text,
+                                                  std::vector<column_kind>* kinds = nullptr);
+        // appends the rows of a block parsed with the same columns, kinds being the kinds decided so far
+        void append_block(dataset& block, std::vector<column_kind>& block_kinds, std::vector<column_kind>& kinds, std::string_view text);
+
+        // indices of distinct numerical columns, which can be written in parallel
+        std::vector<int> fillable_columns(const std::vector<std::string>& column_names) const;
+        // writes the filled cells into the column and updates its cached statistics with them
+        void apply_filled_cells(int col_index, const filled_cells& cells);
+        // applies the cells computed for each of the columns in parallel, and returns the number filled in each
+        std::vector<size_t> apply_filled_columns(const std::vector<int>& indices, const std::vector<filled_cells>& cells,
+                                                 size_t threads);
 
         void reset_values(size_t col_index);
+        void reset_all_values();
 
     };
 
@@ -0,0 +1,114 @@
+#include "histogram.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        // Counts the bins of n items in slices, one partial histogram of bin_count + 1 entries per slice (the last
+        // entry collects the items outside of the bins), and returns their sum. bin_of(i) is the bin of item i
+        template <typename BinOf>
+        std::vector<size_t> count_bins(size_t n, size_t bin_count, size_t threads, BinOf bin_of) {
+            size_t slices = slice_count(n, threads);
+            std::vector<std::vector<size_t>> partial(slices, std::vector<size_t>(bin_count + 1, 0));
+            parallel_slices(n, slices, [&](size_t s, size_t begin, size_t end) {
+                size_t* counts = partial[s].data();
+                for (size_t i = begin; i < end; ++i) ++counts[bin_of(i)];
+            });
+
+            for (size_t s = 1; s < slices; ++s) {
+                for (size_t bin = 0; bin <= bin_count; ++bin) partial[0][bin] += partial[s][bin];
+            }
+            return std::move(partial[0]);
+        }
+    }
+
+    binning::binning(size_t bins, double low, double high) : uniform(true) {
+        if (bins == 0) {
+            throw std::invalid_argument("A histogram needs at least one bin");
+        }
+        if (!(low < high) || !std::isfinite(low) || !std::isfinite(high)) {
+            throw std::invalid_argument("The range of a histogram must be finite and increasing");
+        }
+
+        edges.resize(bins + 1);
+        for (size_t i = 0; i <= bins; ++i) {
+            edges[i] = low + (high - low) * static_cast<double>(i) / static_cast<double>(bins);
+        }
+        scale = static_cast<double>(bins) / (high - low);
+    }
+
+    binning::binning(std::vector<double> bin_edges) : edges(std::move(bin_edges)) {
+        if (edges.size() < 2) {
+            throw std::invalid_argument("A histogram needs at least two edges");
+        }
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (std::isnan(edges[i]) || (i > 0 && !(edges[i - 1] < edges[i]))) {
+                throw std::invalid_argument("The edges of a histogram must be increasing");
+            }
+        }
+    }
+
+    binning binning::of_range(size_t bins, double low, double high) {
+        if (low == high) return binning(bins, low - 0.5, high + 0.5);
+        return binning(bins, low, high);
+    }
+
+    histogram_result compute_histogram(const double* values, size_t n, const binning& bins, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.histogram");
+        std::vector<size_t> counts = count_bins(n, bins.size(), threads, [values, &bins](size_t i) {
+            return bins.bin_of(values[i]);
+        });
+
+        histogram_result result;
+        result.edges = bins.bin_edges();
+        result.counts.assign(counts.begin(), counts.end() - 1);
+        for (size_t i = 0; i < n; ++i) result.missing += std::isnan(values[i]) ? 1 : 0;
+        return result;
+    }
+
+    histogram_2d_result compute_histogram_2d(const double* x, const double* y, size_t n, const binning& x_bins,
+                                             const binning& y_bins, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.histogram_2d");
+        size_t columns = y_bins.size(), cells = x_bins.size() * columns;
+        std::vector<size_t> counts = count_bins(n, cells, threads, [&, cells](size_t i) {
+            size_t bx = x_bins.bin_of(x[i]), by = y_bins.bin_of(y[i]);
+            return bx == x_bins.size() || by == columns ? cells : bx * columns + by;
+        });
+
+        histogram_2d_result result;
+        result.x_edges = x_bins.bin_edges();
+        result.y_edges = y_bins.bin_edges();
+        result.counts.assign(counts.begin(), counts.end() - 1);
+        for (size_t i = 0; i < n; ++i) result.missing += std::isnan(x[i]) || std::isnan(y[i]) ? 1 : 0;
+        return result;
+    }
+
+    double approximate_quantile(const histogram_result& histogram, double q) {
+        if (!(q >= 0.0 && q <= 1.0)) {
+            throw std::invalid_argument("Quantiles must be between 0 and 1");
+        }
+
+        size_t total = 0;
+        for (size_t count : histogram.counts) total += count;
+        if (total == 0) {
+            throw std::runtime_error("Cannot compute quantiles of an empty histogram");
+        }
+
+        // the bin holding the value of rank q * total, interpolated inside the bin
+        double rank = q * static_cast<double>(total);
+        double below = 0.0;
+        for (size_t bin = 0; bin < histogram.counts.size(); ++bin) {
+            auto count = static_cast<double>(histogram.counts[bin]);
+            if (count > 0 && below + count >= rank) {
+                double low = histogram.edges[bin], high = histogram.edges[bin + 1];
+                return low + (high - low) * (rank - below) / count;
+            }
+            below += count;
+        }
+        return histogram.edges.back();
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace scitool {
+
+    // counts[i] is the number of values in [edges[i], edges[i + 1]), the last bin also holding edges.back().
+    // As in NumPy, values outside of the edges are not counted; missing values (NaN) are counted apart
+    struct histogram_result {
+        std::vector<double> edges;
+        std::vector<size_t> counts;
+        size_t missing = 0;
+    };
+
+    // counts[i * (y_edges.size() - 1) + j] is the number of (x, y) pairs in bin i of x and bin j of y, pairs
+    // with a missing value are counted apart
+    struct histogram_2d_result {
+        std::vector<double> x_edges;
+        std::vector<double> y_edges;
+        std::vector<size_t> counts;
+        size_t missing = 0;
+    };
+
+    // The bins of one axis: `bins` bins of the same width from low to high, or the bins between increasing edges
+    class binning {
+    public:
+        binning(size_t bins, double low, double high);
+        explicit binning(std::vector<double> edges);
+
+        // equal bounds become a bin of width 1 around the value, as in NumPy
+        static binning of_range(size_t bins, double low, double high);
+
+        size_t size() const {
+            return edges.size() - 1;
+        }
+
+        const std::vector<double>& bin_edges() const {
+            return edges;
+        }
+
+        // the bin of value, size() when it is outside of the edges or NaN. Uniform bins are found with one
+        // multiplication, custom edges with a branchless binary search
+        size_t bin_of(double value) const {
+            if (!(value >= edges.front() && value <= edges.back())) return size();
+            if (uniform) {
+                auto bin = static_cast<size_t>((value - edges.front()) * scale);
+                // the product can round across an edge, the edges are what the bins are compared to
+                if (bin >= size()) bin = size() - 1;
+                if (value < edges[bin]) --bin;
+                else if (bin + 1 < size() && value >= edges[bin + 1]) ++bin;
+                return bin;
+            }
+
+            const double* base = edges.data();
+            size_t length = edges.size();
+            while (length > 1) {
+                size_t half = length / 2;
+                base = base[half] <= value ? base + half : base;
+                length -= half;
+            }
+            auto bin = static_cast<size_t>(base - edges.data());
+            return bin == size() ? bin - 1 : bin;
+        }
+
+    private:
+        std::vector<double> edges;
+        bool uniform = false;
+        double scale = 0.0;
+    };
+
+    // Histogram of the n values (and joint histogram of the n pairs x[i], y[i]). The values are split between
+    // `threads` threads (0 for one per hardware thread) that count into their own histogram, the partial histograms
+    // are added at the end
+    histogram_result compute_histogram(const double* values, size_t n, const binning& bins, size_t threads = 0);
+    histogram_2d_result compute_histogram_2d(const double* x, const double* y, size_t n, const binning& x_bins,
+                                             const binning& y_bins, size_t threads = 0);
+
+    // Approximate q-quantile (0 <= q <= 1) of the counted values, assuming the values of a bin are spread
+    // uniformly over it. The error is at most the width of the bin holding the quantile
+    double approximate_quantile(const histogram_result& histogram, double q);
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "imputation.hpp"
+#include "linear_interpolator.hpp"
+#include "polynomial_interpolator.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace scitool {
+
+    imputation_method parse_imputation_method(const std::string& name) {
+        if (name == "ffill") return imputation_method::forward_fill;
+        if (name == "bfill") return imputation_method::backward_fill;
+        if (name == "mean") return imputation_method::mean;
+        if (name == "median") return imputation_method::median;
+        throw std::invalid_argument("Unknown imputation method: " + name + " (expected ffill, bfill, mean or median)");
+    }
+
+    interpolation_method parse_interpolation_method(const std::string& name) {
+        if (name == "linear") return interpolation_method::linear;
+        if (name == "polynomial") return interpolation_method::polynomial;
+        throw std::invalid_argument("Unknown interpolation method: " + name + " (expected linear or polynomial)");
+    }
+
+    filled_cells impute_gaps(const double* values, size_t n, imputation_method method, double fill_value) {
+        SCITOOL_PROFILE_SCOPE("dataset.impute");
+        const double missing = std::numeric_limits<double>::quiet_NaN();
+        filled_cells cells;
+
+        if (method == imputation_method::backward_fill) {
+            double next = missing;
+            for (size_t row = n; row-- > 0;) {
+                if (!std::isnan(values[row])) {
+                    next = values[row];
+                    ++cells.present;
+                } else if (!std::isnan(next)) {
+                    cells.rows.push_back(row);
+                    cells.values.push_back(next);
+                }
+            }
+            std::reverse(cells.rows.begin(), cells.rows.end());
+            std::reverse(cells.values.begin(), cells.values.end());
+            return cells;
+        }
+
+        double last = method == imputation_method::forward_fill ? missing : fill_value;
+        for (size_t row = 0; row < n; ++row) {
+            if (!std::isnan(values[row])) {
+                if (method == imputation_method::forward_fill) last = values[row];
+                ++cells.present;
+            } else if (!std::isnan(last)) {
+                cells.rows.push_back(row);
+                cells.values.push_back(last);
+            }
+        }
+        return cells;
+    }
+
+    knot_table averaged_knots(const double* x, const double* y, const std::vector<size_t>& x_order) {
+        knot_table knots;
+        size_t run = 0;
+        for (size_t row : x_order) {
+            if (std::isnan(x[row])) break;
+            if (std::isnan(y[row])) continue;
+            if (!knots.x.empty() && knots.x.back() == x[row]) {
+                knots.y.back() += (y[row] - knots.y.back()) / static_cast<double>(++run);
+            } else {
+                knots.x.push_back(x[row]);
+                knots.y.push_back(y[row]);
+                run = 1;
+            }
+        }
+        return knots;
+    }
+
+    filled_cells interpolate_gaps(const double* x, const double* y, const std::vector<size_t>& x_order,
+                                  interpolation_method method) {
+        SCITOOL_PROFILE_SCOPE("dataset.interpolate_missing");
+        filled_cells cells;
+        for (size_t row = 0; row < x_order.size(); ++row) {
+            if (!std::isnan(y[row])) ++cells.present;
+        }
+
+        // the queries are collected in the order of x too
+        std::vector<double> queries;
+        for (size_t row : x_order) {
+            if (std::isnan(x[row])) break;
+            if (std::isnan(y[row])) {
+                cells.rows.push_back(row);
+                queries.push_back(x[row]);
+            }
+        }
+        if (cells.rows.empty()) return cells;
+        knot_table knots = averaged_knots(x, y, x_order);
+
+        // the interpolators do not extrapolate, the queries outside of the knots stay missing
+        size_t first = 0, last = 0;
+        if (!knots.x.empty()) {
+            first = static_cast<size_t>(std::lower_bound(queries.begin(), queries.end(), knots.x.front()) - queries.begin());
+            last = static_cast<size_t>(std::upper_bound(queries.begin(), queries.end(), knots.x.back()) - queries.begin());
+        }
+        cells.rows.erase(cells.rows.begin() + static_cast<std::ptrdiff_t>(last), cells.rows.end());
+        cells.rows.erase(cells.rows.begin(), cells.rows.begin() + static_cast<std::ptrdiff_t>(first));
+        if (cells.rows.empty()) return cells;
+        cells.values.resize(cells.rows.size());
+
+        // a single knot makes no interpolator, the queries left sit exactly on it
+        if (knots.x.size() == 1) {
+            std::fill(cells.values.begin(), cells.values.end(), knots.y.front());
+            return cells;
+        }
+        std::unique_ptr<interpolator> model;
+        if (method == interpolation_method::linear) {
+            model = std::make_unique<linear_interpolator>(std::move(knots.x), std::move(knots.y));
+        } else {
+            model = std::make_unique<polynomial_interpolator>(std::move(knots.x), std::move(knots.y));
+        }
+        model->evaluate(queries.data() + first, cells.values.data(), cells.values.size());
+        return cells;
+    }
+}
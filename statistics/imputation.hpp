@@ -0,0 +1,50 @@
+#ifndef IMPUTATION_HPP
+#define IMPUTATION_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace scitool {
+
+    // Fills of the missing values of a column from the column itself: the last value before (forward_fill) or the
+    // next value after (backward_fill) in row order, or the mean or the median of the non-missing values
+    enum class imputation_method { forward_fill, backward_fill, mean, median };
+
+    // Interpolators the missing values of a column can be read from, as a function of another column
+    // (see interpolation/). A polynomial goes through every knot, so it only suits small tables
+    enum class interpolation_method { linear, polynomial };
+
+    // "ffill", "bfill", "mean" or "median"
+    imputation_method parse_imputation_method(const std::string& name);
+    // "linear" or "polynomial"
+    interpolation_method parse_interpolation_method(const std::string& name);
+
+    // The cells filled in a column (rows[i] receiving values[i]) and the number of values it had before
+    struct filled_cells {
+        std::vector<size_t> rows;
+        std::vector<double> values;
+        size_t present = 0;
+    };
+
+    // Values for the missing cells (NaN) of the n values. fill_value is the value of the mean and median methods;
+    // a forward (backward) fill leaves the cells before the first (after the last) value missing
+    filled_cells impute_gaps(const double* values, size_t n, imputation_method method, double fill_value = 0.0);
+
+    // Knots of y as a function of x from the rows where both are present, sorted by x with the y values of equal x
+    // averaged into one knot, so that any interpolator can be built on them. x_order holds the rows by increasing x
+    // with the missing x last (as dataset::sort_by), so the knots are collected already sorted
+    struct knot_table {
+        std::vector<double> x;
+        std::vector<double> y;
+    };
+    knot_table averaged_knots(const double* x, const double* y, const std::vector<size_t>& x_order);
+
+    // Values for the missing cells of y, interpolated at their x from the averaged_knots of the column. Rows whose x
+    // is missing or outside of the knots are left missing, the others are interpolated in one evaluate call (with a
+    // single knot, the rows at its x get its value)
+    filled_cells interpolate_gaps(const double* x, const double* y, const std::vector<size_t>& x_order,
+                                  interpolation_method method);
+}
+
+#endif
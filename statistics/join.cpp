@@ -0,0 +1,177 @@
+#include "join.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include "random.hpp"
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        // a partition of the build side should fit in the L2 cache, with its hashes, rows and table
+        constexpr size_t partition_bytes = size_t(256) << 10;
+        constexpr unsigned max_partition_bits = 12;
+
+        // rows of one side grouped by partition, partition p being [offsets[p], offsets[p + 1])
+        struct partitioned_rows {
+            std::vector<std::uint64_t> hashes;
+            std::vector<size_t> rows;
+            std::vector<size_t> offsets;
+        };
+
+        std::vector<std::uint64_t> hash_keys(const join_keys& side, size_t threads) {
+            std::vector<std::uint64_t> hashes(side.rows);
+            parallel_slices(side.rows, slice_count(side.rows, threads), [&](size_t, size_t begin, size_t end) {
+                for (size_t row = begin; row < end; ++row) {
+                    std::uint64_t hash = 0;
+                    for (const auto& column : side.keys) hash = splitmix64(hash ^ column[row]);
+                    hashes[row] = hash;
+                }
+            });
+            return hashes;
+        }
+
+        // Scatters the rows that have keys to their partition (the top bits of their hash). As in radix_sort,
+        // every slice of rows counts its partitions and then writes at its own offsets, so rows keep their order
+        partitioned_rows partition(const join_keys& side, const std::vector<std::uint64_t>& hashes, unsigned bits, size_t threads) {
+            size_t partitions = size_t(1) << bits;
+            auto partition_of = [bits](std::uint64_t hash) {
+                return bits == 0 ? size_t(0) : static_cast<size_t>(hash >> (64 - bits));
+            };
+
+            size_t slices = slice_count(side.rows, threads);
+            std::vector<size_t> counts(slices * partitions, 0);
+            parallel_slices(side.rows, slices, [&](size_t s, size_t begin, size_t end) {
+                size_t* count = counts.data() + s * partitions;
+                for (size_t row = begin; row < end; ++row) {
+                    if (!side.missing[row]) ++count[partition_of(hashes[row])];
+                }
+            });
+
+            partitioned_rows result;
+            result.offsets.resize(partitions + 1);
+            size_t position = 0;
+            for (size_t p = 0; p < partitions; ++p) {
+                result.offsets[p] = position;
+                for (size_t s = 0; s < slices; ++s) {
+                    size_t count = counts[s * partitions + p];
+                    counts[s * partitions + p] = position;
+                    position += count;
+                }
+            }
+            result.offsets[partitions] = position;
+
+            result.hashes.resize(position);
+            result.rows.resize(position);
+            parallel_slices(side.rows, slices, [&](size_t s, size_t begin, size_t end) {
+                size_t* next = counts.data() + s * partitions;
+                for (size_t row = begin; row < end; ++row) {
+                    if (side.missing[row]) continue;
+                    size_t target = next[partition_of(hashes[row])]++;
+                    result.hashes[target] = hashes[row];
+                    result.rows[target] = row;
+                }
+            });
+            return result;
+        }
+
+        unsigned partition_bits(size_t build_rows, size_t threads) {
+            // hash, row, table head and chain link per build row
+            size_t bytes = build_rows * 4 * sizeof(size_t);
+            size_t wanted = std::max(bytes / partition_bytes, threads > 1 ? threads * 4 : size_t(1));
+            unsigned bits = 0;
+            while (bits < max_partition_bits && (size_t(1) << bits) < wanted) ++bits;
+            return bits;
+        }
+    }
+
+    join_kind parse_join_kind(const std::string& name) {
+        if (name == "inner") return join_kind::inner;
+        if (name == "left") return join_kind::left;
+        throw std::invalid_argument("Unknown join kind: " + name + " (expected inner or left)");
+    }
+
+    join_result hash_join(const join_keys& left, const join_keys& right, join_kind kind, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.hash_join");
+        if (left.keys.size() != right.keys.size() || left.keys.empty()) {
+            throw std::invalid_argument("Both sides of a join need the same number of key columns");
+        }
+        if (threads == 0) threads = default_thread_count();
+
+        unsigned bits = partition_bits(right.rows, threads);
+        partitioned_rows build = partition(right, hash_keys(right, threads), bits, threads);
+        partitioned_rows probe = partition(left, hash_keys(left, threads), bits, threads);
+
+        auto same_keys = [&left, &right](size_t left_row, size_t right_row) {
+            for (size_t c = 0; c < left.keys.size(); ++c) {
+                if (left.keys[c][left_row] != right.keys[c][right_row]) return false;
+            }
+            return true;
+        };
+
+        // pairs of each partition, in the order of the left rows of the partition
+        size_t partitions = build.offsets.size() - 1;
+        std::vector<std::vector<std::pair<size_t, size_t>>> pairs(partitions);
+        parallel_for(partitions, [&](size_t p) {
+            size_t build_first = build.offsets[p], build_count = build.offsets[p + 1] - build_first;
+            size_t table_size = 1;
+            while (table_size < 2 * build_count) table_size <<= 1;
+
+            // chained table of the build rows, inserted from the last so that chains are in row order
+            std::vector<size_t> heads(table_size, no_match), next(build_count, no_match);
+            for (size_t i = build_count; i-- > 0;) {
+                size_t bucket = build.hashes[build_first + i] & (table_size - 1);
+                next[i] = heads[bucket];
+                heads[bucket] = i;
+            }
+
+            auto& out = pairs[p];
+            for (size_t j = probe.offsets[p]; j < probe.offsets[p + 1]; ++j) {
+                std::uint64_t hash = probe.hashes[j];
+                size_t left_row = probe.rows[j];
+                bool matched = false;
+                for (size_t i = heads[hash & (table_size - 1)]; i != no_match; i = next[i]) {
+                    size_t right_row = build.rows[build_first + i];
+                    if (build.hashes[build_first + i] == hash && same_keys(left_row, right_row)) {
+                        out.emplace_back(left_row, right_row);
+                        matched = true;
+                    }
+                }
+                if (!matched && kind == join_kind::left) out.emplace_back(left_row, no_match);
+            }
+        }, threads);
+
+        // the pairs are put back in the order of the left rows: every left row falls in a single partition,
+        // so counting the pairs per left row is enough to place them
+        std::vector<size_t> first_pair(left.rows + 1, 0);
+        for (const auto& out : pairs) {
+            for (const auto& pair : out) ++first_pair[pair.first + 1];
+        }
+        if (kind == join_kind::left) {
+            // left rows with a missing key were not partitioned, they have no match
+            for (size_t row = 0; row < left.rows; ++row) {
+                if (left.missing[row]) ++first_pair[row + 1];
+            }
+        }
+        for (size_t row = 0; row < left.rows; ++row) first_pair[row + 1] += first_pair[row];
+
+        join_result result;
+        result.left_rows.resize(first_pair[left.rows]);
+        result.right_rows.resize(first_pair[left.rows]);
+        for (const auto& out : pairs) {
+            for (const auto& pair : out) {
+                size_t target = first_pair[pair.first]++;
+                result.left_rows[target] = pair.first;
+                result.right_rows[target] = pair.second;
+            }
+        }
+        if (kind == join_kind::left) {
+            for (size_t row = 0; row < left.rows; ++row) {
+                if (!left.missing[row]) continue;
+                size_t target = first_pair[row]++;
+                result.left_rows[target] = row;
+                result.right_rows[target] = no_match;
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef JOIN_HPP
+#define JOIN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace scitool {
+
+    enum class join_kind { inner, left };
+
+    // "inner" or "left", throws std::invalid_argument otherwise
+    join_kind parse_join_kind(const std::string& name);
+
+    // right row of a left join pair whose left row has no match
+    constexpr size_t no_match = std::numeric_limits<size_t>::max();
+
+    // Key columns of one side of a join: keys[c][row] is the value of key column c in the row, encoded so
+    // that equal values have equal keys on both sides. Rows whose missing flag is set never match
+    struct join_keys {
+        std::vector<std::vector<std::uint64_t>> keys;
+        std::vector<char> missing;
+        size_t rows = 0;
+    };
+
+    // Matching rows of a join, ordered by left row and then by right row
+    struct join_result {
+        std::vector<size_t> left_rows;
+        std::vector<size_t> right_rows;
+    };
+
+    // Equi-join of the rows of left and right on all of their key columns. Both sides are radix partitioned on
+    // the hash of their keys, with enough partitions that a partition of right (the build side) fits in the
+    // cache, then the partitions are joined in parallel on `threads` threads (0 for one per hardware thread):
+    // a hash table is built on the right partition and probed with the left one. A left join keeps every left
+    // row, with no_match as right row when nothing matches
+    join_result hash_join(const join_keys& left, const join_keys& right, join_kind kind, size_t threads = 0);
+}
+
+#endif
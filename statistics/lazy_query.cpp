@@ -0,0 +1,513 @@
+#include "lazy_query.hpp"
+#include "dataset.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        // rows per chunk: a few columns of a chunk stay in the L2 cache between the steps
+        constexpr size_t chunk_rows = 8192;
+
+        // count, sum, mean and sum of squared deviations of the values of one column in a chunk, merged
+        // between chunks with the update of Chan et al. so that no second pass over the data is needed
+        struct moments {
+            size_t n = 0;
+            double sum = 0.0;
+            double mean = 0.0;
+            double m2 = 0.0;
+            double min = std::numeric_limits<double>::infinity();
+            double max = -std::numeric_limits<double>::infinity();
+
+            void merge(const moments& other) {
+                if (other.n == 0) return;
+                if (n == 0) {
+                    *this = other;
+                    return;
+                }
+                double delta = other.mean - mean;
+                double total = static_cast<double>(n + other.n);
+                mean += delta * static_cast<double>(other.n) / total;
+                m2 += other.m2 + delta * delta * static_cast<double>(n) * static_cast<double>(other.n) / total;
+                n += other.n;
+                sum += other.sum;
+                min = std::min(min, other.min);
+                max = std::max(max, other.max);
+            }
+        };
+
+        // the same for the rows where both columns of a pair have a value
+        struct co_moments {
+            size_t n = 0;
+            double mean_x = 0.0, mean_y = 0.0;
+            double m_xx = 0.0, m_yy = 0.0, m_xy = 0.0;
+
+            void merge(const co_moments& other) {
+                if (other.n == 0) return;
+                if (n == 0) {
+                    *this = other;
+                    return;
+                }
+                double total = static_cast<double>(n + other.n);
+                double weight = static_cast<double>(n) * static_cast<double>(other.n) / total;
+                double dx = other.mean_x - mean_x, dy = other.mean_y - mean_y;
+                mean_x += dx * static_cast<double>(other.n) / total;
+                mean_y += dy * static_cast<double>(other.n) / total;
+                m_xx += other.m_xx + dx * dx * weight;
+                m_yy += other.m_yy + dy * dy * weight;
+                m_xy += other.m_xy + dx * dy * weight;
+                n += other.n;
+            }
+        };
+
+        moments chunk_moments(const double* values, size_t size) {
+            moments result;
+            for (size_t i = 0; i < size; ++i) {
+                if (std::isnan(values[i])) continue;
+                ++result.n;
+                result.sum += values[i];
+                result.min = std::min(result.min, values[i]);
+                result.max = std::max(result.max, values[i]);
+            }
+            if (result.n == 0) return result;
+
+            result.mean = result.sum / static_cast<double>(result.n);
+            for (size_t i = 0; i < size; ++i) {
+                if (std::isnan(values[i])) continue;
+                double difference = values[i] - result.mean;
+                result.m2 += difference * difference;
+            }
+            return result;
+        }
+
+        // Sums of the deviations from shift_x and shift_y (close to the means, e.g. the means of the columns in the
+        // chunk) turned into moments about the means of the pairs, in a single pass. With shifts near the means
+        // the subtraction of the squared mean deviation loses no significant digits
+        co_moments chunk_co_moments(const double* x, const double* y, const char* valid_x, const char* valid_y, size_t size,
+                                    double shift_x, double shift_y) {
+            size_t n = 0;
+            double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_yy = 0.0, sum_xy = 0.0;
+            for (size_t i = 0; i < size; ++i) {
+                if (!(valid_x[i] & valid_y[i])) continue;
+                double dx = x[i] - shift_x, dy = y[i] - shift_y;
+                ++n;
+                sum_x += dx;
+                sum_y += dy;
+                sum_xx += dx * dx;
+                sum_yy += dy * dy;
+                sum_xy += dx * dy;
+            }
+
+            co_moments result;
+            result.n = n;
+            if (n == 0) return result;
+            double count = static_cast<double>(n);
+            result.mean_x = shift_x + sum_x / count;
+            result.mean_y = shift_y + sum_y / count;
+            result.m_xx = std::max(0.0, sum_xx - sum_x * sum_x / count);
+            result.m_yy = std::max(0.0, sum_yy - sum_y * sum_y / count);
+            result.m_xy = sum_xy - sum_x * sum_y / count;
+            return result;
+        }
+
+        // the pair moments of two columns with a value in every row, from their own moments: only the sum of the
+        // products of the deviations is left to compute
+        co_moments complete_co_moments(const double* x, const double* y, size_t size, const moments& moments_x, const moments& moments_y) {
+            double sum_xy = 0.0;
+            if (x == y) {
+                sum_xy = moments_x.m2;
+            } else {
+                for (size_t i = 0; i < size; ++i) sum_xy += (x[i] - moments_x.mean) * (y[i] - moments_y.mean);
+            }
+            return co_moments{size, moments_x.mean, moments_y.mean, moments_x.m2, moments_y.m2, sum_xy};
+        }
+
+        double median_of(std::vector<double>& values) {
+            if (values.empty()) {
+                throw std::runtime_error("Cannot compute median with all values missing");
+            }
+            size_t mid = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid), values.end());
+            double upper = values[mid];
+            if (values.size() % 2 != 0) return upper;
+            double lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid));
+            return (lower + upper) / 2.0;
+        }
+    }
+
+    aggregate parse_aggregate(const std::string& name) {
+        if (name == "count") return aggregate::count;
+        if (name == "sum") return aggregate::sum;
+        if (name == "mean") return aggregate::mean;
+        if (name == "variance") return aggregate::variance;
+        if (name == "std_dev") return aggregate::std_dev;
+        if (name == "min") return aggregate::min;
+        if (name == "max") return aggregate::max;
+        if (name == "median") return aggregate::median;
+        throw std::invalid_argument("Unknown aggregate: " + name);
+    }
+
+    std::string aggregate_name(aggregate statistic) {
+        switch (statistic) {
+            case aggregate::count: return "count";
+            case aggregate::sum: return "sum";
+            case aggregate::mean: return "mean";
+            case aggregate::variance: return "variance";
+            case aggregate::std_dev: return "std_dev";
+            case aggregate::min: return "min";
+            case aggregate::max: return "max";
+            case aggregate::median: return "median";
+        }
+        return "";
+    }
+
+    double query_result::get(const std::string& column, aggregate statistic) const {
+        for (size_t i = 0; i < aggregations.size(); ++i) {
+            if (aggregations[i].column == column && aggregations[i].statistic == statistic) return values[i];
+        }
+        throw std::out_of_range("The query has no " + aggregate_name(statistic) + " of column '" + column + "'");
+    }
+
+    std::function<double(double)> named_transform(const std::string& name) {
+        if (name == "log") return [](double value) { return std::log(value); };
+        if (name == "log10") return [](double value) { return std::log10(value); };
+        if (name == "log1p") return [](double value) { return std::log1p(value); };
+        if (name == "exp") return [](double value) { return std::exp(value); };
+        if (name == "sqrt") return [](double value) { return std::sqrt(value); };
+        if (name == "abs") return [](double value) { return std::abs(value); };
+        if (name == "square") return [](double value) { return value * value; };
+        throw std::invalid_argument("Unknown transform: " + name);
+    }
+
+    std::function<bool(double)> comparison(const std::string& op, double threshold) {
+        if (op == "<") return [threshold](double value) { return value < threshold; };
+        if (op == "<=") return [threshold](double value) { return value <= threshold; };
+        if (op == ">") return [threshold](double value) { return value > threshold; };
+        if (op == ">=") return [threshold](double value) { return value >= threshold; };
+        if (op == "==") return [threshold](double value) { return value == threshold; };
+        if (op == "!=") return [threshold](double value) { return value != threshold; };
+        throw std::invalid_argument("Unknown comparison: " + op);
+    }
+
+    lazy_query::lazy_query(dataset& source) : source(&source) {}
+
+    lazy_query lazy_query::map(const std::string& column_name, std::function<double(double)> func) const {
+        if (source->is_categorical(column_name)) {
+            throw std::invalid_argument("Column '" + column_name + "' is categorical and cannot be mapped with a double-to-double function.");
+        }
+        lazy_query query = *this;
+        query.steps.push_back(std::make_shared<const step>(step{true, source->column_index(column_name), std::move(func), nullptr}));
+        return query;
+    }
+
+    lazy_query lazy_query::filter(const std::string& column_name, std::function<bool(double)> predicate) const {
+        lazy_query query = *this;
+        query.steps.push_back(std::make_shared<const step>(step{false, source->column_index(column_name), nullptr, std::move(predicate)}));
+        return query;
+    }
+
+    size_t lazy_query::chunk_count() const {
+        return (source->row_count + chunk_rows - 1) / chunk_rows;
+    }
+
+    template <typename Visit>
+    void lazy_query::scan(const std::vector<int>& needed_columns, size_t threads, Visit visit) const {
+        SCITOOL_PROFILE_SCOPE("dataset.lazy_scan");
+        const auto& columns = source->column_values;
+        size_t rows = source->row_count;
+
+        // the mapped columns are copied to a buffer of the chunk, the others are read in place
+        std::vector<char> used(columns.size(), false), mapped(columns.size(), false);
+        for (int col : needed_columns) used[col] = true;
+        for (const auto& current : steps) {
+            used[current->column] = true;
+            if (current->is_map) mapped[current->column] = true;
+        }
+        SCITOOL_PROFILE_COUNT("dataset.rows_scanned", rows);
+
+        parallel_for(chunk_count(), [&](size_t index) {
+            chunk current{index, index * chunk_rows, std::min(chunk_rows, rows - index * chunk_rows), {}, {}};
+            current.values.assign(columns.size(), nullptr);
+            current.keep.assign(current.size, true);
+
+            std::vector<std::vector<double>> buffers(columns.size());
+            for (size_t col = 0; col < columns.size(); ++col) {
+                if (!used[col] || columns[col].categorical) continue;
+                const double* values = columns[col].numbers.data() + current.first;
+                if (mapped[col]) {
+                    buffers[col].assign(values, values + current.size);
+                    values = buffers[col].data();
+                }
+                current.values[col] = values;
+            }
+
+            for (const auto& s : steps) {
+                if (s->is_map) {
+                    double* values = buffers[s->column].data();
+                    for (size_t i = 0; i < current.size; ++i) {
+                        if (current.keep[i] && !std::isnan(values[i])) values[i] = s->transform(values[i]);
+                    }
+                    continue;
+                }
+
+                // categorical columns have no numerical value, a filter on them keeps no row
+                const double* values = current.values[s->column];
+                for (size_t i = 0; i < current.size; ++i) {
+                    if (current.keep[i]) current.keep[i] = values && !std::isnan(values[i]) && s->predicate(values[i]);
+                }
+            }
+
+            visit(static_cast<const chunk&>(current));
+        }, threads);
+    }
+
+    query_result lazy_query::agg(const std::vector<aggregation>& aggregations, const std::vector<std::string>& correlation_columns,
+                                 size_t threads) const {
+        SCITOOL_PROFILE_SCOPE("dataset.lazy_agg");
+        // every column is summarized once, whatever the number of its aggregations
+        std::vector<int> summarized, correlated, needed;
+        std::vector<char> needs_median;
+        auto numerical_index = [this](const std::string& name) {
+            if (source->is_categorical(name)) {
+                throw std::invalid_argument("Column '" + name + "' is not a numerical column");
+            }
+            return source->column_index(name);
+        };
+        for (const auto& requested : aggregations) {
+            int col = numerical_index(requested.column);
+            auto position = std::find(summarized.begin(), summarized.end(), col) - summarized.begin();
+            if (static_cast<size_t>(position) == summarized.size()) {
+                summarized.push_back(col);
+                needs_median.push_back(false);
+            }
+            if (requested.statistic == aggregate::median) needs_median[static_cast<size_t>(position)] = true;
+        }
+        for (const auto& name : correlation_columns) correlated.push_back(numerical_index(name));
+        needed = summarized;
+        needed.insert(needed.end(), correlated.begin(), correlated.end());
+
+        // partial results of every chunk, merged in chunk order so that the results do not depend on the threads
+        size_t chunks = chunk_count(), pairs = correlated.size() * (correlated.size() + 1) / 2;
+        std::vector<size_t> kept(chunks, 0);
+        std::vector<std::vector<moments>> column_moments(chunks);
+        std::vector<std::vector<moments>> correlated_moments(chunks);
+        std::vector<std::vector<co_moments>> pair_moments(chunks);
+        std::vector<std::vector<std::vector<double>>> median_values(chunks);
+
+        scan(needed, threads, [&](const chunk& current) {
+            // the kept rows of the needed columns are packed, so that the aggregations only skip missing values
+            std::vector<size_t> rows;
+            for (size_t i = 0; i < current.size; ++i) {
+                if (current.keep[i]) rows.push_back(i);
+            }
+            size_t size = rows.size();
+            kept[current.index] = size;
+            std::vector<std::vector<double>> packed(current.values.size());
+            auto values_of = [&](int col) {
+                const double* values = current.values[col];
+                if (size == current.size) return values;
+                if (packed[col].empty()) {
+                    packed[col].resize(size);
+                    for (size_t i = 0; i < size; ++i) packed[col][i] = values[rows[i]];
+                }
+                return static_cast<const double*>(packed[col].data());
+            };
+
+            auto& partial = column_moments[current.index];
+            auto& medians = median_values[current.index];
+            medians.resize(summarized.size());
+            for (size_t c = 0; c < summarized.size(); ++c) {
+                const double* values = values_of(summarized[c]);
+                partial.push_back(chunk_moments(values, size));
+                if (!needs_median[c]) continue;
+                for (size_t i = 0; i < size; ++i) {
+                    if (!std::isnan(values[i])) medians[c].push_back(values[i]);
+                }
+            }
+
+            // the rows of the chunk where each correlated column has a value, and the means used as shifts
+            auto& partial_pairs = pair_moments[current.index];
+            partial_pairs.reserve(pairs);
+            std::vector<const double*> columns;
+            std::vector<std::vector<char>> valid(correlated.size(), std::vector<char>(size));
+            for (size_t i = 0; i < correlated.size(); ++i) {
+                columns.push_back(values_of(correlated[i]));
+                for (size_t row = 0; row < size; ++row) valid[i][row] = !std::isnan(columns[i][row]);
+                correlated_moments[current.index].push_back(chunk_moments(columns[i], size));
+            }
+            const auto& shifts = correlated_moments[current.index];
+            for (size_t i = 0; i < correlated.size(); ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    if (shifts[i].n == size && shifts[j].n == size) {
+                        partial_pairs.push_back(complete_co_moments(columns[i], columns[j], size, shifts[i], shifts[j]));
+                        continue;
+                    }
+                    partial_pairs.push_back(chunk_co_moments(columns[i], columns[j], valid[i].data(), valid[j].data(), size,
+                                                             shifts[i].mean, shifts[j].mean));
+                }
+            }
+        });
+
+        query_result result;
+        result.aggregations = aggregations;
+        result.correlation_columns = correlation_columns;
+        for (size_t count : kept) result.rows += count;
+
+        std::vector<moments> totals(summarized.size());
+        std::vector<std::vector<double>> medians(summarized.size());
+        for (size_t index = 0; index < chunks; ++index) {
+            for (size_t c = 0; c < summarized.size(); ++c) {
+                totals[c].merge(column_moments[index][c]);
+                auto& values = median_values[index][c];
+                medians[c].insert(medians[c].end(), values.begin(), values.end());
+            }
+        }
+
+        for (const auto& requested : aggregations) {
+            int col = source->column_index(requested.column);
+            auto c = static_cast<size_t>(std::find(summarized.begin(), summarized.end(), col) - summarized.begin());
+            const moments& total = totals[c];
+            if (total.n == 0 && requested.statistic != aggregate::count && requested.statistic != aggregate::sum) {
+                throw std::runtime_error("Cannot compute " + aggregate_name(requested.statistic) + " with all values missing");
+            }
+            double n = static_cast<double>(total.n);
+            switch (requested.statistic) {
+                case aggregate::count: result.values.push_back(n); break;
+                case aggregate::sum: result.values.push_back(total.sum); break;
+                case aggregate::mean: result.values.push_back(total.sum / n); break;
+                case aggregate::variance: result.values.push_back(total.m2 / n); break;
+                case aggregate::std_dev: result.values.push_back(std::sqrt(total.m2 / n)); break;
+                case aggregate::min: result.values.push_back(total.min); break;
+                case aggregate::max: result.values.push_back(total.max); break;
+                case aggregate::median: result.values.push_back(median_of(medians[c])); break;
+            }
+        }
+
+        if (correlated.empty()) return result;
+
+        // as in dataset::get_correlation_matrix, the deviations of a pair are taken from the mean of each column
+        // over all of its values, and summed over the rows where both have a value
+        std::vector<moments> correlated_totals(correlated.size());
+        std::vector<co_moments> pair_totals(pairs);
+        for (size_t index = 0; index < chunks; ++index) {
+            for (size_t i = 0; i < correlated.size(); ++i) correlated_totals[i].merge(correlated_moments[index][i]);
+            for (size_t p = 0; p < pairs; ++p) pair_totals[p].merge(pair_moments[index][p]);
+        }
+
+        std::vector<double> means;
+        for (const auto& total : correlated_totals) {
+            if (total.n == 0) {
+                throw std::runtime_error("Cannot compute mean with all values missing");
+            }
+            means.push_back(total.sum / static_cast<double>(total.n));
+        }
+
+        result.correlation.resize(static_cast<Eigen::Index>(correlated.size()), static_cast<Eigen::Index>(correlated.size()));
+        result.covariance.resizeLike(result.correlation);
+        size_t p = 0;
+        for (size_t i = 0; i < correlated.size(); ++i) {
+            for (size_t j = 0; j <= i; ++j, ++p) {
+                const co_moments& pair = pair_totals[p];
+                double n = static_cast<double>(pair.n);
+                double dx = pair.mean_x - means[i], dy = pair.mean_y - means[j];
+                double sum_xx = pair.m_xx + n * dx * dx;
+                double sum_yy = pair.m_yy + n * dy * dy;
+                double sum_xy = pair.m_xy + n * dx * dy;
+                auto row = static_cast<Eigen::Index>(i), col = static_cast<Eigen::Index>(j);
+                result.correlation(row, col) = result.correlation(col, row) = sum_xy / (std::sqrt(sum_xx) * std::sqrt(sum_yy));
+                result.covariance(row, col) = result.covariance(col, row) = pair.m_xy / n;
+            }
+        }
+        return result;
+    }
+
+    Eigen::MatrixXd lazy_query::correlation_matrix(std::vector<std::string> column_names, size_t threads) const {
+        if (column_names.empty()) column_names = source->get_numerical_column_names();
+        return agg({}, column_names, threads).correlation;
+    }
+
+    Eigen::MatrixXd lazy_query::covariance_matrix(std::vector<std::string> column_names, size_t threads) const {
+        if (column_names.empty()) column_names = source->get_numerical_column_names();
+        return agg({}, column_names, threads).covariance;
+    }
+
+    scatter_accumulator lazy_query::scatter(const std::vector<std::string>& column_names, size_t threads) const {
+        SCITOOL_PROFILE_SCOPE("dataset.lazy_scatter");
+        std::vector<int> needed;
+        for (const auto& name : column_names) {
+            if (source->is_categorical(name)) {
+                throw std::invalid_argument("Column '" + name + "' is not a numerical column");
+            }
+            needed.push_back(source->column_index(name));
+        }
+
+        // every chunk packs its complete rows in a block, the scatter matrix of a block is a rank update
+        std::vector<scatter_accumulator> partial(chunk_count(), scatter_accumulator(needed.size()));
+        scan(needed, threads, [&](const chunk& current) {
+            std::vector<size_t> rows;
+            for (size_t i = 0; i < current.size; ++i) {
+                bool complete = current.keep[i];
+                for (size_t c = 0; c < needed.size() && complete; ++c) complete = !std::isnan(current.values[needed[c]][i]);
+                if (complete) rows.push_back(i);
+            }
+
+            Eigen::MatrixXd block(static_cast<Eigen::Index>(rows.size()), static_cast<Eigen::Index>(needed.size()));
+            for (size_t c = 0; c < needed.size(); ++c) {
+                const double* values = current.values[needed[c]];
+                for (size_t r = 0; r < rows.size(); ++r) block(static_cast<Eigen::Index>(r), static_cast<Eigen::Index>(c)) = values[rows[r]];
+            }
+            partial[current.index].add(block);
+        });
+
+        scatter_accumulator total(needed.size());
+        for (const auto& chunk_scatter : partial) total.merge(chunk_scatter);
+        return total;
+    }
+
+    regression_result lazy_query::regress(const std::string& target, const std::vector<std::string>& predictors, size_t threads) const {
+        std::vector<std::string> variables = predictors;
+        variables.push_back(target);
+        return fit_least_squares(scatter(variables, threads), predictors);
+    }
+
+    size_t lazy_query::count(size_t threads) const {
+        return agg({}, {}, threads).rows;
+    }
+
+    void lazy_query::collect(size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.lazy_collect");
+        auto& columns = source->column_values;
+        std::vector<int> mapped;
+        bool filtered = false;
+        for (const auto& current : steps) {
+            if (!current->is_map) filtered = true;
+            else if (std::find(mapped.begin(), mapped.end(), current->column) == mapped.end()) mapped.push_back(current->column);
+        }
+
+        // every chunk writes back its own rows, so the tasks never write the same values
+        std::vector<char> keep(filtered ? source->row_count : 0);
+        try {
+            scan({}, threads, [&](const chunk& current) {
+                for (int col : mapped) {
+                    std::copy(current.values[col], current.values[col] + current.size, columns[col].numbers.data() + current.first);
+                }
+                if (filtered) std::copy(current.keep.begin(), current.keep.end(), keep.begin() + static_cast<std::ptrdiff_t>(current.first));
+            });
+        } catch (...) {
+            // the chunks mapped before the failure are kept, the cached statistics must not be
+            for (int col : mapped) source->reset_values(static_cast<size_t>(col));
+            throw;
+        }
+
+        for (int col : mapped) {
+            // the mapped values are doubles, even where the column held integers
+            columns[col].integral = false;
+            source->reset_values(static_cast<size_t>(col));
+        }
+        if (filtered) source->compact_rows(keep);
+    }
+}
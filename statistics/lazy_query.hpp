@@ -0,0 +1,112 @@
+#ifndef LAZY_QUERY_HPP
+#define LAZY_QUERY_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Eigen/Core"
+#include "regression.hpp"
+
+namespace scitool {
+
+    class dataset;
+
+    enum class aggregate { count, sum, mean, variance, std_dev, min, max, median };
+
+    // "count", "sum", "mean", "variance", "std_dev", "min", "max" or "median", throws std::invalid_argument otherwise
+    aggregate parse_aggregate(const std::string& name);
+    std::string aggregate_name(aggregate statistic);
+
+    struct aggregation {
+        std::string column;
+        aggregate statistic;
+    };
+
+    // Results of lazy_query::agg: values[i] is the result of aggregations[i], over the rows kept by the filters.
+    // count is the number of non-missing values of the column, the variance is the population variance
+    struct query_result {
+        size_t rows = 0;
+        std::vector<aggregation> aggregations;
+        std::vector<double> values;
+        // the correlation and covariance matrices of the requested columns, empty when none was requested. Every
+        // pair of columns is taken over the rows where both have a value
+        std::vector<std::string> correlation_columns;
+        Eigen::MatrixXd correlation;
+        Eigen::MatrixXd covariance;
+
+        // the value of an aggregation of the query, throws std::out_of_range when it was not requested
+        double get(const std::string& column, aggregate statistic) const;
+    };
+
+    // Element-wise transforms by name ("log", "log10", "log1p", "exp", "sqrt", "abs", "square"), for callers
+    // that cannot pass a C++ function (Python); throws std::invalid_argument for other names
+    std::function<double(double)> named_transform(const std::string& name);
+    // value <op> threshold, op being one of "<", "<=", ">", ">=", "==", "!="
+    std::function<bool(double)> comparison(const std::string& op, double threshold);
+
+    // A lazy plan over the rows of a dataset: map and filter steps are recorded, nothing is computed until a
+    // terminal call (agg, correlation_matrix, regress, count, collect...). The terminal call then runs every
+    // step and the aggregation in a single scan of the columns it needs, in chunks of rows that stay in the
+    // cache, one chunk per task on `threads` threads (0 for one per hardware thread). The functions given to
+    // map and filter must then be safe to call from several threads at once, threads = 1 runs the scan on the
+    // calling thread.
+    //
+    // Maps apply to the non-missing values of the rows still kept, filters remove the rows whose value is
+    // missing or fails the predicate, in the order of the steps. Queries share their steps, so building
+    // variants of a query is cheap. The dataset must outlive the query and not change while a terminal call runs
+    class lazy_query {
+    public:
+        explicit lazy_query(dataset& source);
+
+        lazy_query map(const std::string& column_name, std::function<double(double)> func) const;
+        lazy_query filter(const std::string& column_name, std::function<bool(double)> predicate) const;
+
+        // the aggregations and the correlation matrix of correlation_columns (see dataset::get_correlation_matrix)
+        // over the rows kept by the filters, computed in the same scan
+        query_result agg(const std::vector<aggregation>& aggregations, const std::vector<std::string>& correlation_columns = {},
+                         size_t threads = 0) const;
+        // the correlation matrix of the given numerical columns, all of them when empty
+        Eigen::MatrixXd correlation_matrix(std::vector<std::string> column_names = {}, size_t threads = 0) const;
+        // the (population) covariance matrix of the given numerical columns, all of them when empty
+        Eigen::MatrixXd covariance_matrix(std::vector<std::string> column_names = {}, size_t threads = 0) const;
+        // means and scatter matrix of the given numerical columns, over the kept rows where all of them have a value
+        scatter_accumulator scatter(const std::vector<std::string>& column_names, size_t threads = 0) const;
+        // least squares fit of target on predictors with an intercept, over the same rows (see regression.hpp)
+        regression_result regress(const std::string& target, const std::vector<std::string>& predictors, size_t threads = 0) const;
+        // number of rows kept by the filters
+        size_t count(size_t threads = 0) const;
+        // Applies the plan to the dataset: mapped columns are rewritten and filtered rows removed, as
+        // dataset::map_column and dataset::filter_rows (which run through this) would do step by step
+        void collect(size_t threads = 0);
+
+    private:
+        struct step {
+            bool is_map;
+            int column;
+            std::function<double(double)> transform;
+            std::function<bool(double)> predicate;
+        };
+
+        // the values of the needed columns for the rows [first, first + size) of the dataset, after the steps
+        struct chunk {
+            size_t index;
+            size_t first;
+            size_t size;
+            // by column index, null for the columns that are not needed
+            std::vector<const double*> values;
+            std::vector<char> keep;
+        };
+
+        dataset* source;
+        std::vector<std::shared_ptr<const step>> steps;
+
+        // runs the steps on every chunk of rows, then visit(const chunk&), with the chunks of several tasks at once
+        template <typename Visit>
+        void scan(const std::vector<int>& needed_columns, size_t threads, Visit visit) const;
+        size_t chunk_count() const;
+    };
+}
+
+#endif
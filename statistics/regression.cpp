@@ -0,0 +1,125 @@
+#include "regression.hpp"
+#include "profiling.hpp"
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <cmath>
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        // below this reciprocal condition number of the scaled normal equations, LDLT gives way to a
+        // rank-revealing LU
+        constexpr double min_rcond = 1e-10;
+    }
+
+    scatter_accumulator::scatter_accumulator(size_t variables)
+            : mean_values(Eigen::VectorXd::Zero(static_cast<Eigen::Index>(variables))),
+              scatter_values(Eigen::MatrixXd::Zero(static_cast<Eigen::Index>(variables), static_cast<Eigen::Index>(variables))) {}
+
+    void scatter_accumulator::add(const Eigen::MatrixXd& block) {
+        if (block.rows() == 0) return;
+        if (static_cast<size_t>(block.cols()) != variables()) {
+            throw std::invalid_argument("The block must have one column per variable");
+        }
+
+        scatter_accumulator partial(variables());
+        partial.observations = static_cast<size_t>(block.rows());
+        partial.mean_values = block.colwise().mean().transpose();
+        Eigen::MatrixXd centered = block.rowwise() - partial.mean_values.transpose();
+        partial.scatter_values.selfadjointView<Eigen::Lower>().rankUpdate(centered.transpose());
+        partial.scatter_values = partial.scatter_values.selfadjointView<Eigen::Lower>();
+        merge(partial);
+    }
+
+    void scatter_accumulator::merge(const scatter_accumulator& other) {
+        if (other.observations == 0) return;
+        if (observations == 0) {
+            *this = other;
+            return;
+        }
+        if (other.variables() != variables()) {
+            throw std::invalid_argument("Cannot merge scatter matrices of different variables");
+        }
+
+        // the update of Chan et al. for the means and the products of the deviations
+        double total = static_cast<double>(observations + other.observations);
+        Eigen::VectorXd delta = other.mean_values - mean_values;
+        scatter_values += other.scatter_values +
+                          delta * delta.transpose() * (static_cast<double>(observations) * static_cast<double>(other.observations) / total);
+        mean_values += delta * (static_cast<double>(other.observations) / total);
+        observations += other.observations;
+    }
+
+    Eigen::MatrixXd scatter_accumulator::covariance() const {
+        if (observations == 0) {
+            throw std::runtime_error("Cannot compute covariance of an empty set of observations");
+        }
+        return scatter_values / static_cast<double>(observations);
+    }
+
+    regression_result fit_least_squares(const scatter_accumulator& data, const std::vector<std::string>& predictors) {
+        SCITOOL_PROFILE_SCOPE("regression.fit");
+        auto p = static_cast<Eigen::Index>(predictors.size());
+        if (predictors.empty() || data.variables() != predictors.size() + 1) {
+            throw std::invalid_argument("A regression needs at least one predictor and the target as last variable");
+        }
+        if (data.count() <= predictors.size() + 1) {
+            throw std::runtime_error("Not enough complete rows to fit " + std::to_string(predictors.size()) + " predictors and an intercept");
+        }
+
+        const Eigen::MatrixXd& scatter = data.scatter();
+        Eigen::MatrixXd sxx = scatter.topLeftCorner(p, p);
+        Eigen::VectorXd sxy = scatter.col(p).head(p);
+        double syy = scatter(p, p);
+
+        // scaled to unit diagonal, the conditioning no longer depends on the units of the predictors
+        Eigen::VectorXd scale = sxx.diagonal().cwiseSqrt();
+        for (Eigen::Index i = 0; i < p; ++i) {
+            if (!(scale(i) > 0.0)) {
+                throw std::runtime_error("Predictor '" + predictors[static_cast<size_t>(i)] + "' is constant over the complete rows");
+            }
+        }
+        Eigen::MatrixXd scaled = scale.cwiseInverse().asDiagonal() * sxx * scale.cwiseInverse().asDiagonal();
+
+        Eigen::MatrixXd inverse;
+        Eigen::LDLT<Eigen::MatrixXd> ldlt(scaled);
+        // an exactly singular matrix still factors, with a zero pivot that the rcond estimate can miss
+        if (ldlt.info() == Eigen::Success && ldlt.vectorD().minCoeff() > min_rcond * ldlt.vectorD().maxCoeff() &&
+            ldlt.rcond() > min_rcond) {
+            inverse = ldlt.solve(Eigen::MatrixXd::Identity(p, p));
+        } else {
+            Eigen::FullPivLU<Eigen::MatrixXd> lu(scaled);
+            if (lu.rank() < p) {
+                throw std::runtime_error("The predictors are collinear");
+            }
+            inverse = lu.inverse();
+        }
+        // inverse of sxx, back in the units of the predictors
+        inverse = scale.cwiseInverse().asDiagonal() * inverse * scale.cwiseInverse().asDiagonal();
+
+        Eigen::VectorXd slopes = inverse * sxy;
+        const Eigen::VectorXd& means = data.means();
+        auto n = static_cast<double>(data.count());
+        double residual = std::max(0.0, syy - slopes.dot(sxy));
+        double degrees_of_freedom = n - static_cast<double>(p) - 1.0;
+        double sigma2 = residual / degrees_of_freedom;
+
+        regression_result result;
+        result.terms.push_back("intercept");
+        result.terms.insert(result.terms.end(), predictors.begin(), predictors.end());
+        result.coefficients.resize(p + 1);
+        result.coefficients(0) = means(p) - slopes.dot(means.head(p));
+        result.coefficients.tail(p) = slopes;
+
+        result.standard_errors.resize(p + 1);
+        result.standard_errors(0) = std::sqrt(sigma2 * (1.0 / n + means.head(p).dot(inverse * means.head(p))));
+        result.standard_errors.tail(p) = (sigma2 * inverse.diagonal()).cwiseSqrt();
+
+        result.r_squared = syy > 0.0 ? 1.0 - residual / syy : 0.0;
+        result.adjusted_r_squared = 1.0 - (1.0 - result.r_squared) * (n - 1.0) / degrees_of_freedom;
+        result.residual_std_error = std::sqrt(sigma2);
+        result.observations = data.count();
+        return result;
+    }
+}
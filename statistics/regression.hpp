@@ -0,0 +1,65 @@
+#ifndef REGRESSION_HPP
+#define REGRESSION_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Eigen/Core"
+
+namespace scitool {
+
+    // Means and scatter matrix (sums of the products of the deviations from the means) of observations of
+    // several variables. Blocks of observations are centered on their own means, so that no precision is lost
+    // to large offsets, and accumulators of separate blocks (chunks, threads, files) merge exactly
+    class scatter_accumulator {
+    public:
+        explicit scatter_accumulator(size_t variables = 0);
+
+        // adds the rows of block, one observation per row and one variable per column, without missing values
+        void add(const Eigen::MatrixXd& block);
+        void merge(const scatter_accumulator& other);
+
+        size_t count() const {
+            return observations;
+        }
+
+        size_t variables() const {
+            return static_cast<size_t>(mean_values.size());
+        }
+
+        const Eigen::VectorXd& means() const {
+            return mean_values;
+        }
+
+        const Eigen::MatrixXd& scatter() const {
+            return scatter_values;
+        }
+
+        // population covariance matrix, as the variances of dataset
+        Eigen::MatrixXd covariance() const;
+
+    private:
+        size_t observations = 0;
+        Eigen::VectorXd mean_values;
+        Eigen::MatrixXd scatter_values;
+    };
+
+    // Ordinary least squares fit of a target on predictors, with an intercept. The coefficients and their
+    // standard errors start with the intercept, then follow the order of the predictors
+    struct regression_result {
+        std::vector<std::string> terms;
+        Eigen::VectorXd coefficients;
+        Eigen::VectorXd standard_errors;
+        double r_squared = 0.0;
+        double adjusted_r_squared = 0.0;
+        double residual_std_error = 0.0;
+        size_t observations = 0;
+    };
+
+    // Fits the last variable of data on the others (named by predictors). The centered normal equations are
+    // scaled to unit diagonal and solved with a LDLT factorization, or a full-pivoting (rank-revealing) LU when
+    // they are badly conditioned; collinear predictors throw std::runtime_error
+    regression_result fit_least_squares(const scatter_accumulator& data, const std::vector<std::string>& predictors);
+}
+
+#endif
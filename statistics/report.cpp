@@ -0,0 +1,460 @@
+#include "report.hpp"
+#include "dataset.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include "text_format.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+
+namespace scitool {
+
+    namespace {
+        constexpr int stat_precision = 6;
+        constexpr int correlation_precision = 3;
+
+        const char* statistic_key(report_statistic statistic) {
+            switch (statistic) {
+                case report_statistic::mean: return "mean";
+                case report_statistic::median: return "median";
+                case report_statistic::std_dev: return "std_dev";
+                case report_statistic::variance: return "variance";
+            }
+            return "";
+        }
+
+        const char* statistic_label(report_statistic statistic) {
+            switch (statistic) {
+                case report_statistic::mean: return "Mean";
+                case report_statistic::median: return "Median";
+                case report_statistic::std_dev: return "Standard Deviation";
+                case report_statistic::variance: return "Variance";
+            }
+            return "";
+        }
+
+        // Everything the report shows, computed before any formatting
+        struct report_data {
+            std::string file_name;
+            size_t rows = 0;
+            std::vector<std::string> numerical;
+            std::vector<std::string> categorical;
+            std::vector<report_statistic> statistics;
+            bool frequency_counts = true;
+            // values[column * statistics.size() + statistic]
+            std::vector<double> values;
+            std::vector<std::map<std::string, int>> frequencies;
+            // correlations of the reported numerical columns, empty when not requested
+            Eigen::MatrixXd correlation;
+
+            double value(size_t column, size_t statistic) const {
+                return values[column * statistics.size() + statistic];
+            }
+        };
+
+        // A numerical column without any value (every column of a file holding only its header) has no statistics,
+        // it is left out of the report rather than failing it
+        bool has_value(const dataset& ds, const std::string& name) {
+            const double* values = ds.get_numerical_data(name);
+            return std::any_of(values, values + ds.size(), [](double value) { return !std::isnan(value); });
+        }
+
+        report_data collect(dataset& ds, const report_options& options) {
+            report_data data;
+            data.file_name = ds.get_file_name();
+            data.rows = ds.size();
+            data.statistics = options.statistics;
+            data.frequency_counts = options.frequency_counts;
+
+            const auto& names = options.columns.empty() ? ds.get_column_names() : options.columns;
+            for (const auto& name : names) {
+                // is_categorical rejects the columns that do not exist
+                if (ds.is_categorical(name)) {
+                    if (options.frequency_counts) data.categorical.push_back(name);
+                } else if (has_value(ds, name)) {
+                    data.numerical.push_back(name);
+                }
+            }
+
+            // one task per numerical column and statistic, then one per categorical column
+            size_t stat_count = data.statistics.size();
+            size_t stat_tasks = data.numerical.size() * stat_count;
+            data.values.resize(stat_tasks);
+            data.frequencies.resize(data.categorical.size());
+            parallel_for(stat_tasks + data.categorical.size(), [&](size_t task) {
+                if (task >= stat_tasks) {
+                    data.frequencies[task - stat_tasks] = ds.get_frequency_count(data.categorical[task - stat_tasks]);
+                    return;
+                }
+
+                const auto& column = data.numerical[task / stat_count];
+                switch (data.statistics[task % stat_count]) {
+                    case report_statistic::mean: data.values[task] = ds.get_mean(column); break;
+                    case report_statistic::median: data.values[task] = ds.get_median(column); break;
+                    case report_statistic::std_dev: data.values[task] = ds.get_std_dev(column); break;
+                    case report_statistic::variance: data.values[task] = ds.get_variance(column); break;
+                }
+            }, options.threads);
+
+            if (options.correlation && !data.numerical.empty()) {
+                // the dataset computes the matrix of all its numerical columns, the reported ones are picked from it
+                Eigen::MatrixXd full = ds.get_correlation_matrix();
+                std::unordered_map<std::string, Eigen::Index> positions;
+                for (const auto& name : ds.get_numerical_column_names()) {
+                    positions.emplace(name, static_cast<Eigen::Index>(positions.size()));
+                }
+
+                auto count = static_cast<Eigen::Index>(data.numerical.size());
+                data.correlation.resize(count, count);
+                for (Eigen::Index i = 0; i < count; ++i) {
+                    for (Eigen::Index j = 0; j < count; ++j) {
+                        data.correlation(i, j) = full(positions.at(data.numerical[i]), positions.at(data.numerical[j]));
+                    }
+                }
+            }
+
+            return data;
+        }
+
+        // Appends to one growing buffer, numbers are written in place with std::to_chars
+        class report_buffer {
+        public:
+            report_buffer& operator<<(std::string_view text) {
+                out.append(text);
+                return *this;
+            }
+
+            report_buffer& operator<<(char c) {
+                out.push_back(c);
+                return *this;
+            }
+
+            // shortest representation that reads back to the same value
+            report_buffer& number(double value) {
+                append_number(out, value);
+                return *this;
+            }
+
+            // like a stream with setprecision(precision)
+            report_buffer& number(double value, int precision) {
+                char buffer[32];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, precision);
+                out.append(buffer, result.ptr);
+                return *this;
+            }
+
+            report_buffer& integer(long long value) {
+                char buffer[24];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                out.append(buffer, result.ptr);
+                return *this;
+            }
+
+            // right-aligns what func appends in a field of the given width, like std::setw
+            template <typename Func>
+            report_buffer& aligned_with(size_t width, Func func, char fill = ' ') {
+                size_t start = out.size();
+                func(*this);
+                size_t length = out.size() - start;
+                if (length < width) out.insert(start, width - length, fill);
+                return *this;
+            }
+
+            report_buffer& aligned(size_t width, std::string_view text, char fill = ' ') {
+                return aligned_with(width, [text](report_buffer& b) { b << text; }, fill);
+            }
+
+            report_buffer& repeat(char c, size_t count) {
+                out.append(count, c);
+                return *this;
+            }
+
+            std::string take() {
+                return std::move(out);
+            }
+
+        private:
+            std::string out;
+        };
+
+        void json_string(report_buffer& out, std::string_view text) {
+            out << '"' << json_escape(text) << '"';
+        }
+
+        void json_number(report_buffer& out, double value) {
+            // JSON has no NaN or infinity
+            if (std::isfinite(value)) out.number(value);
+            else out << "null";
+        }
+
+        void csv_field(report_buffer& out, std::string_view text) {
+            out << scitool::csv_field(text);
+        }
+
+        void markdown_cell(report_buffer& out, std::string_view text) {
+            for (char c : text) {
+                if (c == '|') out << '\\';
+                out << c;
+            }
+        }
+
+        // the layout written by output_statistics before the report formats were introduced, the
+        // sections that were not requested are left out
+        void format_text(report_buffer& out, const report_data& data) {
+            if (!data.statistics.empty()) {
+                out << "Numerical Data Statistics:\n";
+                for (size_t col = 0; col < data.numerical.size(); ++col) {
+                    out << data.numerical[col] << ":\n";
+                    for (size_t stat = 0; stat < data.statistics.size(); ++stat) {
+                        out << "  " << statistic_label(data.statistics[stat]) << ": ";
+                        out.number(data.value(col, stat), stat_precision) << '\n';
+                    }
+                }
+                out << '\n';
+            }
+
+            if (data.frequency_counts) {
+                out << "Categorical Data Frequency Counts:\n";
+                for (size_t col = 0; col < data.categorical.size(); ++col) {
+                    out << data.categorical[col] << ":\n";
+                    for (const auto& [value, count] : data.frequencies[col]) {
+                        out << "  " << value << ": ";
+                        out.integer(count) << '\n';
+                    }
+                }
+                out << "\n\n";
+            }
+            if (data.correlation.size() == 0) return;
+
+            // every cell is as wide as the name of its column plus a space, the labels as the longest name
+            std::vector<size_t> widths;
+            size_t label_width = 0;
+            for (const auto& name : data.numerical) {
+                widths.push_back(name.size() + 1);
+                label_width = std::max(label_width, name.size() + 1);
+            }
+            for (const auto& name : data.categorical) label_width = std::max(label_width, name.size() + 1);
+
+            auto separator = [&]() {
+                out.repeat('-', label_width) << '+';
+                for (size_t width : widths) out.repeat('-', width) << '+';
+                out << '\n';
+            };
+
+            out.aligned(label_width + 1, " |");
+            for (size_t col = 0; col < data.numerical.size(); ++col) {
+                out.aligned(widths[col], data.numerical[col]) << '|';
+            }
+            out << '\n';
+            separator();
+
+            for (size_t i = 0; i < data.numerical.size(); ++i) {
+                out.aligned(label_width, data.numerical[i]) << '|';
+                for (size_t j = 0; j < data.numerical.size(); ++j) {
+                    double value = data.correlation(static_cast<Eigen::Index>(i), static_cast<Eigen::Index>(j));
+                    out.aligned_with(widths[j], [value](report_buffer& b) { b.number(value, correlation_precision); }) << '|';
+                }
+                out << '\n';
+            }
+            separator();
+        }
+
+        // one record per value: column,statistic,key,value (key is the category or the other column)
+        void format_csv(report_buffer& out, const report_data& data) {
+            out << "column,statistic,key,value\n";
+            for (size_t col = 0; col < data.numerical.size(); ++col) {
+                for (size_t stat = 0; stat < data.statistics.size(); ++stat) {
+                    csv_field(out, data.numerical[col]);
+                    out << ',' << statistic_key(data.statistics[stat]) << ",,";
+                    out.number(data.value(col, stat)) << '\n';
+                }
+            }
+
+            for (size_t col = 0; col < data.categorical.size(); ++col) {
+                for (const auto& [value, count] : data.frequencies[col]) {
+                    csv_field(out, data.categorical[col]);
+                    out << ",frequency,";
+                    csv_field(out, value);
+                    out << ',';
+                    out.integer(count) << '\n';
+                }
+            }
+
+            for (Eigen::Index i = 0; i < data.correlation.rows(); ++i) {
+                for (Eigen::Index j = 0; j < data.correlation.cols(); ++j) {
+                    csv_field(out, data.numerical[static_cast<size_t>(i)]);
+                    out << ",correlation,";
+                    csv_field(out, data.numerical[static_cast<size_t>(j)]);
+                    out << ',';
+                    out.number(data.correlation(i, j)) << '\n';
+                }
+            }
+        }
+
+        void format_json(report_buffer& out, const report_data& data) {
+            out << "{\n  \"file\": ";
+            json_string(out, data.file_name);
+            out << ",\n  \"rows\": ";
+            out.integer(static_cast<long long>(data.rows));
+
+            out << ",\n  \"numerical\": {";
+            for (size_t col = 0; col < data.numerical.size(); ++col) {
+                out << (col == 0 ? "\n    " : ",\n    ");
+                json_string(out, data.numerical[col]);
+                out << ": {";
+                for (size_t stat = 0; stat < data.statistics.size(); ++stat) {
+                    out << (stat == 0 ? "\"" : ", \"") << statistic_key(data.statistics[stat]) << "\": ";
+                    json_number(out, data.value(col, stat));
+                }
+                out << '}';
+            }
+            out << (data.numerical.empty() ? "}" : "\n  }");
+
+            out << ",\n  \"categorical\": {";
+            for (size_t col = 0; col < data.categorical.size(); ++col) {
+                out << (col == 0 ? "\n    " : ",\n    ");
+                json_string(out, data.categorical[col]);
+                out << ": {";
+                bool first = true;
+                for (const auto& [value, count] : data.frequencies[col]) {
+                    if (!first) out << ", ";
+                    first = false;
+                    json_string(out, value);
+                    out << ": ";
+                    out.integer(count);
+                }
+                out << '}';
+            }
+            out << (data.categorical.empty() ? "}" : "\n  }");
+
+            if (data.correlation.size() != 0) {
+                out << ",\n  \"correlation\": {\"columns\": [";
+                for (size_t col = 0; col < data.numerical.size(); ++col) {
+                    if (col != 0) out << ", ";
+                    json_string(out, data.numerical[col]);
+                }
+                out << "], \"matrix\": [";
+                for (Eigen::Index i = 0; i < data.correlation.rows(); ++i) {
+                    out << (i == 0 ? "\n    [" : ",\n    [");
+                    for (Eigen::Index j = 0; j < data.correlation.cols(); ++j) {
+                        if (j != 0) out << ", ";
+                        json_number(out, data.correlation(i, j));
+                    }
+                    out << ']';
+                }
+                out << "\n  ]}";
+            }
+            out << "\n}\n";
+        }
+
+        void format_markdown(report_buffer& out, const report_data& data) {
+            if (!data.numerical.empty() && !data.statistics.empty()) {
+                out << "## Numerical data statistics\n\n| Column |";
+                for (auto statistic : data.statistics) out << ' ' << statistic_label(statistic) << " |";
+                out << "\n|---|";
+                for (size_t stat = 0; stat < data.statistics.size(); ++stat) out << "---:|";
+                out << '\n';
+                for (size_t col = 0; col < data.numerical.size(); ++col) {
+                    out << "| ";
+                    markdown_cell(out, data.numerical[col]);
+                    out << " |";
+                    for (size_t stat = 0; stat < data.statistics.size(); ++stat) {
+                        out << ' ';
+                        out.number(data.value(col, stat), stat_precision) << " |";
+                    }
+                    out << '\n';
+                }
+                out << '\n';
+            }
+
+            if (!data.categorical.empty()) {
+                out << "## Categorical data frequency counts\n\n| Column | Value | Count |\n|---|---|---:|\n";
+                for (size_t col = 0; col < data.categorical.size(); ++col) {
+                    for (const auto& [value, count] : data.frequencies[col]) {
+                        out << "| ";
+                        markdown_cell(out, data.categorical[col]);
+                        out << " | ";
+                        markdown_cell(out, value);
+                        out << " | ";
+                        out.integer(count) << " |\n";
+                    }
+                }
+                out << '\n';
+            }
+
+            if (data.correlation.size() != 0) {
+                out << "## Correlation matrix\n\n| |";
+                for (const auto& name : data.numerical) {
+                    out << ' ';
+                    markdown_cell(out, name);
+                    out << " |";
+                }
+                out << "\n|---|";
+                for (size_t col = 0; col < data.numerical.size(); ++col) out << "---:|";
+                out << '\n';
+                for (Eigen::Index i = 0; i < data.correlation.rows(); ++i) {
+                    out << "| ";
+                    markdown_cell(out, data.numerical[static_cast<size_t>(i)]);
+                    out << " |";
+                    for (Eigen::Index j = 0; j < data.correlation.cols(); ++j) {
+                        out << ' ';
+                        out.number(data.correlation(i, j), correlation_precision) << " |";
+                    }
+                    out << '\n';
+                }
+            }
+        }
+    }
+
+    report_format parse_report_format(const std::string& name) {
+        if (name == "text") return report_format::text;
+        if (name == "csv") return report_format::csv;
+        if (name == "json") return report_format::json;
+        if (name == "markdown" || name == "md") return report_format::markdown;
+        throw std::invalid_argument("Unknown report format: " + name);
+    }
+
+    report_statistic parse_report_statistic(const std::string& name) {
+        for (auto statistic : {report_statistic::mean, report_statistic::median, report_statistic::std_dev, report_statistic::variance}) {
+            if (name == statistic_key(statistic)) return statistic;
+        }
+        throw std::invalid_argument("Unknown statistic: " + name);
+    }
+
+    std::string format_report(dataset& ds, const report_options& options) {
+        SCITOOL_PROFILE_SCOPE("dataset.report");
+        report_data data = collect(ds, options);
+
+        report_buffer out;
+        switch (options.format) {
+            case report_format::text: format_text(out, data); break;
+            case report_format::csv: format_csv(out, data); break;
+            case report_format::json: format_json(out, data); break;
+            case report_format::markdown: format_markdown(out, data); break;
+        }
+        return out.take();
+    }
+
+    void write_report(dataset& ds, const std::string& output_file, const report_options& options) {
+        if (output_file == "-") {
+            std::string report = format_report(ds, options);
+            std::fwrite(report.data(), 1, report.size(), stdout);
+            std::fflush(stdout);
+            return;
+        }
+
+        std::ofstream out_file(output_file, std::ios::binary);
+        if (!out_file.is_open()) {
+            throw std::runtime_error("Unable to open file: " + output_file);
+        }
+
+        std::string report = format_report(ds, options);
+        out_file.write(report.data(), static_cast<std::streamsize>(report.size()));
+        if (!out_file) {
+            throw std::runtime_error("Unable to write file: " + output_file);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef REPORT_HPP
+#define REPORT_HPP
+
+#include <string>
+#include <vector>
+
+namespace scitool {
+
+    class dataset;
+
+    enum class report_format { text, csv, json, markdown };
+    enum class report_statistic { mean, median, std_dev, variance };
+
+    // "text", "csv", "json" or "markdown" (also "md")
+    report_format parse_report_format(const std::string& name);
+    // "mean", "median", "std_dev" or "variance"
+    report_statistic parse_report_statistic(const std::string& name);
+
+    struct report_options {
+        report_format format = report_format::text;
+        // columns to report, numerical or categorical, in the order of the dataset when empty. Numerical columns
+        // without any value are left out
+        std::vector<std::string> columns;
+        // statistics of the numerical columns, in the order they are reported
+        std::vector<report_statistic> statistics{report_statistic::mean, report_statistic::median,
+                                                 report_statistic::std_dev, report_statistic::variance};
+        bool frequency_counts = true;
+        // correlation matrix of the reported numerical columns
+        bool correlation = true;
+        // threads computing the statistics, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    // The statistics of the report are computed in parallel, one task per column and statistic, and
+    // cached in the dataset. Numbers are formatted with std::to_chars into a single buffer: the text and
+    // Markdown reports round them like the stream defaults (6 significant digits, 3 for correlations),
+    // CSV and JSON keep the shortest representation that reads back to the same double
+    std::string format_report(dataset& ds, const report_options& options = {});
+
+    // formats the report and writes it with a single call, to the standard output when output_file is "-"
+    void write_report(dataset& ds, const std::string& output_file, const report_options& options = {});
+}
+
+#endif
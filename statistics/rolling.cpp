@@ -0,0 +1,329 @@
+#include "rolling.hpp"
+#include "dataset.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        constexpr size_t absent = std::numeric_limits<size_t>::max();
+
+        // Runs acc over the rows: the value leaving the window is removed before the new one is added, and out[i]
+        // is acc.value(count) when the window holds at least min_periods values
+        template <typename Accumulator>
+        void run_window(const double* values, size_t n, size_t window, size_t min_periods, Accumulator acc, double* out) {
+            size_t count = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (window > 0 && i >= window && !std::isnan(values[i - window])) {
+                    acc.remove(values[i - window], i - window, --count);
+                }
+                if (!std::isnan(values[i])) acc.add(values[i], i, ++count);
+                out[i] = count > 0 && count >= min_periods ? acc.value(count) : std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+
+        struct count_accumulator {
+            void add(double, size_t, size_t) {}
+            void remove(double, size_t, size_t) {}
+            double value(size_t count) const {
+                return static_cast<double>(count);
+            }
+        };
+
+        // Neumaier's compensated sum: the low-order bits lost by every addition (or removal) are summed apart, so
+        // that the running sum does not drift over millions of updates
+        struct sum_accumulator {
+            bool mean;
+            double total = 0.0;
+            double compensation = 0.0;
+
+            void accumulate(double x) {
+                double t = total + x;
+                compensation += std::abs(total) >= std::abs(x) ? (total - t) + x : (x - t) + total;
+                total = t;
+            }
+
+            void add(double x, size_t, size_t) {
+                accumulate(x);
+            }
+
+            void remove(double x, size_t, size_t count) {
+                if (count == 0) total = compensation = 0.0;
+                else accumulate(-x);
+            }
+
+            double value(size_t count) const {
+                double sum = total + compensation;
+                return mean ? sum / static_cast<double>(count) : sum;
+            }
+        };
+
+        // Welford's update of the mean and of the sum of squared deviations, run backwards to remove a value. The
+        // values are shifted by the first one, so that a large offset does not eat the precision of the updates,
+        // and a window of equal values (the last `run` rows added) has a variance of exactly 0
+        struct variance_accumulator {
+            bool std_dev;
+            double shift = std::numeric_limits<double>::quiet_NaN();
+            double mean = 0.0;
+            double squares = 0.0;
+            double last = std::numeric_limits<double>::quiet_NaN();
+            size_t run = 0;
+
+            void add(double x, size_t, size_t count) {
+                if (std::isnan(shift)) shift = x;
+                run = x == last ? run + 1 : 1;
+                last = x;
+                x -= shift;
+                double delta = x - mean;
+                mean += delta / static_cast<double>(count);
+                squares += delta * (x - mean);
+            }
+
+            void remove(double x, size_t, size_t count) {
+                if (count == 0) {
+                    mean = squares = 0.0;
+                    return;
+                }
+                x -= shift;
+                double delta = x - mean;
+                mean -= delta / static_cast<double>(count);
+                squares -= delta * (x - mean);
+            }
+
+            double value(size_t count) const {
+                if (run >= count) return 0.0;
+                double variance = std::max(0.0, squares) / static_cast<double>(count);
+                return std_dev ? std::sqrt(variance) : variance;
+            }
+        };
+
+        // Monotonic deque of the rows of the window, their values decreasing (increasing for the minimum) from the
+        // front: the front is the extreme of the window, and every row enters and leaves the deque once. A ring of
+        // `capacity` rows holds it, as the deque never holds more rows than the window. Without a window (capacity 0)
+        // no row leaves, and the deque is only the extreme so far
+        struct extreme_accumulator {
+            bool largest;
+            bool cumulative;
+            const double* values;
+            std::vector<size_t> rows;
+            size_t front = 0;
+            size_t size = 0;
+
+            extreme_accumulator(bool largest, const double* values, size_t capacity)
+                    : largest(largest), cumulative(capacity == 0), values(values), rows(std::max<size_t>(1, capacity)) {}
+
+            size_t& at(size_t i) {
+                return rows[(front + i) % rows.size()];
+            }
+
+            void add(double x, size_t row, size_t) {
+                if (cumulative) {
+                    if (size == 0 || (largest ? x > values[rows[0]] : x < values[rows[0]])) rows[0] = row;
+                    size = 1;
+                    return;
+                }
+                while (size > 0 && (largest ? values[at(size - 1)] <= x : values[at(size - 1)] >= x)) --size;
+                at(size++) = row;
+            }
+
+            void remove(double, size_t row, size_t) {
+                if (size > 0 && at(0) == row) {
+                    front = (front + 1) % rows.size();
+                    --size;
+                }
+            }
+
+            double value(size_t) {
+                return values[at(0)];
+            }
+        };
+
+        // The values of the window split in two heaps, the lower half in a max-heap and the upper half in a
+        // min-heap, the lower one holding the extra value of an odd count. The heaps are addressable: the row in
+        // slot `row % capacity` knows its position, so the value leaving the window is removed in O(log window)
+        // instead of being left in the heap until it reaches the top
+        class median_accumulator {
+        public:
+            explicit median_accumulator(size_t capacity) : where(capacity, absent) {}
+
+            void add(double x, size_t row, size_t) {
+                size_t slot = row % where.size();
+                if (low.empty() || x <= low.front().value) push(false, {x, slot});
+                else push(true, {x, slot});
+                rebalance();
+            }
+
+            void remove(double, size_t row, size_t) {
+                size_t slot = row % where.size();
+                size_t code = where[slot];
+                erase(code & 1, code >> 1);
+                where[slot] = absent;
+                rebalance();
+            }
+
+            double value(size_t) const {
+                if (low.size() > high.size()) return low.front().value;
+                // the median of an even count is the mean of the middle two, as in dataset::get_median
+                return (low.front().value + high.front().value) / 2.0;
+            }
+
+        private:
+            struct entry {
+                double value;
+                size_t slot;
+            };
+
+            std::vector<entry> low;
+            std::vector<entry> high;
+            // position * 2 + (1 for the upper heap) of the value of every slot
+            std::vector<size_t> where;
+
+            std::vector<entry>& heap(bool upper) {
+                return upper ? high : low;
+            }
+
+            // a comes before b in its heap
+            static bool before(bool upper, const entry& a, const entry& b) {
+                return upper ? a.value < b.value : a.value > b.value;
+            }
+
+            void place(bool upper, size_t position, const entry& e) {
+                heap(upper)[position] = e;
+                where[e.slot] = position * 2 + (upper ? 1 : 0);
+            }
+
+            size_t sift_up(bool upper, size_t position) {
+                auto& h = heap(upper);
+                entry e = h[position];
+                while (position > 0 && before(upper, e, h[(position - 1) / 2])) {
+                    place(upper, position, h[(position - 1) / 2]);
+                    position = (position - 1) / 2;
+                }
+                place(upper, position, e);
+                return position;
+            }
+
+            void sift_down(bool upper, size_t position) {
+                auto& h = heap(upper);
+                entry e = h[position];
+                for (size_t child = 2 * position + 1; child < h.size(); child = 2 * position + 1) {
+                    if (child + 1 < h.size() && before(upper, h[child + 1], h[child])) ++child;
+                    if (!before(upper, h[child], e)) break;
+                    place(upper, position, h[child]);
+                    position = child;
+                }
+                place(upper, position, e);
+            }
+
+            void push(bool upper, const entry& e) {
+                heap(upper).push_back(e);
+                sift_up(upper, heap(upper).size() - 1);
+            }
+
+            entry erase(bool upper, size_t position) {
+                auto& h = heap(upper);
+                entry removed = h[position];
+                entry last = h.back();
+                h.pop_back();
+                if (position < h.size()) {
+                    place(upper, position, last);
+                    sift_down(upper, sift_up(upper, position));
+                }
+                return removed;
+            }
+
+            void rebalance() {
+                while (low.size() > high.size() + 1) push(true, erase(false, 0));
+                while (high.size() > low.size()) push(false, erase(true, 0));
+            }
+        };
+    }
+
+    void rolling_statistic(const double* values, size_t n, size_t window, size_t min_periods, aggregate statistic, double* out) {
+        // the rows held at once, every row for a cumulative statistic
+        size_t capacity = std::max<size_t>(1, window == 0 ? n : window);
+        switch (statistic) {
+            case aggregate::count:
+                return run_window(values, n, window, min_periods, count_accumulator{}, out);
+            case aggregate::sum:
+            case aggregate::mean:
+                return run_window(values, n, window, min_periods, sum_accumulator{statistic == aggregate::mean}, out);
+            case aggregate::variance:
+            case aggregate::std_dev:
+                return run_window(values, n, window, min_periods, variance_accumulator{statistic == aggregate::std_dev}, out);
+            case aggregate::min:
+            case aggregate::max:
+                return run_window(values, n, window, min_periods, extreme_accumulator(statistic == aggregate::max, values, window), out);
+            case aggregate::median:
+                return run_window(values, n, window, min_periods, median_accumulator(capacity), out);
+        }
+    }
+
+    rolling_window::rolling_window(const dataset& source, std::vector<std::string> column_names, size_t window, size_t min_periods)
+            : source(&source), column_names(std::move(column_names)), window(window), min_periods(min_periods) {
+        if (this->column_names.empty()) {
+            throw std::invalid_argument("At least one column is needed for rolling statistics");
+        }
+        if (window > 0 && min_periods > window) {
+            throw std::invalid_argument("The minimum number of values cannot exceed the window");
+        }
+        // checks that the columns exist and are numerical
+        for (const auto& name : this->column_names) source.get_numerical_data(name);
+    }
+
+    std::unique_ptr<dataset> rolling_window::count(size_t threads) const {
+        return apply(aggregate::count, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::sum(size_t threads) const {
+        return apply(aggregate::sum, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::mean(size_t threads) const {
+        return apply(aggregate::mean, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::variance(size_t threads) const {
+        return apply(aggregate::variance, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::std_dev(size_t threads) const {
+        return apply(aggregate::std_dev, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::min(size_t threads) const {
+        return apply(aggregate::min, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::max(size_t threads) const {
+        return apply(aggregate::max, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::median(size_t threads) const {
+        return apply(aggregate::median, threads);
+    }
+
+    std::unique_ptr<dataset> rolling_window::apply(aggregate statistic, size_t threads) const {
+        SCITOOL_PROFILE_SCOPE("dataset.rolling");
+        std::set<int> num_cols;
+        for (size_t col = 0; col < column_names.size(); ++col) num_cols.insert(static_cast<int>(col));
+        std::unique_ptr<dataset> result(new dataset(column_names, std::move(num_cols), {}));
+
+        // the arena is not thread-safe: the columns are allocated first, then computed in parallel
+        size_t rows = source->size();
+        for (auto& column : result->column_values) column.numbers.resize(rows);
+        parallel_for(column_names.size(), [&](size_t col) {
+            rolling_statistic(source->get_numerical_data(column_names[col]), rows, window, min_periods, statistic,
+                              result->column_values[col].numbers.data());
+        }, threads);
+
+        result->row_count = rows;
+        result->file_name = source->file_name;
+        return result;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef ROLLING_HPP
+#define ROLLING_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "lazy_query.hpp"
+
+namespace scitool {
+
+    class dataset;
+
+    // Writes to out[i] the statistic of the non-missing values among values[i - window + 1 .. i] (values[0 .. i]
+    // when window is 0), or NaN when there are fewer than min_periods of them. count, sum and mean keep running
+    // sums with Neumaier compensation, variance (population) and std_dev a running Welford update, min and max
+    // a monotonic deque and median two heaps of the window, so every statistic takes O(n) time (O(n log window)
+    // for the median) and O(window) memory
+    void rolling_statistic(const double* values, size_t n, size_t window, size_t min_periods, aggregate statistic, double* out);
+
+    // Rolling (or cumulative, when window is 0) statistics of numerical columns of a dataset, ordered by row.
+    // Every call computes a new dataset holding one column per requested column, with the same name and as many
+    // rows, the columns being computed in parallel on `threads` threads (0 for one per hardware thread). The
+    // dataset must outlive the window and not change while a call runs
+    class rolling_window {
+    public:
+        rolling_window(const dataset& source, std::vector<std::string> column_names, size_t window, size_t min_periods);
+
+        std::unique_ptr<dataset> count(size_t threads = 0) const;
+        std::unique_ptr<dataset> sum(size_t threads = 0) const;
+        std::unique_ptr<dataset> mean(size_t threads = 0) const;
+        std::unique_ptr<dataset> variance(size_t threads = 0) const;
+        std::unique_ptr<dataset> std_dev(size_t threads = 0) const;
+        std::unique_ptr<dataset> min(size_t threads = 0) const;
+        std::unique_ptr<dataset> max(size_t threads = 0) const;
+        std::unique_ptr<dataset> median(size_t threads = 0) const;
+        std::unique_ptr<dataset> apply(aggregate statistic, size_t threads = 0) const;
+
+    private:
+        const dataset* source;
+        std::vector<std::string> column_names;
+        size_t window;
+        size_t min_periods;
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "sorting.hpp"
+#include "parallel.hpp"
+#include "profiling.hpp"
+#include <stdexcept>
+
+namespace scitool {
+
+    namespace {
+        constexpr unsigned digit_bits = 11;
+        constexpr size_t bucket_count = size_t(1) << digit_bits;
+        constexpr std::uint64_t digit_mask = bucket_count - 1;
+    }
+
+    void radix_sort(std::vector<std::uint64_t>& keys, std::vector<size_t>& rows, size_t threads) {
+        SCITOOL_PROFILE_SCOPE("dataset.radix_sort");
+        if (keys.size() != rows.size()) {
+            throw std::invalid_argument("Every key needs a row");
+        }
+
+        size_t n = keys.size();
+        size_t slices = slice_count(n, threads);
+
+        std::vector<std::uint64_t> key_buffer(n);
+        std::vector<size_t> row_buffer(n);
+        // counts[t * bucket_count + digit], then the position where slice t writes its next key of the digit
+        std::vector<size_t> counts(slices * bucket_count);
+
+        for (unsigned shift = 0; shift < 64; shift += digit_bits) {
+            std::fill(counts.begin(), counts.end(), 0);
+            parallel_slices(n, slices, [&](size_t t, size_t begin, size_t end) {
+                size_t* count = counts.data() + t * bucket_count;
+                for (size_t i = begin; i < end; ++i) {
+                    ++count[(keys[i] >> shift) & digit_mask];
+                }
+            });
+
+            // the digits are ordered first, then the slices within a digit, which keeps the sort stable
+            size_t position = 0;
+            bool single_digit = false;
+            for (size_t digit = 0; digit < bucket_count; ++digit) {
+                size_t digit_total = 0;
+                for (size_t t = 0; t < slices; ++t) {
+                    size_t count = counts[t * bucket_count + digit];
+                    counts[t * bucket_count + digit] = position;
+                    position += count;
+                    digit_total += count;
+                }
+                if (digit_total == n) single_digit = true;
+            }
+            if (single_digit) continue;
+
+            parallel_slices(n, slices, [&](size_t t, size_t begin, size_t end) {
+                size_t* next = counts.data() + t * bucket_count;
+                for (size_t i = begin; i < end; ++i) {
+                    size_t target = next[(keys[i] >> shift) & digit_mask]++;
+                    key_buffer[target] = keys[i];
+                    row_buffer[target] = rows[i];
+                }
+            });
+            keys.swap(key_buffer);
+            rows.swap(row_buffer);
+        }
+    }
+}
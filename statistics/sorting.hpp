@@ -0,0 +1,32 @@
+#ifndef SORTING_HPP
+#define SORTING_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace scitool {
+
+    // Key with the order of the doubles (-inf first, +inf last) for an unsigned integer sort, NaN
+    // (a missing value) sorts after every number
+    inline std::uint64_t order_key(double value) {
+        if (std::isnan(value)) return std::numeric_limits<std::uint64_t>::max();
+
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        // negative numbers have every bit flipped (larger magnitudes first), positive ones the sign bit set
+        const std::uint64_t sign = std::uint64_t(1) << 63;
+        return (bits & sign) ? ~bits : bits | sign;
+    }
+
+    // Sorts keys in increasing order, stably, applying the same permutation to rows (keys[i] is the key of
+    // rows[i]). This is a least significant digit radix sort on 11-bit digits, where the passes on digits
+    // that every key shares are skipped, so small key ranges cost fewer passes. Large arrays are split
+    // between `threads` threads (0 for one per hardware thread) that count and scatter their own slice
+    void radix_sort(std::vector<std::uint64_t>& keys, std::vector<size_t>& rows, size_t threads = 0);
+}
+
+#endif
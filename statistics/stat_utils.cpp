@@ -109,4 +109,100 @@ namespace scitool {
 
         return sum / static_cast<double>(count);
     }
-}
\ No newline at end of file
+
+    template<typename T>
+    static double mean(const T* data, size_t n) {
+        if (n == 0) {
+            throw std::runtime_error("Cannot compute mean of an empty vector");
+        }
+
+        double sum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isnan(data[i])) {
+                sum += static_cast<double>(data[i]);
+                ++count;
+            }
+        }
+
+        if (count == 0) {
+            throw std::runtime_error("Cannot compute mean with all values missing");
+        }
+
+        return sum / static_cast<double>(count);
+    }
+
+    template<typename T>
+    static double variance(const T* data, size_t n) {
+        if (n == 0) {
+            throw std::runtime_error("Cannot compute variance of an empty vector");
+        }
+
+        double data_mean = scitool::mean(data, n);
+        double sq_sum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isnan(data[i])) {
+                double difference = static_cast<double>(data[i]) - data_mean;
+                sq_sum += difference * difference;
+                ++count;
+            }
+        }
+
+        return sq_sum / static_cast<double>(count);
+    }
+
+    template<typename T>
+    static double std_dev(const T* data, size_t n) {
+        if (n == 0) {
+            throw std::runtime_error("Cannot compute standard deviation of an empty vector");
+        }
+
+        return std::sqrt(scitool::variance(data, n));
+    }
+
+    template<typename T>
+    static double median(const T* data, size_t n) {
+        thread_local std::vector<T> values;
+        values.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (!std::isnan(data[i])) values.push_back(data[i]);
+        }
+
+        if (values.empty()) {
+            throw std::runtime_error("Cannot compute median of an empty or fully non-engaged optional vector");
+        }
+
+        // only the middle elements need to be in place, a selection is enough
+        size_t mid = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid), values.end());
+        double upper = values[mid];
+        if (values.size() % 2 != 0) return upper;
+
+        double lower = *std::max_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid));
+        return (lower + upper) / 2.0;
+    }
+
+    template<typename T>
+    static double correlation(const T* data1, const T* data2, size_t n) {
+        if (n == 0) {
+            throw std::runtime_error("Cannot compute correlation of vectors with unequal size or empty vectors");
+        }
+
+        return scitool::correlation(data1, data2, n, scitool::mean(data1, n), scitool::mean(data2, n));
+    }
+
+    template<typename T>
+    static double correlation(const T* data1, const T* data2, size_t n, double mean1, double mean2) {
+        double sum_xx = 0, sum_yy = 0, sum_xy = 0;
+
+        for (size_t i = 0; i < n; ++i) {
+            if (std::isnan(data1[i]) || std::isnan(data2[i])) continue;
+            sum_xx += (data1[i] - mean1) * (data1[i] - mean1);
+            sum_yy += (data2[i] - mean2) * (data2[i] - mean2);
+            sum_xy += (data1[i] - mean1) * (data2[i] - mean2);
+        }
+
+        return sum_xy / (std::sqrt(sum_xx) * std::sqrt(sum_yy));
+    }
+}
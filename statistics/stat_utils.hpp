@@ -27,6 +27,27 @@ namespace scitool {
     template<typename T>
     static double mean(const std::vector<std::optional<T>>& data);
 
+    // Overloads over n contiguous values, where NaN marks a missing value (the layout of the dataset columns)
+    template<typename T>
+    static double mean(const T* data, size_t n);
+
+    template<typename T>
+    static double variance(const T* data, size_t n);
+
+    template<typename T>
+    static double std_dev(const T* data, size_t n);
+
+    // the non-missing values are copied to a buffer owned by the calling thread, reused by the next calls
+    template<typename T>
+    static double median(const T* data, size_t n);
+
+    template<typename T>
+    static double correlation(const T* data1, const T* data2, size_t n);
+
+    // same, with the means of the two columns already known (e.g. when correlating every pair of many columns)
+    template<typename T>
+    static double correlation(const T* data1, const T* data2, size_t n, double mean1, double mean2);
+
 } // scitool
 
 #endif //STATS_HPP